@@ -101,6 +101,7 @@ static char* _wintitle_autocomplete(ProfWin* window, const char* const input, gb
 static char* _inpblock_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 static char* _time_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 static char* _receipts_autocomplete(ProfWin* window, const char* const input, gboolean previous);
+static char* _csi_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 static char* _reconnect_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 static char* _help_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 static char* _wins_autocomplete(ProfWin* window, const char* const input, gboolean previous);
@@ -134,12 +135,15 @@ static char* _lastactivity_autocomplete(ProfWin* window, const char* const input
 static char* _intype_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 static char* _mood_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 static char* _strophe_autocomplete(ProfWin* window, const char* const input, gboolean previous);
+static char* _perf_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 static char* _adhoc_cmd_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 static char* _vcard_autocomplete(ProfWin* window, const char* const input, gboolean previous);
+static char* _xmlconsole_autocomplete(ProfWin* window, const char* const input, gboolean previous);
 
 static char* _script_autocomplete_func(const char* const prefix, gboolean previous, void* context);
 
 static char* _cmd_ac_complete_params(ProfWin* window, const char* const input, gboolean previous);
+static void _cmd_ac_refresh_dynamic(void);
 
 static Autocomplete commands_ac;
 static Autocomplete who_room_ac;
@@ -231,6 +235,7 @@ static Autocomplete time_format_ac;
 static Autocomplete resource_ac;
 static Autocomplete inpblock_ac;
 static Autocomplete receipts_ac;
+static Autocomplete csi_ac;
 static Autocomplete reconnect_ac;
 #ifdef HAVE_LIBGPGME
 static Autocomplete pgp_ac;
@@ -286,6 +291,8 @@ static Autocomplete mood_type_ac;
 static Autocomplete strophe_ac;
 static Autocomplete strophe_sm_ac;
 static Autocomplete strophe_verbosity_ac;
+static Autocomplete perf_ac;
+static Autocomplete perf_log_ac;
 static Autocomplete adhoc_cmd_ac;
 static Autocomplete lastactivity_ac;
 static Autocomplete vcard_ac;
@@ -296,6 +303,9 @@ static Autocomplete vcard_name_ac;
 static Autocomplete vcard_set_param_ac;
 static Autocomplete vcard_togglable_param_ac;
 static Autocomplete vcard_address_type_ac;
+static Autocomplete xmlconsole_ac;
+static Autocomplete xmlconsole_filter_ac;
+static Autocomplete xmlconsole_type_ac;
 
 static Autocomplete* all_acs[] = {
     &commands_ac,
@@ -387,6 +397,7 @@ static Autocomplete* all_acs[] = {
     &resource_ac,
     &inpblock_ac,
     &receipts_ac,
+    &csi_ac,
     &reconnect_ac,
 #ifdef HAVE_LIBGPGME
     &pgp_ac,
@@ -438,6 +449,8 @@ static Autocomplete* all_acs[] = {
     &strophe_ac,
     &strophe_sm_ac,
     &strophe_verbosity_ac,
+    &perf_ac,
+    &perf_log_ac,
     &adhoc_cmd_ac,
     &lastactivity_ac,
     &vcard_ac,
@@ -448,6 +461,9 @@ static Autocomplete* all_acs[] = {
     &vcard_set_param_ac,
     &vcard_togglable_param_ac,
     &vcard_address_type_ac,
+    &xmlconsole_ac,
+    &xmlconsole_filter_ac,
+    &xmlconsole_type_ac,
 };
 
 static GHashTable* ac_funcs = NULL;
@@ -880,6 +896,7 @@ cmd_ac_init(void)
     autocomplete_add(rooms_cache_ac, "on");
     autocomplete_add(rooms_cache_ac, "off");
     autocomplete_add(rooms_cache_ac, "clear");
+    autocomplete_add(rooms_cache_ac, "ttl");
 
     autocomplete_add(affiliation_ac, "owner");
     autocomplete_add(affiliation_ac, "admin");
@@ -961,6 +978,10 @@ cmd_ac_init(void)
     autocomplete_add(receipts_ac, "send");
     autocomplete_add(receipts_ac, "request");
 
+    autocomplete_add(csi_ac, "on");
+    autocomplete_add(csi_ac, "off");
+    autocomplete_add(csi_ac, "focus");
+
     autocomplete_add(reconnect_ac, "now");
 
 #ifdef HAVE_LIBGPGME
@@ -1180,6 +1201,13 @@ cmd_ac_init(void)
     autocomplete_add(strophe_verbosity_ac, "2");
     autocomplete_add(strophe_verbosity_ac, "3");
 
+    autocomplete_add(perf_ac, "on");
+    autocomplete_add(perf_ac, "off");
+    autocomplete_add(perf_ac, "reset");
+    autocomplete_add(perf_ac, "log");
+
+    autocomplete_add(perf_log_ac, "off");
+
     autocomplete_add(mood_ac, "set");
     autocomplete_add(mood_ac, "clear");
     autocomplete_add(mood_ac, "on");
@@ -1343,6 +1371,17 @@ cmd_ac_init(void)
     autocomplete_add(vcard_address_type_ac, "domestic");
     autocomplete_add(vcard_address_type_ac, "international");
 
+    autocomplete_add(xmlconsole_ac, "filter");
+    autocomplete_add(xmlconsole_ac, "pretty");
+
+    autocomplete_add(xmlconsole_filter_ac, "type");
+    autocomplete_add(xmlconsole_filter_ac, "jid");
+    autocomplete_add(xmlconsole_filter_ac, "clear");
+
+    autocomplete_add(xmlconsole_type_ac, "message");
+    autocomplete_add(xmlconsole_type_ac, "presence");
+    autocomplete_add(xmlconsole_type_ac, "iq");
+
     if (ac_funcs != NULL)
         g_hash_table_destroy(ac_funcs);
     ac_funcs = g_hash_table_new(g_str_hash, g_str_equal);
@@ -1388,9 +1427,11 @@ cmd_ac_init(void)
     g_hash_table_insert(ac_funcs, "/ox", _ox_autocomplete);
     g_hash_table_insert(ac_funcs, "/pgp", _pgp_autocomplete);
 #endif
+    g_hash_table_insert(ac_funcs, "/perf", _perf_autocomplete);
     g_hash_table_insert(ac_funcs, "/plugins", _plugins_autocomplete);
     g_hash_table_insert(ac_funcs, "/presence", _presence_autocomplete);
     g_hash_table_insert(ac_funcs, "/receipts", _receipts_autocomplete);
+    g_hash_table_insert(ac_funcs, "/csi", _csi_autocomplete);
     g_hash_table_insert(ac_funcs, "/reconnect", _reconnect_autocomplete);
     g_hash_table_insert(ac_funcs, "/resource", _resource_autocomplete);
     g_hash_table_insert(ac_funcs, "/role", _role_autocomplete);
@@ -1415,6 +1456,7 @@ cmd_ac_init(void)
     g_hash_table_insert(ac_funcs, "/win", _win_autocomplete);
     g_hash_table_insert(ac_funcs, "/wins", _wins_autocomplete);
     g_hash_table_insert(ac_funcs, "/wintitle", _wintitle_autocomplete);
+    g_hash_table_insert(ac_funcs, "/xmlconsole", _xmlconsole_autocomplete);
 }
 
 void
@@ -1545,6 +1587,8 @@ char*
 cmd_ac_complete(ProfWin* window, const char* const input, gboolean previous)
 {
     char* found = NULL;
+    _cmd_ac_refresh_dynamic();
+
     // autocomplete command
     if ((strncmp(input, "/", 1) == 0) && (!strchr(input, ' '))) {
         found = autocomplete_complete(commands_ac, input, TRUE, previous);
@@ -1558,39 +1602,22 @@ cmd_ac_complete(ProfWin* window, const char* const input, gboolean previous)
 }
 
 void
-cmd_ac_reset(ProfWin* window)
+cmd_ac_reset(void)
 {
-    jabber_conn_status_t conn_status = connection_get_status();
-    if (conn_status == JABBER_CONNECTED) {
-        roster_reset_search_attempts();
+    autocomplete_reset_all();
+}
 
-        if (window->type == WIN_CHAT) {
-            ProfChatWin* chatwin = (ProfChatWin*)window;
-            assert(chatwin->memcheck == PROFCHATWIN_MEMCHECK);
-            PContact contact = roster_get_contact(chatwin->barejid);
-            if (contact) {
-                p_contact_resource_ac_reset(contact);
-            }
-        }
+// The completers below are filled from the file system, drop them once per
+// completion session so they pick up new themes, plugins and scripts
+static void
+_cmd_ac_refresh_dynamic(void)
+{
+    static guint generation = 0;
+    if (generation == autocomplete_generation()) {
+        return;
     }
+    generation = autocomplete_generation();
 
-    muc_invites_reset_ac();
-    muc_confserver_reset_ac();
-    accounts_reset_all_search();
-    accounts_reset_enabled_search();
-    tlscerts_reset_ac();
-    prefs_reset_boolean_choice();
-    presence_reset_sub_request_search();
-#ifdef HAVE_LIBGPGME
-    p_gpg_autocomplete_key_reset();
-#endif
-#ifdef HAVE_OMEMO
-    omemo_fingerprint_autocomplete_reset();
-#endif
-    size_t n;
-    for (n = ARRAY_SIZE(all_acs); n > 0; --n) {
-        autocomplete_reset(*(all_acs[n - 1]));
-    }
     if (theme_load_ac) {
         autocomplete_free(theme_load_ac);
         theme_load_ac = NULL;
@@ -1611,28 +1638,6 @@ cmd_ac_reset(ProfWin* window)
         autocomplete_free(script_show_ac);
         script_show_ac = NULL;
     }
-
-    if (window->type == WIN_MUC) {
-        ProfMucWin* mucwin = (ProfMucWin*)window;
-        assert(mucwin->memcheck == PROFMUCWIN_MEMCHECK);
-        muc_autocomplete_reset(mucwin->roomjid);
-        muc_jid_autocomplete_reset(mucwin->roomjid);
-    }
-
-    if (window->type == WIN_CONFIG) {
-        ProfConfWin* confwin = (ProfConfWin*)window;
-        assert(confwin->memcheck == PROFCONFWIN_MEMCHECK);
-        if (confwin->form) {
-            form_reset_autocompleters(confwin->form);
-        }
-    }
-
-    bookmark_autocomplete_reset();
-    blocked_ac_reset();
-    prefs_reset_room_trigger_ac();
-    win_reset_search_attempts();
-    win_close_reset_search_attempts();
-    plugins_reset_autocomplete();
 }
 
 void
@@ -3332,6 +3337,21 @@ _receipts_autocomplete(ProfWin* window, const char* const input, gboolean previo
     return result;
 }
 
+static char*
+_csi_autocomplete(ProfWin* window, const char* const input, gboolean previous)
+{
+    char* result = NULL;
+
+    result = autocomplete_param_with_func(input, "/csi focus", prefs_autocomplete_boolean_choice, previous, NULL);
+    if (result) {
+        return result;
+    }
+
+    result = autocomplete_param_with_ac(input, "/csi", csi_ac, TRUE, previous);
+
+    return result;
+}
+
 static char*
 _reconnect_autocomplete(ProfWin* window, const char* const input, gboolean previous)
 {
@@ -4263,6 +4283,19 @@ _strophe_autocomplete(ProfWin* window, const char* const input, gboolean previou
     return autocomplete_param_with_ac(input, "/strophe", strophe_ac, FALSE, previous);
 }
 
+static char*
+_perf_autocomplete(ProfWin* window, const char* const input, gboolean previous)
+{
+    char* result = NULL;
+
+    result = autocomplete_param_with_ac(input, "/perf log", perf_log_ac, FALSE, previous);
+    if (result) {
+        return result;
+    }
+
+    return autocomplete_param_with_ac(input, "/perf", perf_ac, FALSE, previous);
+}
+
 static char*
 _adhoc_cmd_autocomplete(ProfWin* window, const char* const input, gboolean previous)
 {
@@ -4404,3 +4437,33 @@ _vcard_autocomplete(ProfWin* window, const char* const input, gboolean previous)
 
     return result;
 }
+
+static char*
+_xmlconsole_autocomplete(ProfWin* window, const char* const input, gboolean previous)
+{
+    char* result = NULL;
+
+    result = autocomplete_param_with_ac(input, "/xmlconsole filter type", xmlconsole_type_ac, TRUE, previous);
+    if (result) {
+        return result;
+    }
+
+    result = autocomplete_param_with_func(input, "/xmlconsole filter jid", roster_barejid_autocomplete, previous, NULL);
+    if (result) {
+        return result;
+    }
+
+    result = autocomplete_param_with_ac(input, "/xmlconsole filter", xmlconsole_filter_ac, TRUE, previous);
+    if (result) {
+        return result;
+    }
+
+    result = autocomplete_param_with_func(input, "/xmlconsole pretty", prefs_autocomplete_boolean_choice, previous, NULL);
+    if (result) {
+        return result;
+    }
+
+    result = autocomplete_param_with_ac(input, "/xmlconsole", xmlconsole_ac, TRUE, previous);
+
+    return result;
+}
@@ -42,7 +42,7 @@
 void cmd_ac_init(void);
 void cmd_ac_uninit(void);
 char* cmd_ac_complete(ProfWin* window, const char* const input, gboolean previous);
-void cmd_ac_reset(ProfWin* window);
+void cmd_ac_reset(void);
 gboolean cmd_ac_exists(char* cmd);
 
 void cmd_ac_add(const char* const value);
@@ -121,8 +121,8 @@ static const struct cmd_t command_defs[] = {
       CMD_ARGS(
               { "<area>", "Summary help for commands in a certain area of functionality." },
               { "<command>", "Full help for a specific command, for example '/help connect'." },
-              { "search_all <search_terms>", "Search commands for returning matches that contain all of the search terms." },
-              { "search_any <search_terms>", "Search commands for returning matches that contain any of the search terms." })
+              { "search_all <search_terms>", "Search commands for returning matches that contain all of the search terms, best matches first." },
+              { "search_any <search_terms>", "Search commands for returning matches that contain any of the search terms, best matches first." })
       CMD_EXAMPLES(
               "/help search_all presence online",
               "/help commands",
@@ -438,7 +438,7 @@ static const struct cmd_t command_defs[] = {
     },
 
     { CMD_PREAMBLE("/caps",
-                   parse_args, 0, 1, NULL)
+                   parse_args, 0, 2, NULL)
       CMD_MAINFUNC(cmd_caps)
       CMD_TAGS(
               CMD_TAG_DISCOVERY,
@@ -446,17 +446,20 @@ static const struct cmd_t command_defs[] = {
               CMD_TAG_GROUPCHAT)
       CMD_SYN(
               "/caps",
-              "/caps <fulljid>|<nick>")
+              "/caps <fulljid>|<nick>",
+              "/caps requests <max>")
       CMD_DESC(
               "Find out a contacts, or room members client software capabilities. "
               "If in private chat initiated from a chat room, no parameter is required.")
       CMD_ARGS(
               { "<fulljid>", "If in the console or a chat window, the full JID for which you wish to see capabilities." },
-              { "<nick>", "If in a chat room, nickname for which you wish to see capabilities." })
+              { "<nick>", "If in a chat room, nickname for which you wish to see capabilities." },
+              { "requests <max>", "Send at most this many capabilities queries at once when joining busy rooms, 8 by default." })
       CMD_EXAMPLES(
               "/caps ran@cold.sea.org/laptop",
               "/caps ran@cold.sea.org/phone",
-              "/caps aegir")
+              "/caps aegir",
+              "/caps requests 4")
     },
 
     { CMD_PREAMBLE("/software",
@@ -748,7 +751,8 @@ static const struct cmd_t command_defs[] = {
               "/rooms filter <text>",
               "/rooms service <service>",
               "/rooms service <service> filter <text>",
-              "/rooms cache on|off|clear")
+              "/rooms cache on|off|clear",
+              "/rooms cache ttl <seconds>")
       CMD_DESC(
               "List the chat rooms available at the specified conference service. "
               "If no argument is supplied, the account preference 'muc.service' is used, 'conference.<domain-part>' by default. "
@@ -757,7 +761,8 @@ static const struct cmd_t command_defs[] = {
               { "service <service>", "The conference service to query." },
               { "filter <text>", "The text to filter results by." },
               { "cache on|off", "Enable or disable caching of rooms list response, enabled by default." },
-              { "cache clear", "Clear the rooms response cache if enabled." })
+              { "cache clear", "Clear the rooms response cache if enabled." },
+              { "cache ttl <seconds>", "Refresh a cached rooms list in the background once it is older than this, one day by default." })
       CMD_EXAMPLES(
               "/rooms",
               "/rooms filter development",
@@ -1918,6 +1923,23 @@ static const struct cmd_t command_defs[] = {
               { "on|off", "Enable or disable message carbons." })
     },
 
+    { CMD_PREAMBLE("/csi",
+                   parse_args, 1, 2, &cons_csi_setting)
+      CMD_MAINFUNC(cmd_csi)
+      CMD_TAGS(
+              CMD_TAG_CONNECTION)
+      CMD_SYN(
+              "/csi on|off",
+              "/csi focus on|off")
+      CMD_DESC(
+              "Client State Indication (XEP-0352). "
+              "When enabled and the server supports it, the server is told that nobody is looking once you have been idle for the autoaway time (/autoaway time), "
+              "so it can hold back presence updates and other non urgent traffic until you are back.")
+      CMD_ARGS(
+              { "on|off", "Enable or disable client state indication, default on." },
+              { "focus on|off", "Also tell the server you are inactive while the terminal does not have focus. Requires a terminal that supports focus reporting, default off." })
+    },
+
     { CMD_PREAMBLE("/receipts",
                    parse_args, 2, 2, &cons_receipts_setting)
       CMD_MAINFUNC(cmd_receipts)
@@ -2231,14 +2253,27 @@ static const struct cmd_t command_defs[] = {
     },
 
     { CMD_PREAMBLE("/xmlconsole",
-                   parse_args, 0, 0, NULL)
+                   parse_args, 0, 3, NULL)
       CMD_MAINFUNC(cmd_xmlconsole)
       CMD_TAGS(
               CMD_TAG_UI)
       CMD_SYN(
-              "/xmlconsole")
+              "/xmlconsole",
+              "/xmlconsole filter type message|presence|iq",
+              "/xmlconsole filter jid <jid>",
+              "/xmlconsole filter clear",
+              "/xmlconsole pretty on|off")
       CMD_DESC(
-              "Open the XML console to view incoming and outgoing XMPP traffic.")
+              "Open the XML console to view incoming and outgoing XMPP traffic. "
+              "The most recent stanzas are kept while the console is open, filters and pretty printing apply to those as well.")
+      CMD_ARGS(
+              { "filter type message|presence|iq", "Only show stanzas of this type." },
+              { "filter jid <jid>", "Only show stanzas that mention this JID." },
+              { "filter clear", "Show all stanzas again." },
+              { "pretty on|off", "Indent the XML of each stanza." })
+      CMD_EXAMPLES(
+              "/xmlconsole filter type presence",
+              "/xmlconsole filter jid juliet@capulet.lit")
     },
 
     { CMD_PREAMBLE("/script",
@@ -2741,101 +2776,261 @@ static const struct cmd_t command_defs[] = {
               "Redraw user interface. Can be used when some other program interrupted profanity or wrote to the same terminal and the interface looks \"broken\"." )
     },
 
+    { CMD_PREAMBLE("/perf",
+                   parse_args, 0, 2, NULL)
+      CMD_MAINFUNC(cmd_perf)
+      CMD_TAGS(
+              CMD_TAG_UI)
+      CMD_SYN(
+              "/perf",
+              "/perf on|off",
+              "/perf reset",
+              "/perf log <seconds>|off")
+      CMD_DESC(
+              "Show where Profanity spends its time. "
+              "While enabled, the main loop, stanza handlers, database inserts, plugin hooks and OMEMO encryption are timed. "
+              "Without arguments, print every timer with its sample count, total time and latency percentiles, and every counter. "
+              "Percentiles are the upper bound of a power of two bucket. Collecting is off by default.")
+      CMD_ARGS(
+              { "on|off", "Start or stop collecting timers and counters." },
+              { "reset", "Clear all collected data." },
+              { "log <seconds>", "While collecting, write all timers and counters to the log file every <seconds> seconds." },
+              { "log off", "Stop writing to the log file." })
+      CMD_EXAMPLES(
+              "/perf on",
+              "/perf log 60",
+              "/perf")
+    },
+
     // NEXT-COMMAND (search helper)
 };
 
 // clang-format on
 
-static GHashTable* search_index;
+// commands containing a search term, and how often the term appears in each
+typedef struct search_posting_t
+{
+    const char* cmd;
+    guint freq;
+} SearchPosting;
+
+typedef struct search_term_t
+{
+    gchar* term;
+    GArray* postings;
+} SearchTerm;
+
+// terms sorted with strcmp, so all terms sharing a prefix are adjacent
+// built on the first /help search, tokenizing every help text slows down startup
+static GPtrArray* search_index;
+
+static void
+_search_term_free(SearchTerm* term)
+{
+    g_free(term->term);
+    g_array_free(term->postings, TRUE);
+    g_free(term);
+}
+
+static gint
+_search_term_cmp(gconstpointer a, gconstpointer b)
+{
+    const SearchTerm* term_a = *(SearchTerm* const*)a;
+    const SearchTerm* term_b = *(SearchTerm* const*)b;
+    return strcmp(term_a->term, term_b->term);
+}
+
+static void
+_search_index_add(GHashTable* terms, const char* cmd, const char* text)
+{
+    auto_gcharv gchar** tokens = g_str_tokenize_and_fold(text, NULL, NULL);
+    for (int i = 0; tokens[i] != NULL; i++) {
+        SearchTerm* term = g_hash_table_lookup(terms, tokens[i]);
+        if (!term) {
+            term = g_new0(SearchTerm, 1);
+            term->term = g_strdup(tokens[i]);
+            term->postings = g_array_new(FALSE, FALSE, sizeof(SearchPosting));
+            g_hash_table_insert(terms, term->term, term);
+        }
+
+        // commands are indexed one at a time, so an existing posting is always the last one
+        if (term->postings->len > 0) {
+            SearchPosting* last = &g_array_index(term->postings, SearchPosting, term->postings->len - 1);
+            if (last->cmd == cmd) {
+                last->freq++;
+                continue;
+            }
+        }
+        SearchPosting posting = { cmd, 1 };
+        g_array_append_val(term->postings, posting);
+    }
+}
+
+static void
+_search_index_add_command(GHashTable* terms, const Command* pcmd)
+{
+    _search_index_add(terms, pcmd->cmd, pcmd->cmd);
+    _search_index_add(terms, pcmd->cmd, pcmd->help.desc);
+    for (int i = 0; pcmd->help.tags[i] != NULL; i++) {
+        _search_index_add(terms, pcmd->cmd, pcmd->help.tags[i]);
+    }
+    for (int i = 0; pcmd->help.synopsis[i] != NULL; i++) {
+        _search_index_add(terms, pcmd->cmd, pcmd->help.synopsis[i]);
+    }
+    for (int i = 0; pcmd->help.args[i][0] != NULL; i++) {
+        _search_index_add(terms, pcmd->cmd, pcmd->help.args[i][0]);
+        _search_index_add(terms, pcmd->cmd, pcmd->help.args[i][1]);
+    }
+}
 
-static char*
-_cmd_index(const Command* cmd)
+static GPtrArray*
+_cmd_search_index(void)
 {
-    GString* index_source = g_string_new("");
-    index_source = g_string_append(index_source, cmd->cmd);
-    index_source = g_string_append(index_source, " ");
-    index_source = g_string_append(index_source, cmd->help.desc);
-    index_source = g_string_append(index_source, " ");
-
-    int len = g_strv_length((gchar**)cmd->help.tags);
-    for (int i = 0; i < len; i++) {
-        index_source = g_string_append(index_source, cmd->help.tags[i]);
-        index_source = g_string_append(index_source, " ");
+    if (!search_index) {
+        GHashTable* terms = g_hash_table_new(g_str_hash, g_str_equal);
+        for (unsigned int i = 0; i < ARRAY_SIZE(command_defs); i++) {
+            _search_index_add_command(terms, command_defs + i);
+        }
+
+        search_index = g_ptr_array_new_full(g_hash_table_size(terms), (GDestroyNotify)_search_term_free);
+        GHashTableIter iter;
+        gpointer value;
+        g_hash_table_iter_init(&iter, terms);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            g_ptr_array_add(search_index, value);
+        }
+        g_hash_table_destroy(terms);
+
+        g_ptr_array_sort(search_index, _search_term_cmp);
     }
-    len = g_strv_length((gchar**)cmd->help.synopsis);
-    for (int i = 0; i < len; i++) {
-        index_source = g_string_append(index_source, cmd->help.synopsis[i]);
-        index_source = g_string_append(index_source, " ");
+
+    return search_index;
+}
+
+/*
+ * Sum up the term frequencies of every indexed term starting with prefix,
+ * returns a table of command name to score.
+ */
+static GHashTable*
+_search_prefix(GPtrArray* index, const char* prefix)
+{
+    GHashTable* scores = g_hash_table_new(g_str_hash, g_str_equal);
+
+    // find the first term not sorting before prefix
+    guint low = 0;
+    guint high = index->len;
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        SearchTerm* term = g_ptr_array_index(index, mid);
+        if (strcmp(term->term, prefix) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
     }
-    for (int i = 0; cmd->help.args[i][0] != NULL; i++) {
-        index_source = g_string_append(index_source, cmd->help.args[i][0]);
-        index_source = g_string_append(index_source, " ");
-        index_source = g_string_append(index_source, cmd->help.args[i][1]);
-        index_source = g_string_append(index_source, " ");
+
+    for (guint i = low; i < index->len; i++) {
+        SearchTerm* term = g_ptr_array_index(index, i);
+        if (!g_str_has_prefix(term->term, prefix)) {
+            break;
+        }
+        for (guint j = 0; j < term->postings->len; j++) {
+            SearchPosting* posting = &g_array_index(term->postings, SearchPosting, j);
+            guint score = GPOINTER_TO_UINT(g_hash_table_lookup(scores, posting->cmd));
+            g_hash_table_insert(scores, (gpointer)posting->cmd, GUINT_TO_POINTER(score + posting->freq));
+        }
     }
 
-    auto_gcharv gchar** tokens = g_str_tokenize_and_fold(index_source->str, NULL, NULL);
-    g_string_free(index_source, TRUE);
+    return scores;
+}
 
-    GString* index = g_string_new("");
-    for (int i = 0; i < g_strv_length(tokens); i++) {
-        index = g_string_append(index, tokens[i]);
-        index = g_string_append(index, " ");
+static gint
+_search_result_cmp(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    GHashTable* scores = user_data;
+    guint score_a = GPOINTER_TO_UINT(g_hash_table_lookup(scores, a));
+    guint score_b = GPOINTER_TO_UINT(g_hash_table_lookup(scores, b));
+    if (score_a != score_b) {
+        return score_a > score_b ? -1 : 1;
     }
+    return g_strcmp0(a, b);
+}
 
-    return g_string_free(index, FALSE);
+static GList*
+_search_results(GHashTable* scores)
+{
+    GList* results = g_hash_table_get_keys(scores);
+    return g_list_sort_with_data(results, _search_result_cmp, scores);
 }
 
+/*
+ * Commands matching any of the search terms, a term matches every indexed
+ * word it is a prefix of. Best matches come first, the list must be freed
+ * with g_list_free, the command names belong to the command definitions.
+ */
 GList*
 cmd_search_index_any(char* term)
 {
-    GList* results = NULL;
-
-    auto_gcharv gchar** processed_terms = g_str_tokenize_and_fold(term, NULL, NULL);
-    int terms_len = g_strv_length(processed_terms);
-
-    for (int i = 0; i < terms_len; i++) {
-        GList* index_keys = g_hash_table_get_keys(search_index);
-        GList* curr = index_keys;
-        while (curr) {
-            char* index_entry = g_hash_table_lookup(search_index, curr->data);
-            if (g_str_match_string(processed_terms[i], index_entry, FALSE)) {
-                results = g_list_append(results, curr->data);
-            }
-            curr = g_list_next(curr);
+    GPtrArray* index = _cmd_search_index();
+    GHashTable* scores = g_hash_table_new(g_str_hash, g_str_equal);
+
+    auto_gcharv gchar** terms = g_str_tokenize_and_fold(term, NULL, NULL);
+    for (int i = 0; terms[i] != NULL; i++) {
+        GHashTable* term_scores = _search_prefix(index, terms[i]);
+        GHashTableIter iter;
+        gpointer cmd, term_score;
+        g_hash_table_iter_init(&iter, term_scores);
+        while (g_hash_table_iter_next(&iter, &cmd, &term_score)) {
+            guint score = GPOINTER_TO_UINT(g_hash_table_lookup(scores, cmd));
+            g_hash_table_insert(scores, cmd, GUINT_TO_POINTER(score + GPOINTER_TO_UINT(term_score)));
         }
-        g_list_free(index_keys);
+        g_hash_table_destroy(term_scores);
     }
 
+    GList* results = _search_results(scores);
+    g_hash_table_destroy(scores);
+
     return results;
 }
 
+/*
+ * Commands matching all of the search terms, ranked like
+ * cmd_search_index_any.
+ */
 GList*
 cmd_search_index_all(char* term)
 {
-    GList* results = NULL;
+    GPtrArray* index = _cmd_search_index();
+    GHashTable* scores = NULL;
 
     auto_gcharv gchar** terms = g_str_tokenize_and_fold(term, NULL, NULL);
-    int terms_len = g_strv_length(terms);
+    for (int i = 0; terms[i] != NULL; i++) {
+        GHashTable* term_scores = _search_prefix(index, terms[i]);
+        if (!scores) {
+            scores = term_scores;
+            continue;
+        }
 
-    GList* commands = g_hash_table_get_keys(search_index);
-    GList* curr = commands;
-    while (curr) {
-        char* command = curr->data;
-        int matches = 0;
-        for (int i = 0; i < terms_len; i++) {
-            char* command_index = g_hash_table_lookup(search_index, command);
-            if (g_str_match_string(terms[i], command_index, FALSE)) {
-                matches++;
+        GHashTableIter iter;
+        gpointer cmd, score;
+        g_hash_table_iter_init(&iter, scores);
+        while (g_hash_table_iter_next(&iter, &cmd, &score)) {
+            gpointer term_score = g_hash_table_lookup(term_scores, cmd);
+            if (term_score) {
+                g_hash_table_iter_replace(&iter, GUINT_TO_POINTER(GPOINTER_TO_UINT(score) + GPOINTER_TO_UINT(term_score)));
+            } else {
+                g_hash_table_iter_remove(&iter);
             }
         }
-        if (matches == terms_len) {
-            results = g_list_append(results, command);
-        }
-        curr = g_list_next(curr);
+        g_hash_table_destroy(term_scores);
+    }
+
+    if (!scores) {
+        return NULL;
     }
 
-    g_list_free(commands);
+    GList* results = _search_results(scores);
+    g_hash_table_destroy(scores);
 
     return results;
 }
@@ -2850,8 +3045,6 @@ cmd_init(void)
 
     cmd_ac_init();
 
-    search_index = g_hash_table_new_full(g_str_hash, g_str_equal, free, g_free);
-
     // load command defs into hash table
     commands = g_hash_table_new(g_str_hash, g_str_equal);
     for (unsigned int i = 0; i < ARRAY_SIZE(command_defs); i++) {
@@ -2860,9 +3053,6 @@ cmd_init(void)
         // add to hash
         g_hash_table_insert(commands, pcmd->cmd, (gpointer)pcmd);
 
-        // add to search index
-        g_hash_table_insert(search_index, strdup(pcmd->cmd), _cmd_index(pcmd));
-
         // add to commands and help autocompleters
         cmd_ac_add_cmd(pcmd);
     }
@@ -2883,7 +3073,10 @@ cmd_uninit(void)
 {
     cmd_ac_uninit();
     g_hash_table_destroy(commands);
-    g_hash_table_destroy(search_index);
+    if (search_index) {
+        g_ptr_array_free(search_index, TRUE);
+        search_index = NULL;
+    }
 }
 
 gboolean
@@ -80,6 +80,7 @@
 #include "tools/plugin_download.h"
 #include "tools/bookmark_ignore.h"
 #include "tools/editor.h"
+#include "tools/perf.h"
 #include "plugins/plugins.h"
 #include "ui/inputwin.h"
 #include "ui/ui.h"
@@ -1647,15 +1648,8 @@ cmd_help(ProfWin* window, const char* const command, gchar** args)
             if (cmds == NULL) {
                 cons_show("No commands found.");
             } else {
-                GList* curr = cmds;
-                GList* results = NULL;
-                while (curr) {
-                    results = g_list_insert_sorted(results, curr->data, (GCompareFunc)g_strcmp0);
-                    curr = g_list_next(curr);
-                }
                 cons_show("Search results:");
-                _cmd_list_commands(results);
-                g_list_free(results);
+                _cmd_list_commands(cmds);
             }
             g_list_free(cmds);
         }
@@ -1667,15 +1661,8 @@ cmd_help(ProfWin* window, const char* const command, gchar** args)
             if (cmds == NULL) {
                 cons_show("No commands found.");
             } else {
-                GList* curr = cmds;
-                GList* results = NULL;
-                while (curr) {
-                    results = g_list_insert_sorted(results, curr->data, (GCompareFunc)g_strcmp0);
-                    curr = g_list_next(curr);
-                }
                 cons_show("Search results:");
-                _cmd_list_commands(results);
-                g_list_free(results);
+                _cmd_list_commands(cmds);
             }
             g_list_free(cmds);
         }
@@ -3382,6 +3369,22 @@ cmd_info(ProfWin* window, const char* const command, gchar** args)
 gboolean
 cmd_caps(ProfWin* window, const char* const command, gchar** args)
 {
+    if (g_strv_length(args) == 2) {
+        if (g_strcmp0(args[0], "requests") != 0) {
+            cons_bad_cmd_usage(command);
+            return TRUE;
+        }
+        int max = 0;
+        auto_char char* err_msg = NULL;
+        if (!strtoi_range(args[1], &max, 1, INT_MAX, &err_msg)) {
+            cons_show(err_msg);
+            return TRUE;
+        }
+        prefs_set_caps_requests_max(max);
+        cons_show("Capabilities queries in flight limited to %d.", max);
+        return TRUE;
+    }
+
     jabber_conn_status_t conn_status = connection_get_status();
     Occupant* occupant = NULL;
 
@@ -4541,7 +4544,17 @@ cmd_rooms(ProfWin* window, const char* const command, gchar** args)
             }
             filter = g_strdup(args[1]);
         } else if (g_strcmp0(args[0], "cache") == 0) {
-            if (g_strv_length(args) != 2) {
+            if (g_strv_length(args) == 3 && g_strcmp0(args[1], "ttl") == 0) {
+                int ttl = 0;
+                auto_char char* err_msg = NULL;
+                if (!strtoi_range(args[2], &ttl, 0, INT_MAX, &err_msg)) {
+                    cons_show(err_msg);
+                    return TRUE;
+                }
+                prefs_set_rooms_cache_ttl(ttl);
+                cons_show("Rooms list cache refreshed after %d seconds.", ttl);
+                return TRUE;
+            } else if (g_strv_length(args) != 2) {
                 cons_bad_cmd_usage(command);
                 cons_show("");
                 return TRUE;
@@ -4842,46 +4855,6 @@ cmd_disco(ProfWin* window, const char* const command, gchar** args)
     return TRUE;
 }
 
-// TODO: Move this into its own tools such as HTTPUpload or AESGCMDownload.
-#ifdef HAVE_OMEMO
-char*
-_add_omemo_stream(int* fd, FILE** fh, char** err)
-{
-    // Create temporary file for writing ciphertext.
-    int tmpfd;
-    auto_char char* tmpname = NULL;
-    if ((tmpfd = g_file_open_tmp("profanity.XXXXXX", &tmpname, NULL)) == -1) {
-        *err = "Unable to create temporary file for encrypted transfer.";
-        return NULL;
-    }
-    FILE* tmpfh = fdopen(tmpfd, "w+b");
-
-    // The temporary ciphertext file should be removed after it has
-    // been closed.
-    remove(tmpname);
-
-    int crypt_res;
-    char* fragment;
-    fragment = omemo_encrypt_file(*fh, tmpfh, file_size(*fd), &crypt_res);
-    if (crypt_res != 0) {
-        fclose(tmpfh);
-        return NULL;
-    }
-
-    // Force flush as the upload will read from the same stream.
-    fflush(tmpfh);
-    rewind(tmpfh);
-
-    fclose(*fh); // Also closes descriptor.
-
-    // Switch original stream with temporary ciphertext stream.
-    *fd = tmpfd;
-    *fh = tmpfh;
-
-    return fragment;
-}
-#endif
-
 gboolean
 cmd_sendfile(ProfWin* window, const char* const command, gchar** args)
 {
@@ -4890,6 +4863,7 @@ cmd_sendfile(ProfWin* window, const char* const command, gchar** args)
     auto_gchar gchar* filename = get_expanded_path(args[0]);
     char* alt_scheme = NULL;
     char* alt_fragment = NULL;
+    struct omemo_aesgcm_stream_t* omemo_stream = NULL;
 
     if (access(filename, R_OK) != 0) {
         cons_show_error("Uploading '%s' failed: File not found!", filename);
@@ -4918,6 +4892,7 @@ cmd_sendfile(ProfWin* window, const char* const command, gchar** args)
     }
 
     FILE* fh = fdopen(fd, "rb");
+    off_t filesize = file_size(fd);
 
     gboolean omemo_enabled = FALSE;
     gboolean sendfile_enabled = TRUE;
@@ -4954,14 +4929,18 @@ cmd_sendfile(ProfWin* window, const char* const command, gchar** args)
 
     if (omemo_enabled) {
 #ifdef HAVE_OMEMO
-        char* err = NULL;
+        // The file is encrypted while it is uploaded, see http_file_put().
         alt_scheme = OMEMO_AESGCM_URL_SCHEME;
-        alt_fragment = _add_omemo_stream(&fd, &fh, &err);
-        if (err != NULL) {
+        omemo_stream = omemo_encrypt_stream_new(filesize, &alt_fragment);
+        if (omemo_stream == NULL) {
+            const char* err = "Unable to set up encryption for transfer.";
             cons_show_error(err);
             win_println(window, THEME_ERROR, "-", err);
+            fclose(fh);
             goto out;
         }
+        // The authentication tag is sent after the ciphertext.
+        filesize += OMEMO_AESGCM_TAG_LENGTH;
 #endif
     }
 
@@ -4970,7 +4949,8 @@ cmd_sendfile(ProfWin* window, const char* const command, gchar** args)
 
     upload->filename = strdup(filename);
     upload->filehandle = fh;
-    upload->filesize = file_size(fd);
+    upload->filesize = filesize;
+    upload->omemo_stream = omemo_stream;
     upload->mime_type = file_mime_type(filename);
 
     if (alt_scheme != NULL) {
@@ -6672,13 +6652,46 @@ gboolean
 cmd_xmlconsole(ProfWin* window, const char* const command, gchar** args)
 {
     ProfXMLWin* xmlwin = wins_get_xmlconsole();
-    if (xmlwin) {
+    if (xmlwin == NULL) {
+        xmlwin = (ProfXMLWin*)wins_new_xmlconsole();
+    }
+
+    if (args[0] == NULL) {
         ui_focus_win((ProfWin*)xmlwin);
+        return TRUE;
+    }
+
+    if (g_strcmp0(args[0], "filter") == 0) {
+        if (g_strcmp0(args[1], "type") == 0 && args[2]) {
+            if (g_strcmp0(args[2], "message") != 0 && g_strcmp0(args[2], "presence") != 0 && g_strcmp0(args[2], "iq") != 0) {
+                cons_bad_cmd_usage(command);
+                return TRUE;
+            }
+            xmlwin_set_filter(xmlwin, args[2], xmlwin->filter_jid);
+        } else if (g_strcmp0(args[1], "jid") == 0 && args[2]) {
+            xmlwin_set_filter(xmlwin, xmlwin->filter_type, args[2]);
+        } else if (g_strcmp0(args[1], "clear") == 0) {
+            xmlwin_set_filter(xmlwin, NULL, NULL);
+        } else {
+            cons_bad_cmd_usage(command);
+            return TRUE;
+        }
+    } else if (g_strcmp0(args[0], "pretty") == 0) {
+        if (g_strcmp0(args[1], "on") == 0) {
+            xmlwin_set_pretty(xmlwin, TRUE);
+        } else if (g_strcmp0(args[1], "off") == 0) {
+            xmlwin_set_pretty(xmlwin, FALSE);
+        } else {
+            cons_bad_cmd_usage(command);
+            return TRUE;
+        }
     } else {
-        ProfWin* window = wins_new_xmlconsole();
-        ui_focus_win(window);
+        cons_bad_cmd_usage(command);
+        return TRUE;
     }
 
+    ui_focus_win((ProfWin*)xmlwin);
+
     return TRUE;
 }
 
@@ -6926,6 +6939,25 @@ cmd_receipts(ProfWin* window, const char* const command, gchar** args)
     return TRUE;
 }
 
+gboolean
+cmd_csi(ProfWin* window, const char* const command, gchar** args)
+{
+    if (g_strcmp0(args[0], "focus") == 0) {
+        gboolean was_enabled = prefs_get_boolean(PREF_CSI_FOCUS);
+        _cmd_set_boolean_preference(args[1], "Client state indication on terminal focus", PREF_CSI_FOCUS);
+        gboolean enabled = prefs_get_boolean(PREF_CSI_FOCUS);
+        if (enabled != was_enabled) {
+            ui_terminal_focus_reporting(enabled);
+        }
+    } else if (args[1] == NULL) {
+        _cmd_set_boolean_preference(args[0], "Client state indication", PREF_CSI);
+    } else {
+        cons_bad_cmd_usage(command);
+    }
+
+    return TRUE;
+}
+
 static gboolean
 _is_correct_plugin_extension(gchar* plugin)
 {
@@ -7319,6 +7351,7 @@ cmd_pgp(ProfWin* window, const char* const command, gchar** args)
         GHashTable* keys = p_gpg_list_keys();
         if (!keys || g_hash_table_size(keys) == 0) {
             cons_show("No keys found");
+            p_gpg_free_keys(keys);
             return TRUE;
         }
 
@@ -7606,6 +7639,7 @@ cmd_ox(ProfWin* window, const char* const command, gchar** args)
         GHashTable* keys = p_gpg_list_keys();
         if (!keys || g_hash_table_size(keys) == 0) {
             cons_show("No keys found");
+            p_gpg_free_keys(keys);
             return TRUE;
         }
 
@@ -9270,8 +9304,8 @@ cmd_avatar(ProfWin* window, const char* const command, gchar** args)
     } else {
         if (g_strcmp0(args[0], "set") == 0) {
 #ifdef HAVE_PIXBUF
-            if (avatar_set(args[1])) {
-                cons_show("Avatar updated successfully");
+            if (!avatar_set(args[1])) {
+                cons_show_error("Unable to update avatar.");
             }
 #else
             cons_show("Profanity has not been built with GDK Pixbuf support enabled which is needed to scale the avatar when uploading.");
@@ -9447,8 +9481,7 @@ _url_aesgcm_method(ProfWin* window, const char* cmd_template, gchar* url, gchar*
         download->cmd_template = NULL;
     }
 
-    pthread_create(&(download->worker), NULL, &aesgcm_file_get, download);
-    aesgcm_download_add_download(download);
+    aesgcm_file_get(download);
 }
 #endif
 
@@ -9464,9 +9497,9 @@ _download_install_plugin(ProfWin* window, gchar* url, gchar* path)
     download->filename = strdup(filename);
     download->id = get_random_string(4);
     download->cmd_template = NULL;
+    download->omemo_stream = NULL;
 
-    pthread_create(&(download->worker), NULL, &plugin_download_install, download);
-    plugin_download_add_download(download);
+    plugin_download_install(download);
     return TRUE;
 }
 
@@ -9484,9 +9517,10 @@ _url_http_method(ProfWin* window, const char* cmd_template, gchar* url, gchar* p
     download->id = strdup(id);
     download->cmd_template = cmd_template ? strdup(cmd_template) : NULL;
     download->silent = FALSE;
+    download->omemo_stream = NULL;
+    download->on_complete = NULL;
 
-    pthread_create(&(download->worker), NULL, &http_file_get, download);
-    http_download_add_download(download);
+    http_file_get(download);
 }
 
 void
@@ -9857,6 +9891,68 @@ cmd_strophe(ProfWin* window, const char* const command, gchar** args)
     return TRUE;
 }
 
+gboolean
+cmd_perf(ProfWin* window, const char* const command, gchar** args)
+{
+    if (args[0] == NULL) {
+        if (!perf_enabled) {
+            cons_show("Performance data collection is disabled, use '/perf on' to enable it.");
+        }
+
+        GList* metrics = perf_get_metrics();
+        if (!metrics) {
+            cons_show("No performance data collected.");
+            return TRUE;
+        }
+
+        cons_show("");
+        cons_show("Performance data:");
+        for (GList* curr = metrics; curr; curr = g_list_next(curr)) {
+            ProfPerfMetric* metric = curr->data;
+            auto_gchar gchar* summary = perf_metric_summary(metric);
+            cons_show("  %-45s %s", metric->name, summary);
+        }
+        g_list_free(metrics);
+
+        int interval = perf_get_log_interval();
+        if (interval > 0) {
+            cons_show("Written to the log every %d seconds.", interval);
+        }
+        cons_alert(NULL);
+        return TRUE;
+    }
+
+    if (g_strcmp0(args[0], "on") == 0 && args[1] == NULL) {
+        perf_set_enabled(TRUE);
+        cons_show("Performance data collection enabled.");
+    } else if (g_strcmp0(args[0], "off") == 0 && args[1] == NULL) {
+        perf_set_enabled(FALSE);
+        cons_show("Performance data collection disabled.");
+    } else if (g_strcmp0(args[0], "reset") == 0 && args[1] == NULL) {
+        perf_reset();
+        cons_show("Performance data cleared.");
+    } else if (g_strcmp0(args[0], "log") == 0 && args[1]) {
+        if (g_strcmp0(args[1], "off") == 0) {
+            perf_set_log_interval(0);
+            cons_show("Performance data will not be written to the log.");
+            return TRUE;
+        }
+
+        int interval = 0;
+        auto_char char* err_msg = NULL;
+        if (!strtoi_range(args[1], &interval, 1, INT_MAX, &err_msg)) {
+            cons_show(err_msg);
+            return TRUE;
+        }
+        perf_set_log_interval(interval);
+        cons_show("Performance data will be written to the log every %d seconds while collecting.", interval);
+    } else {
+        cons_bad_cmd_usage(command);
+    }
+
+    return TRUE;
+}
+
 gboolean
 cmd_vcard(ProfWin* window, const char* const command, gchar** args)
 {
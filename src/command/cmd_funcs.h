@@ -102,6 +102,7 @@ gboolean cmd_help(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_history(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_carbons(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_receipts(ProfWin* window, const char* const command, gchar** args);
+gboolean cmd_csi(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_info(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_intype(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_invite(ProfWin* window, const char* const command, gchar** args);
@@ -260,6 +261,7 @@ gboolean cmd_silence(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_register(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_mood(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_strophe(ProfWin* window, const char* const command, gchar** args);
+gboolean cmd_perf(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_stamp(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_vcard(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_vcard_add(ProfWin* window, const char* const command, gchar** args);
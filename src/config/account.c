@@ -140,6 +140,7 @@ account_new(gchar* name, gchar* jid, gchar* password, gchar* eval_password, gboo
     new_account->auth_policy = auth_policy;
 
     new_account->max_sessions = max_sessions;
+    new_account->ref_count = 1;
 
     return new_account;
 }
@@ -209,6 +210,16 @@ account_eval_password(ProfAccount* account)
     return TRUE;
 }
 
+ProfAccount*
+account_ref(ProfAccount* account)
+{
+    if (account) {
+        account->ref_count++;
+    }
+
+    return account;
+}
+
 void
 account_free(ProfAccount* account)
 {
@@ -216,6 +227,10 @@ account_free(ProfAccount* account)
         return;
     }
 
+    if (--account->ref_count > 0) {
+        return;
+    }
+
     free(account->name);
     free(account->jid);
     free(account->password);
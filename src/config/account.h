@@ -73,6 +73,7 @@ typedef struct prof_account_t
     gchar* auth_policy;
     gchar* client;
     int max_sessions;
+    gint ref_count;
 } ProfAccount;
 
 ProfAccount* account_new(gchar* name, gchar* jid, gchar* password, gchar* eval_password, gboolean enabled,
@@ -86,6 +87,8 @@ ProfAccount* account_new(gchar* name, gchar* jid, gchar* password, gchar* eval_p
                          gchar* client, int max_sessions);
 char* account_create_connect_jid(ProfAccount* account);
 gboolean account_eval_password(ProfAccount* account);
+ProfAccount* account_ref(ProfAccount* account);
+// drops a reference, the account is freed with the last one
 void account_free(ProfAccount* account);
 void account_set_server(ProfAccount* account, const char* server);
 void account_set_port(ProfAccount* account, int port);
@@ -59,7 +59,13 @@ static GKeyFile* accounts;
 static Autocomplete all_ac;
 static Autocomplete enabled_ac;
 
+// Shared read-only copy of the last account asked for with
+// accounts_get_account_snapshot(), dropped whenever the accounts file is saved.
+static ProfAccount* account_snapshot = NULL;
+static jabber_conn_status_t account_snapshot_status;
+
 static void _save_accounts(void);
+static void _accounts_snapshot_clear(void);
 
 void
 accounts_load(void)
@@ -87,6 +93,7 @@ accounts_close(void)
 {
     autocomplete_free(all_ac);
     autocomplete_free(enabled_ac);
+    _accounts_snapshot_clear();
     free_keyfile(&accounts_prof_keyfile);
     accounts = NULL;
 }
@@ -103,18 +110,6 @@ accounts_find_all(const char* const prefix, gboolean previous, void* context)
     return autocomplete_complete(all_ac, prefix, TRUE, previous);
 }
 
-void
-accounts_reset_all_search(void)
-{
-    autocomplete_reset(all_ac);
-}
-
-void
-accounts_reset_enabled_search(void)
-{
-    autocomplete_reset(enabled_ac);
-}
-
 void
 accounts_add(const char* account_name, const char* altdomain, const int port, const char* const tls_policy, const char* const auth_policy)
 {
@@ -340,6 +335,34 @@ accounts_get_account(const char* const name)
     }
 }
 
+/**
+ * Same as accounts_get_account() but without rebuilding the account from the
+ * accounts file each time. The returned account is shared and must not be
+ * modified, release it with account_free().
+ */
+ProfAccount*
+accounts_get_account_snapshot(const char* const name)
+{
+    if (name == NULL) {
+        return NULL;
+    }
+
+    // muc.service falls back to what the server offers, which depends on being connected
+    jabber_conn_status_t conn_status = connection_get_status();
+    if (account_snapshot
+        && (g_strcmp0(account_snapshot->name, name) != 0
+            || (account_snapshot_status != conn_status && !g_key_file_has_key(accounts, name, "muc.service", NULL)))) {
+        _accounts_snapshot_clear();
+    }
+
+    if (account_snapshot == NULL) {
+        account_snapshot = accounts_get_account(name);
+        account_snapshot_status = conn_status;
+    }
+
+    return account_ref(account_snapshot);
+}
+
 gboolean
 accounts_enable(const char* const name)
 {
@@ -951,8 +974,16 @@ accounts_get_login_status(const char* const account_name)
     return status;
 }
 
+static void
+_accounts_snapshot_clear(void)
+{
+    account_free(account_snapshot);
+    account_snapshot = NULL;
+}
+
 static void
 _save_accounts(void)
 {
+    _accounts_snapshot_clear();
     save_keyfile(&accounts_prof_keyfile);
 }
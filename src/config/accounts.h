@@ -46,12 +46,11 @@ void accounts_close(void);
 
 char* accounts_find_all(const char* const prefix, gboolean previous, void* context);
 char* accounts_find_enabled(const char* const prefix, gboolean previous, void* context);
-void accounts_reset_all_search(void);
-void accounts_reset_enabled_search(void);
 void accounts_add(const char* jid, const char* altdomain, const int port, const char* const tls_policy, const char* const auth_policy);
 int accounts_remove(const char* jid);
 gchar** accounts_get_list(void);
 ProfAccount* accounts_get_account(const char* const name);
+ProfAccount* accounts_get_account_snapshot(const char* const name);
 gboolean accounts_enable(const char* const name);
 gboolean accounts_disable(const char* const name);
 gboolean accounts_rename(const char* const account_name,
@@ -61,6 +61,9 @@
 #define DIR_EDITOR    "editor"
 #define DIR_CERTS     "certs"
 #define DIR_PHOTOS    "photos"
+#define DIR_ROSTER    "roster"
+#define DIR_AVATARS   "avatars"
+#define DIR_ROOMS     "rooms"
 
 void files_create_directories(void);
 
@@ -307,24 +307,12 @@ prefs_autocomplete_boolean_choice(const char* const prefix, gboolean previous, v
     return autocomplete_complete(boolean_choice_ac, prefix, TRUE, previous);
 }
 
-void
-prefs_reset_boolean_choice(void)
-{
-    autocomplete_reset(boolean_choice_ac);
-}
-
 gchar*
 prefs_autocomplete_room_trigger(const char* const prefix, gboolean previous, void* context)
 {
     return autocomplete_complete(room_trigger_ac, prefix, TRUE, previous);
 }
 
-void
-prefs_reset_room_trigger_ac(void)
-{
-    autocomplete_reset(room_trigger_ac);
-}
-
 gboolean
 prefs_do_chat_notify(gboolean current_win)
 {
@@ -757,6 +745,22 @@ prefs_set_reconnect(gint value)
     g_key_file_set_integer(prefs, PREF_GROUP_CONNECTION, "reconnect", value);
 }
 
+gint
+prefs_get_rooms_cache_ttl(void)
+{
+    if (!g_key_file_has_key(prefs, PREF_GROUP_MUC, "rooms.cache.ttl", NULL)) {
+        return 24 * 60 * 60;
+    } else {
+        return g_key_file_get_integer(prefs, PREF_GROUP_MUC, "rooms.cache.ttl", NULL);
+    }
+}
+
+void
+prefs_set_rooms_cache_ttl(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_MUC, "rooms.cache.ttl", value);
+}
+
 gint
 prefs_get_autoping(void)
 {
@@ -789,6 +793,22 @@ prefs_set_autoping_timeout(gint value)
     g_key_file_set_integer(prefs, PREF_GROUP_CONNECTION, "autoping.timeout", value);
 }
 
+gint
+prefs_get_caps_requests_max(void)
+{
+    if (!g_key_file_has_key(prefs, PREF_GROUP_CONNECTION, "caps.requests.max", NULL)) {
+        return 8;
+    } else {
+        return g_key_file_get_integer(prefs, PREF_GROUP_CONNECTION, "caps.requests.max", NULL);
+    }
+}
+
+void
+prefs_set_caps_requests_max(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_CONNECTION, "caps.requests.max", value);
+}
+
 gint
 prefs_get_autoaway_time(void)
 {
@@ -1845,6 +1865,8 @@ _get_group(preference_t pref)
     case PREF_STROPHE_VERBOSITY:
     case PREF_STROPHE_SM_ENABLED:
     case PREF_STROPHE_SM_RESEND:
+    case PREF_CSI:
+    case PREF_CSI_FOCUS:
         return PREF_GROUP_CONNECTION;
     case PREF_OTR_LOG:
     case PREF_OTR_POLICY:
@@ -2150,6 +2172,10 @@ _get_key(preference_t pref)
         return "strophe.sm.enabled";
     case PREF_STROPHE_SM_RESEND:
         return "strophe.sm.resend";
+    case PREF_CSI:
+        return "csi";
+    case PREF_CSI_FOCUS:
+        return "csi.focus";
     default:
         return NULL;
     }
@@ -2202,6 +2228,7 @@ _get_default_boolean(preference_t pref)
     case PREF_MOOD:
     case PREF_STROPHE_SM_ENABLED:
     case PREF_STROPHE_SM_RESEND:
+    case PREF_CSI:
         return TRUE;
     case PREF_PGP_PUBKEY_AUTOIMPORT:
     default:
@@ -187,6 +187,8 @@ typedef enum {
     PREF_STROPHE_SM_RESEND,
     PREF_VCARD_PHOTO_CMD,
     PREF_STATUSBAR_TABMODE,
+    PREF_CSI,
+    PREF_CSI_FOCUS,
 } preference_t;
 
 typedef struct prof_alias_t
@@ -209,10 +211,8 @@ void prefs_close(void);
 void prefs_reload(void);
 
 gchar* prefs_autocomplete_boolean_choice(const char* const prefix, gboolean previous, void* context);
-void prefs_reset_boolean_choice(void);
 
 gchar* prefs_autocomplete_room_trigger(const char* const prefix, gboolean previous, void* context);
-void prefs_reset_room_trigger_ac(void);
 
 gint prefs_get_gone(void);
 void prefs_set_gone(gint value);
@@ -225,10 +225,14 @@ gint prefs_get_max_log_size(void);
 gint prefs_get_priority(void);
 void prefs_set_reconnect(gint value);
 gint prefs_get_reconnect(void);
+void prefs_set_rooms_cache_ttl(gint value);
+gint prefs_get_rooms_cache_ttl(void);
 void prefs_set_autoping(gint value);
 gint prefs_get_autoping(void);
 void prefs_set_autoping_timeout(gint value);
 gint prefs_get_autoping_timeout(void);
+void prefs_set_caps_requests_max(gint value);
+gint prefs_get_caps_requests_max(void);
 gint prefs_get_inpblock(void);
 void prefs_set_inpblock(gint value);
 
@@ -60,6 +60,7 @@ static GString* theme_loc;
 static GKeyFile* theme;
 static GHashTable* bold_items;
 static GHashTable* defaults;
+static guint generation = 0;
 
 static void _load_preferences(void);
 static void _theme_list_dir(const gchar* const dir, GSList** result);
@@ -202,6 +203,8 @@ theme_load(const char* const theme_name, gboolean load_theme_prefs)
 static gboolean
 _theme_load_file(const char* const theme_name)
 {
+    generation++;
+
     // use default theme
     if (theme_name == NULL || strcmp(theme_name, "default") == 0) {
         if (theme) {
@@ -698,6 +701,13 @@ theme_hash_attrs(const char* str)
     return COLOR_PAIR(color_pair_cache_hash_str(str, profile));
 }
 
+/* changes whenever a theme is loaded, for callers caching theme_attrs() results */
+guint
+theme_get_generation(void)
+{
+    return generation;
+}
+
 /* returns the colours (fgnd and bknd) for a certain attribute ie main.text */
 int
 theme_attrs(theme_item_t attrs)
@@ -151,6 +151,7 @@ GSList* theme_list(void);
 void theme_close(void);
 int theme_hash_attrs(const char* str);
 int theme_attrs(theme_item_t attrs);
+guint theme_get_generation(void);
 char* theme_get_string(char* str);
 void theme_free_string(char* str);
 theme_item_t theme_main_presence_attrs(const char* const presence);
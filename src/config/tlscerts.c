@@ -311,12 +311,6 @@ tlscerts_complete(const char* const prefix, gboolean previous, void* context)
     return autocomplete_complete(certs_ac, prefix, TRUE, previous);
 }
 
-void
-tlscerts_reset_ac(void)
-{
-    autocomplete_reset(certs_ac);
-}
-
 void
 tlscerts_free(TLSCertificate* cert)
 {
@@ -94,7 +94,6 @@ GList* tlscerts_list(void);
 
 char* tlscerts_complete(const char* const prefix, gboolean previous, void* context);
 
-void tlscerts_reset_ac(void);
 
 void tlscerts_close(void);
 
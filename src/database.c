@@ -52,8 +52,10 @@
 #include "ui/ui.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/message.h"
+#include "tools/perf.h"
 
 static sqlite3* g_chatlog_database;
+static gboolean g_batch_open = FALSE;
 
 static void _add_to_db(ProfMessage* message, char* type, const Jid* const from_jid, const Jid* const to_jid);
 static char* _get_db_filename(ProfAccount* account);
@@ -62,6 +64,8 @@ static prof_enc_t _get_message_enc_type(const char* const encstr);
 static int _get_db_version(void);
 static gboolean _migrate_to_v2(void);
 static gboolean _check_available_space_for_db_migration(char* path_to_db);
+static gboolean _archive_id_exists(const char* const archive_id);
+static gboolean _archive_id_attach(ProfMessage* message);
 
 static const int latest_version = 2;
 
@@ -222,6 +226,7 @@ out:
 void
 log_database_close(void)
 {
+    log_database_batch_end();
     if (g_chatlog_database) {
         sqlite3_close(g_chatlog_database);
         sqlite3_shutdown();
@@ -239,6 +244,55 @@ log_database_add_incoming(ProfMessage* message)
     }
 }
 
+// Store a message paged in by the background archive sync, which may
+// already be in the database from a live delivery or an earlier sync
+void
+log_database_add_archived(ProfMessage* message)
+{
+    if (message->stanzaid && _archive_id_exists(message->stanzaid)) {
+        return;
+    }
+    // messages we sent, or got without a stanza-id, are already stored
+    if (_archive_id_attach(message)) {
+        return;
+    }
+    log_database_add_incoming(message);
+}
+
+// Group the following writes into one transaction until
+// log_database_batch_end(), so a page of archived messages costs a single
+// commit instead of one per message
+void
+log_database_batch_begin(void)
+{
+    if (!g_chatlog_database || g_batch_open) {
+        return;
+    }
+
+    char* err_msg = NULL;
+    if (SQLITE_OK != sqlite3_exec(g_chatlog_database, "BEGIN TRANSACTION;", NULL, 0, &err_msg)) {
+        log_error("SQLite error in log_database_batch_begin(): %s", err_msg ? err_msg : "unknown");
+        sqlite3_free(err_msg);
+        return;
+    }
+    g_batch_open = TRUE;
+}
+
+void
+log_database_batch_end(void)
+{
+    if (!g_chatlog_database || !g_batch_open) {
+        return;
+    }
+
+    g_batch_open = FALSE;
+    char* err_msg = NULL;
+    if (SQLITE_OK != sqlite3_exec(g_chatlog_database, "COMMIT;", NULL, 0, &err_msg)) {
+        log_error("SQLite error in log_database_batch_end(): %s", err_msg ? err_msg : "unknown");
+        sqlite3_free(err_msg);
+    }
+}
+
 static void
 _log_database_add_outgoing(char* type, const char* const id, const char* const barejid, const char* const message, const char* const replace_id, prof_enc_t enc)
 {
@@ -315,6 +369,39 @@ log_database_get_limits_info(const gchar* const contact_barejid, gboolean is_las
     return msg;
 }
 
+// Get info (timestamp and archive_id) of the newest message we have from our
+// own server's archive, room messages carry the room's archive ids instead
+ProfMessage*
+log_database_get_last_archived(void)
+{
+    if (!g_chatlog_database) {
+        return NULL;
+    }
+
+    sqlite3_stmt* stmt = NULL;
+    const char* query = "SELECT `archive_id`, `timestamp` FROM `ChatLogs` WHERE "
+                        "`archive_id` IS NOT NULL AND `type` != 'muc' "
+                        "ORDER BY `timestamp` DESC LIMIT 1;";
+
+    if (sqlite3_prepare_v2(g_chatlog_database, query, -1, &stmt, NULL) != SQLITE_OK) {
+        log_error("SQLite error in log_database_get_last_archived(): %s", sqlite3_errmsg(g_chatlog_database));
+        return NULL;
+    }
+
+    ProfMessage* msg = message_init();
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        char* archive_id = (char*)sqlite3_column_text(stmt, 0);
+        char* date = (char*)sqlite3_column_text(stmt, 1);
+
+        msg->stanzaid = _db_strdup(archive_id);
+        msg->timestamp = g_date_time_new_from_iso8601(date, NULL);
+    }
+    sqlite3_finalize(stmt);
+
+    return msg;
+}
+
 // Query previous chats, constraints start_time and end_time. If end_time is
 // null the current time is used. from_start gets first few messages if true
 // otherwise the last ones. Flip flips the order of the results
@@ -453,6 +540,7 @@ _get_message_enc_type(const char* const encstr)
 static void
 _add_to_db(ProfMessage* message, char* type, const Jid* const from_jid, const Jid* const to_jid)
 {
+    auto_perf ProfPerfTimer timer = perf_timer_start("db.insert", NULL);
     auto_gchar gchar* pref_dblog = prefs_get_string(PREF_DBLOG);
     sqlite_int64 original_message_id = -1;
 
@@ -588,6 +676,56 @@ _add_to_db(ProfMessage* message, char* type, const Jid* const from_jid, const Ji
     }
 }
 
+static gboolean
+_archive_id_exists(const char* const archive_id)
+{
+    if (!g_chatlog_database) {
+        return FALSE;
+    }
+
+    auto_sqlite char* query = sqlite3_mprintf("SELECT 1 FROM `ChatLogs` WHERE `archive_id` = %Q LIMIT 1;", archive_id);
+    if (!query) {
+        log_error("Could not allocate memory for SQL query in _archive_id_exists()");
+        return FALSE;
+    }
+
+    gboolean exists = FALSE;
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(g_chatlog_database, query, -1, &stmt, NULL) == SQLITE_OK) {
+        exists = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    }
+
+    return exists;
+}
+
+// Give a stored message without archive id the one of its archived copy,
+// matched on the message id and sender. Returns TRUE if there was such a row.
+static gboolean
+_archive_id_attach(ProfMessage* message)
+{
+    if (!g_chatlog_database || !message->stanzaid || !message->id || !message->from_jid) {
+        return FALSE;
+    }
+
+    auto_sqlite char* query = sqlite3_mprintf("UPDATE `ChatLogs` SET `archive_id` = %Q WHERE `archive_id` IS NULL "
+                                              "AND `stanza_id` = %Q AND `from_jid` = %Q;",
+                                              message->stanzaid, message->id, message->from_jid->barejid);
+    if (!query) {
+        log_error("Could not allocate memory for SQL query in _archive_id_attach()");
+        return FALSE;
+    }
+
+    char* err_msg = NULL;
+    if (SQLITE_OK != sqlite3_exec(g_chatlog_database, query, NULL, 0, &err_msg)) {
+        log_error("SQLite error in _archive_id_attach(): %s", err_msg ? err_msg : "unknown");
+        sqlite3_free(err_msg);
+        return FALSE;
+    }
+
+    return sqlite3_changes(g_chatlog_database) > 0;
+}
+
 static int
 _get_db_version(void)
 {
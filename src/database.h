@@ -47,8 +47,12 @@ void log_database_add_incoming(ProfMessage* message);
 void log_database_add_outgoing_chat(const char* const id, const char* const barejid, const char* const message, const char* const replace_id, prof_enc_t enc);
 void log_database_add_outgoing_muc(const char* const id, const char* const barejid, const char* const message, const char* const replace_id, prof_enc_t enc);
 void log_database_add_outgoing_muc_pm(const char* const id, const char* const barejid, const char* const message, const char* const replace_id, prof_enc_t enc);
+void log_database_add_archived(ProfMessage* message);
+void log_database_batch_begin(void);
+void log_database_batch_end(void);
 GSList* log_database_get_previous_chat(const gchar* const contact_barejid, const char* start_time, char* end_time, gboolean from_start, gboolean flip);
 ProfMessage* log_database_get_limits_info(const gchar* const contact_barejid, gboolean is_last);
+ProfMessage* log_database_get_last_archived(void);
 void log_database_close(void);
 
 #endif // DATABASE_H
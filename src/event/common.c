@@ -41,6 +41,7 @@
 #include "xmpp/roster_list.h"
 #include "xmpp/muc.h"
 #include "xmpp/xmpp.h"
+#include "xmpp/roster.h"
 #include "xmpp/vcard_funcs.h"
 #include "database.h"
 #include "tools/bookmark_ignore.h"
@@ -60,6 +61,7 @@ ev_disconnect_cleanup(void)
 {
     ui_disconnected();
     session_disconnect();
+    roster_cache_close();
     roster_destroy();
     iq_autoping_timer_cancel();
     muc_invites_clear();
@@ -59,6 +59,7 @@
 #include "tools/bookmark_ignore.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/iq.h"
+#include "xmpp/message.h"
 #include "xmpp/muc.h"
 #include "xmpp/chat_session.h"
 #include "xmpp/roster_list.h"
@@ -198,6 +199,9 @@ void
 sv_ev_connection_features_received(void)
 {
     iq_feature_retrieval_complete_handler();
+    if (prefs_get_boolean(PREF_MAM)) {
+        iq_mam_sync_start();
+    }
 #ifdef HAVE_OMEMO
     omemo_publish_crypto_materials();
 #endif
@@ -460,42 +464,9 @@ sv_ev_delayed_private_message(ProfMessage* message)
     message->plain = old_plain;
 }
 
-void
-sv_ev_outgoing_carbon(ProfMessage* message)
+static void
+_sv_ev_outgoing_carbon_log(ProfMessage* message)
 {
-    ProfChatWin* chatwin = wins_get_chat(message->to_jid->barejid);
-    if (!chatwin) {
-        chatwin = chatwin_new(message->to_jid->barejid);
-    }
-
-    chat_state_active(chatwin->state);
-
-    if (message->enc == PROF_MSG_ENC_OMEMO) {
-        chatwin_outgoing_carbon(chatwin, message);
-    } else if (message->enc == PROF_MSG_ENC_OX) {
-        chatwin_outgoing_carbon(chatwin, message);
-    } else if (message->encrypted) {
-#ifdef HAVE_LIBGPGME
-        message->plain = p_gpg_decrypt(message->encrypted);
-        if (message->plain) {
-            message->enc = PROF_MSG_ENC_PGP;
-            chatwin_outgoing_carbon(chatwin, message);
-        } else {
-            if (!message->body) {
-                log_error("Couldn't decrypt GPG message and body was empty");
-                return;
-            }
-            message->enc = PROF_MSG_ENC_NONE;
-            message->plain = strdup(message->body);
-            chatwin_outgoing_carbon(chatwin, message);
-        }
-#endif
-    } else {
-        message->enc = PROF_MSG_ENC_NONE;
-        message->plain = strdup(message->body);
-        chatwin_outgoing_carbon(chatwin, message);
-    }
-
     if (message->plain) {
         if (message->type == PROF_MSG_TYPE_MUCPM) {
             // MUC PM, should have resource (nick) in filename
@@ -505,20 +476,91 @@ sv_ev_outgoing_carbon(ProfMessage* message)
         }
         log_database_add_incoming(message);
     }
-    return;
+}
+
+#ifdef HAVE_LIBGPGME
+// A PGP message waiting for the worker to decrypt it
+typedef struct pgp_pending_message_t
+{
+    ProfMessage* message;
+    char* barejid; // of its chat window
+    gboolean new_win;
+    gboolean logit;
+} PgpPendingMessage;
+
+static PgpPendingMessage*
+_pgp_pending_new(ProfMessage* message, const char* const barejid, gboolean new_win, gboolean logit)
+{
+    PgpPendingMessage* pending = malloc(sizeof(PgpPendingMessage));
+    pending->message = message_move(message);
+    pending->barejid = strdup(barejid);
+    pending->new_win = new_win;
+    pending->logit = logit;
+
+    return pending;
 }
 
 static void
-_sv_ev_incoming_pgp(ProfChatWin* chatwin, gboolean new_win, ProfMessage* message, gboolean logit)
+_pgp_pending_free(PgpPendingMessage* pending)
 {
-#ifdef HAVE_LIBGPGME
-    message->plain = p_gpg_decrypt(message->encrypted);
+    if (pending) {
+        if (pending->message) {
+            message_free(pending->message);
+        }
+        free(pending->barejid);
+        free(pending);
+    }
+}
+
+static ProfChatWin*
+_pgp_pending_chatwin(PgpPendingMessage* pending)
+{
+    ProfChatWin* chatwin = wins_get_chat(pending->barejid);
+    if (!chatwin) {
+        // closed while the message was decrypted
+        chatwin = chatwin_new(pending->barejid);
+        pending->new_win = TRUE;
+    }
+
+    return chatwin;
+}
+
+static void
+_sv_ev_outgoing_carbon_pgp_decrypted(char* plain, void* userdata)
+{
+    PgpPendingMessage* pending = userdata;
+    ProfMessage* message = pending->message;
+    ProfChatWin* chatwin = _pgp_pending_chatwin(pending);
+
+    message->plain = plain;
+    if (message->plain) {
+        message->enc = PROF_MSG_ENC_PGP;
+    } else {
+        if (!message->body) {
+            log_error("Couldn't decrypt GPG message and body was empty");
+            return;
+        }
+        message->enc = PROF_MSG_ENC_NONE;
+        message->plain = strdup(message->body);
+    }
+    chatwin_outgoing_carbon(chatwin, message);
+    _sv_ev_outgoing_carbon_log(message);
+}
+
+static void
+_sv_ev_incoming_pgp_decrypted(char* plain, void* userdata)
+{
+    PgpPendingMessage* pending = userdata;
+    ProfMessage* message = pending->message;
+    ProfChatWin* chatwin = _pgp_pending_chatwin(pending);
+
+    message->plain = plain;
     if (message->plain) {
         message->enc = PROF_MSG_ENC_PGP;
         _clean_incoming_message(message);
-        chatwin_incoming_msg(chatwin, message, new_win);
+        chatwin_incoming_msg(chatwin, message, pending->new_win);
         log_database_add_incoming(message);
-        if (logit) {
+        if (pending->logit) {
             chat_log_pgp_msg_in(message);
         }
         chatwin->pgp_recv = TRUE;
@@ -532,11 +574,53 @@ _sv_ev_incoming_pgp(ProfChatWin* chatwin, gboolean new_win, ProfMessage* message
         message->enc = PROF_MSG_ENC_NONE;
         message->plain = strdup(message->body);
         _clean_incoming_message(message);
-        chatwin_incoming_msg(chatwin, message, new_win);
+        chatwin_incoming_msg(chatwin, message, pending->new_win);
         log_database_add_incoming(message);
         chat_log_msg_in(message);
         chatwin->pgp_recv = FALSE;
     }
+
+    rosterwin_roster();
+}
+#endif
+
+void
+sv_ev_outgoing_carbon(ProfMessage* message)
+{
+    ProfChatWin* chatwin = wins_get_chat(message->to_jid->barejid);
+    if (!chatwin) {
+        chatwin = chatwin_new(message->to_jid->barejid);
+    }
+
+    chat_state_active(chatwin->state);
+
+    if (message->enc == PROF_MSG_ENC_OMEMO) {
+        chatwin_outgoing_carbon(chatwin, message);
+    } else if (message->enc == PROF_MSG_ENC_OX) {
+        chatwin_outgoing_carbon(chatwin, message);
+    } else if (message->encrypted) {
+#ifdef HAVE_LIBGPGME
+        // shown and logged once decrypted
+        PgpPendingMessage* pending = _pgp_pending_new(message, chatwin->barejid, FALSE, TRUE);
+        p_gpg_decrypt_async(pending->message->encrypted, _sv_ev_outgoing_carbon_pgp_decrypted, pending, (GDestroyNotify)_pgp_pending_free);
+#endif
+        return;
+    } else {
+        message->enc = PROF_MSG_ENC_NONE;
+        message->plain = strdup(message->body);
+        chatwin_outgoing_carbon(chatwin, message);
+    }
+
+    _sv_ev_outgoing_carbon_log(message);
+}
+
+// Decrypting can wait on gpg-agent, the message is shown once the worker is done
+static void
+_sv_ev_incoming_pgp(ProfChatWin* chatwin, gboolean new_win, ProfMessage* message, gboolean logit)
+{
+#ifdef HAVE_LIBGPGME
+    PgpPendingMessage* pending = _pgp_pending_new(message, chatwin->barejid, new_win, logit);
+    p_gpg_decrypt_async(pending->message->encrypted, _sv_ev_incoming_pgp_decrypted, pending, (GDestroyNotify)_pgp_pending_free);
 #endif
 }
 
@@ -622,6 +706,28 @@ _sv_ev_incoming_plain(ProfChatWin* chatwin, gboolean new_win, ProfMessage* messa
     }
 }
 
+// Message paged in by the background archive sync, stored without
+// touching any window. PGP messages are stored encrypted, bulk decrypting
+// old messages here would stall the UI.
+void
+sv_ev_archived_message(ProfMessage* message)
+{
+    if (!message->plain) {
+        if (message->encrypted) {
+            // keep the ciphertext, the next sync resumes after this message
+            message->enc = PROF_MSG_ENC_PGP;
+            message->plain = strdup(message->encrypted);
+        } else if (message->body) {
+            message->enc = PROF_MSG_ENC_NONE;
+            message->plain = strdup(message->body);
+        } else {
+            return;
+        }
+    }
+    _clean_incoming_message(message);
+    log_database_add_archived(message);
+}
+
 void
 sv_ev_incoming_message(ProfMessage* message)
 {
@@ -1301,7 +1407,7 @@ sv_ev_bookmark_autojoin(Bookmark* bookmark)
     if (bookmark->nick) {
         nick = strdup(bookmark->nick);
     } else {
-        ProfAccount* account = accounts_get_account(session_get_account_name());
+        ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
         nick = strdup(account->muc_nick);
         account_free(account);
     }
@@ -50,6 +50,7 @@ void sv_ev_room_subject(const char* const room, const char* const nick, const ch
 void sv_ev_room_history(ProfMessage* message);
 void sv_ev_room_message(ProfMessage* message);
 void sv_ev_incoming_message(ProfMessage* message);
+void sv_ev_archived_message(ProfMessage* message);
 void sv_ev_incoming_private_message(ProfMessage* message);
 void sv_ev_delayed_private_message(ProfMessage* message);
 void sv_ev_typing(char* barejid, char* resource);
@@ -61,6 +61,7 @@ static char* log_file = NULL;
 static char* account_name = NULL;
 static char* config_file = NULL;
 static char* theme_name = NULL;
+static gboolean startup_trace = FALSE;
 
 int
 main(int argc, char** argv)
@@ -82,6 +83,7 @@ main(int argc, char** argv)
         { "config", 'c', 0, G_OPTION_ARG_STRING, &config_file, "Use an alternative configuration file", NULL },
         { "logfile", 'f', 0, G_OPTION_ARG_STRING, &log_file, "Specify log file", NULL },
         { "theme", 't', 0, G_OPTION_ARG_STRING, &theme_name, "Specify theme name", NULL },
+        { "startup-trace", 0, 0, G_OPTION_ARG_NONE, &startup_trace, "Show how long each startup phase took", NULL },
         { NULL }
     };
 
@@ -171,7 +173,7 @@ main(int argc, char** argv)
     }
 
     /* Default logging WARN */
-    prof_run(log ? log : "WARN", account_name, config_file, log_file, theme_name);
+    prof_run(log ? log : "WARN", account_name, config_file, log_file, theme_name, startup_trace);
 
     /* Free resources allocated by GOptionContext */
     g_free(log);
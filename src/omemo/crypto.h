@@ -184,8 +184,16 @@ int aes128gcm_decrypt(unsigned char* plaintext,
                       size_t ciphertext_len, const unsigned char* const iv, size_t iv_len,
                       const unsigned char* const key, const unsigned char* const tag);
 
-gcry_error_t aes256gcm_crypt_file(FILE* in, FILE* out, off_t file_size,
-                                  unsigned char key[], unsigned char nonce[], bool encrypt);
+/**
+ * Open an AES-256-GCM cipher handle for incremental encryption or
+ * decryption, e.g. of a file that is streamed over HTTP.
+ *
+ * @param hd cipher handle to be opened, NULL on failure
+ * @param key the key (OMEMO_AESGCM_KEY_LENGTH bytes)
+ * @param nonce the nonce (OMEMO_AESGCM_NONCE_LENGTH bytes)
+ * @return GPG_ERR_NO_ERROR on success
+ */
+gcry_error_t aes256gcm_cipher_open(gcry_cipher_hd_t* hd, const unsigned char key[], const unsigned char nonce[]);
 
 char* aes256gcm_create_secure_fragment(unsigned char* key,
                                        unsigned char* nonce);
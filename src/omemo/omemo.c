@@ -55,6 +55,7 @@
 #include "omemo/crypto.h"
 #include "omemo/omemo.h"
 #include "omemo/store.h"
+#include "tools/perf.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/connection.h"
@@ -66,6 +67,8 @@
 #define AESGCM_URL_NONCE_LEN (2 * OMEMO_AESGCM_NONCE_LENGTH)
 #define AESGCM_URL_KEY_LEN   (2 * OMEMO_AESGCM_KEY_LENGTH)
 
+#define OMEMO_AESGCM_STREAM_BUFFER_SIZE 4096
+
 static void _generate_pre_keys(int count);
 static void _generate_signed_pre_key(void);
 static gboolean _load_identity(void);
@@ -109,6 +112,17 @@ typedef struct omemo_context
 
 static omemo_context omemo_ctx;
 
+// AES-256-GCM state of a file that is encrypted or decrypted while it is
+// being transferred, see XEP-0454.
+struct omemo_aesgcm_stream_t
+{
+    gcry_cipher_hd_t hd;
+    off_t remaining;
+    unsigned char tag[OMEMO_AESGCM_TAG_LENGTH];
+    size_t tag_len;
+    size_t tag_pos;
+};
+
 static struct omemo_static_data
 {
     pthread_mutexattr_t attr;
@@ -680,6 +694,7 @@ out:
 char*
 omemo_on_message_send(ProfWin* win, const char* const message, gboolean request_receipt, gboolean muc, const char* const replace_id)
 {
+    auto_perf ProfPerfTimer timer = perf_timer_start("omemo.encrypt", NULL);
     char* id = NULL;
     int res;
     const Jid* jid = connection_get_jid();
@@ -871,6 +886,7 @@ omemo_on_message_recv(const char* const from_jid, uint32_t sid,
                       const unsigned char* const iv, size_t iv_len, GList* keys,
                       const unsigned char* const payload, size_t payload_len, gboolean muc, gboolean* trusted)
 {
+    auto_perf ProfPerfTimer timer = perf_timer_start("omemo.decrypt", NULL);
     unsigned char* plaintext = NULL;
     auto_jid Jid* sender = NULL;
     auto_jid Jid* from = jid_create(from_jid);
@@ -1346,26 +1362,11 @@ omemo_fingerprint_autocomplete(const char* const search_str, gboolean previous,
     }
 }
 
-void
-omemo_fingerprint_autocomplete_reset(void)
-{
-    if (!omemo_static_data.fingerprint_ac)
-        return;
-    gpointer value;
-    GHashTableIter iter;
-    g_hash_table_iter_init(&iter, omemo_static_data.fingerprint_ac);
-
-    while (g_hash_table_iter_next(&iter, NULL, &value)) {
-        Autocomplete ac = value;
-        autocomplete_reset(ac);
-    }
-}
-
 gboolean
 omemo_automatic_start(const char* const recipient)
 {
     gboolean result = FALSE;
-    ProfAccount* account = accounts_get_account(session_get_account_name());
+    ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
     prof_omemopolicy_t policy;
 
     if (account->omemo_policy) {
@@ -1672,8 +1673,8 @@ omemo_free(void* a)
     gcry_free(a);
 }
 
-char*
-omemo_encrypt_file(FILE* in, FILE* out, off_t file_size, int* gcry_res)
+OmemoAesgcmStream*
+omemo_encrypt_stream_new(off_t file_size, char** fragment)
 {
     unsigned char* key = gcry_random_bytes_secure(
         OMEMO_AESGCM_KEY_LENGTH,
@@ -1683,17 +1684,77 @@ omemo_encrypt_file(FILE* in, FILE* out, off_t file_size, int* gcry_res)
     unsigned char nonce[OMEMO_AESGCM_NONCE_LENGTH];
     gcry_create_nonce(nonce, OMEMO_AESGCM_NONCE_LENGTH);
 
-    char* fragment = aes256gcm_create_secure_fragment(key, nonce);
-    *gcry_res = aes256gcm_crypt_file(in, out, file_size, key, nonce, true);
-
-    if (*gcry_res != GPG_ERR_NO_ERROR) {
-        gcry_free(fragment);
-        fragment = NULL;
+    OmemoAesgcmStream* stream = g_new0(OmemoAesgcmStream, 1);
+    gcry_error_t res = aes256gcm_cipher_open(&stream->hd, key, nonce);
+    if (res != GPG_ERR_NO_ERROR) {
+        log_error("[OMEMO] cannot set up file encryption: %s", gcry_strerror(res));
+        g_free(stream);
+        stream = NULL;
+        *fragment = NULL;
+    } else {
+        stream->remaining = file_size;
+        *fragment = aes256gcm_create_secure_fragment(key, nonce);
     }
 
     gcry_free(key);
 
-    return fragment;
+    return stream;
+}
+
+size_t
+omemo_encrypt_stream_read(OmemoAesgcmStream* stream, FILE* in, unsigned char* buffer, size_t size, gcry_error_t* gcry_res)
+{
+    *gcry_res = GPG_ERR_NO_ERROR;
+
+    if (stream->remaining > 0) {
+        size_t read_size = size;
+        if ((off_t)size >= stream->remaining) {
+            read_size = (size_t)stream->remaining;
+            gcry_cipher_final(stream->hd); // Signal last round of bytes.
+        }
+
+        // Anything short of the announced size means the file was truncated
+        // or became unreadable while uploading.
+        size_t bytes = fread(buffer, 1, read_size, in);
+        if (bytes != read_size) {
+            *gcry_res = gcry_error(GPG_ERR_TRUNCATED);
+            return 0;
+        }
+
+        *gcry_res = gcry_cipher_encrypt(stream->hd, buffer, bytes, NULL, 0);
+        if (*gcry_res != GPG_ERR_NO_ERROR) {
+            return 0;
+        }
+
+        stream->remaining -= bytes;
+        return bytes;
+    }
+
+    // All plaintext has been consumed, append the authentication tag.
+    if (stream->tag_len == 0) {
+        *gcry_res = gcry_cipher_gettag(stream->hd, stream->tag, OMEMO_AESGCM_TAG_LENGTH);
+        if (*gcry_res != GPG_ERR_NO_ERROR) {
+            return 0;
+        }
+        stream->tag_len = OMEMO_AESGCM_TAG_LENGTH;
+    }
+
+    size_t bytes = MIN(size, stream->tag_len - stream->tag_pos);
+    memcpy(buffer, &stream->tag[stream->tag_pos], bytes);
+    stream->tag_pos += bytes;
+
+    return bytes;
+}
+
+void
+omemo_aesgcm_stream_free(OmemoAesgcmStream* stream)
+{
+    if (stream == NULL) {
+        return;
+    }
+
+    gcry_cipher_close(stream->hd);
+    g_free(stream);
 }
 
 void
@@ -1722,8 +1783,8 @@ _bytes_from_hex(const char* hex, size_t hex_size,
     }
 }
 
-gcry_error_t
-omemo_decrypt_file(FILE* in, FILE* out, off_t file_size, const char* fragment)
+OmemoAesgcmStream*
+omemo_decrypt_stream_new(const char* fragment)
 {
     char nonce_hex[AESGCM_URL_NONCE_LEN];
     char key_hex[AESGCM_URL_KEY_LEN];
@@ -1742,12 +1803,68 @@ omemo_decrypt_file(FILE* in, FILE* out, off_t file_size, const char* fragment)
     _bytes_from_hex(key_hex, AESGCM_URL_KEY_LEN,
                     key, OMEMO_AESGCM_KEY_LENGTH);
 
-    gcry_error_t crypt_res;
-    crypt_res = aes256gcm_crypt_file(in, out, file_size, key, nonce, false);
+    OmemoAesgcmStream* stream = g_new0(OmemoAesgcmStream, 1);
+    gcry_error_t res = aes256gcm_cipher_open(&stream->hd, key, nonce);
+    if (res != GPG_ERR_NO_ERROR) {
+        log_error("[OMEMO] cannot set up file decryption: %s", gcry_strerror(res));
+        g_free(stream);
+        stream = NULL;
+    }
 
     gcry_free(key);
 
-    return crypt_res;
+    return stream;
+}
+
+gcry_error_t
+omemo_decrypt_stream_write(OmemoAesgcmStream* stream, const unsigned char* data, size_t len, FILE* out)
+{
+    unsigned char buffer[OMEMO_AESGCM_STREAM_BUFFER_SIZE];
+    gcry_error_t res;
+
+    // The authentication tag is stored at the end of the file, so the last
+    // bytes received so far are held back until more data arrives.
+    while (len > 0) {
+        size_t total = stream->tag_len + len;
+        if (total <= OMEMO_AESGCM_TAG_LENGTH) {
+            memcpy(&stream->tag[stream->tag_len], data, len);
+            stream->tag_len += len;
+            break;
+        }
+
+        size_t bytes = MIN(total - OMEMO_AESGCM_TAG_LENGTH, sizeof(buffer));
+
+        size_t held_bytes = MIN(bytes, stream->tag_len);
+        memcpy(buffer, stream->tag, held_bytes);
+        memmove(stream->tag, &stream->tag[held_bytes], stream->tag_len - held_bytes);
+        stream->tag_len -= held_bytes;
+
+        size_t data_bytes = bytes - held_bytes;
+        memcpy(&buffer[held_bytes], data, data_bytes);
+        data += data_bytes;
+        len -= data_bytes;
+
+        res = gcry_cipher_decrypt(stream->hd, buffer, bytes, NULL, 0);
+        if (res != GPG_ERR_NO_ERROR) {
+            return res;
+        }
+
+        if (fwrite(buffer, 1, bytes, out) != bytes) {
+            return gcry_error_from_errno(errno);
+        }
+    }
+
+    return GPG_ERR_NO_ERROR;
+}
+
+gcry_error_t
+omemo_decrypt_stream_finish(OmemoAesgcmStream* stream)
+{
+    if (stream->tag_len != OMEMO_AESGCM_TAG_LENGTH) {
+        return gcry_error(GPG_ERR_CHECKSUM);
+    }
+
+    return gcry_cipher_checktag(stream->hd, stream->tag, stream->tag_len);
 }
 
 int
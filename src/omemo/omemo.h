@@ -43,6 +43,7 @@
 
 #define OMEMO_AESGCM_NONCE_LENGTH AES128_GCM_IV_LENGTH
 #define OMEMO_AESGCM_KEY_LENGTH   32
+#define OMEMO_AESGCM_TAG_LENGTH   16
 #define OMEMO_AESGCM_URL_SCHEME   "aesgcm"
 
 typedef enum {
@@ -51,6 +52,8 @@ typedef enum {
     PROF_OMEMOPOLICY_ALWAYS
 } prof_omemopolicy_t;
 
+typedef struct omemo_aesgcm_stream_t OmemoAesgcmStream;
+
 typedef struct omemo_key
 {
     unsigned char* data;
@@ -87,7 +90,6 @@ void omemo_untrust(const char* const jid, const char* const fingerprint);
 GList* omemo_known_device_identities(const char* const jid);
 gboolean omemo_is_trusted_identity(const char* const jid, const char* const fingerprint);
 char* omemo_fingerprint_autocomplete(const char* const search_str, gboolean previous, void* context);
-void omemo_fingerprint_autocomplete_reset(void);
 gboolean omemo_automatic_start(const char* const recipient);
 
 void omemo_start_sessions(void);
@@ -99,8 +101,12 @@ gboolean omemo_loaded(void);
 char* omemo_on_message_send(ProfWin* win, const char* const message, gboolean request_receipt, gboolean muc, const char* const replace_id);
 char* omemo_on_message_recv(const char* const from, uint32_t sid, const unsigned char* const iv, size_t iv_len, GList* keys, const unsigned char* const payload, size_t payload_len, gboolean muc, gboolean* trusted);
 
-char* omemo_encrypt_file(FILE* in, FILE* out, off_t file_size, int* gcry_res);
-gcry_error_t omemo_decrypt_file(FILE* in, FILE* out, off_t file_size, const char* fragment);
+OmemoAesgcmStream* omemo_encrypt_stream_new(off_t file_size, char** fragment);
+size_t omemo_encrypt_stream_read(OmemoAesgcmStream* stream, FILE* in, unsigned char* buffer, size_t size, gcry_error_t* gcry_res);
+OmemoAesgcmStream* omemo_decrypt_stream_new(const char* fragment);
+gcry_error_t omemo_decrypt_stream_write(OmemoAesgcmStream* stream, const unsigned char* data, size_t len, FILE* out);
+gcry_error_t omemo_decrypt_stream_finish(OmemoAesgcmStream* stream);
+void omemo_aesgcm_stream_free(OmemoAesgcmStream* stream);
 void omemo_free(void* a);
 int omemo_parse_aesgcm_url(const char* aesgcm_url, char** https_url, char** fragment);
 
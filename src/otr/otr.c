@@ -65,6 +65,28 @@ static char* jid;
 static gboolean data_loaded;
 static GHashTable* smp_initiators;
 
+#define OTR_KEYGEN_PROGRESS_SECONDS 5
+
+typedef struct otr_keygen_t
+{
+    void* newkey;
+    OtrlUserState user_state; // holds newkey in its pending list
+    gboolean owns_user_state;
+    char* jid;
+    gchar* keysfilename;
+    gchar* fpsfilename;
+    guint generation;
+    gint64 started;
+    gcry_error_t err;
+} OtrKeygen;
+
+// key generation in progress, NULL when idle
+static OtrKeygen* keygen;
+static guint keygen_generation;
+static guint keygen_progress_id;
+
+static void _otr_keygen_abandon(void);
+
 OtrlUserState
 otr_userstate(void)
 {
@@ -190,6 +212,7 @@ otr_init(void)
 void
 otr_shutdown(void)
 {
+    _otr_keygen_abandon();
     if (jid) {
         free(jid);
         jid = NULL;
@@ -219,9 +242,14 @@ otr_on_connect(ProfAccount* account)
         return;
     }
 
-    if (user_state) {
+    if (keygen) {
+        // the worker is still computing the key pending in this user state,
+        // keep the user state alive until the job is done with it
+        keygen->owns_user_state = TRUE;
+    } else if (user_state) {
         otrl_userstate_free(user_state);
     }
+    _otr_keygen_abandon();
     user_state = otrl_userstate_create();
 
     gcry_error_t err = 0;
@@ -358,37 +386,48 @@ otr_on_message_send(ProfChatWin* chatwin, const char* const message, gboolean re
     return FALSE;
 }
 
-void
-otr_keygen(ProfAccount* account)
+static gboolean
+_otr_keygen_progress(gpointer data)
 {
-    if (data_loaded) {
-        cons_show("OTR key already generated.");
-        return;
+    if (!keygen) {
+        keygen_progress_id = 0;
+        return G_SOURCE_REMOVE;
     }
 
-    free(jid);
-    jid = strdup(account->jid);
-    log_info("Generating OTR key for %s", jid);
+    gint64 elapsed = (g_get_monotonic_time() - keygen->started) / G_USEC_PER_SEC;
+    cons_show("Still generating private key (%" G_GINT64_FORMAT "s)…", elapsed);
 
-    auto_gchar gchar* otr_dir = files_file_in_account_data_path(DIR_OTR, jid, NULL);
+    return G_SOURCE_CONTINUE;
+}
 
-    if (!otr_dir) {
-        log_error("Could not create directory for account %s.", jid);
-        cons_show_error("Could not create directory for account %s.", jid);
-        return;
+static void
+_otr_keygen_free(OtrKeygen* job)
+{
+    if (job) {
+        free(job->jid);
+        g_free(job->keysfilename);
+        g_free(job->fpsfilename);
+        free(job);
     }
+}
 
-    gcry_error_t err = 0;
+// drop the generation in progress, its result is discarded when the worker finishes
+static void
+_otr_keygen_abandon(void)
+{
+    keygen_generation++;
+    keygen = NULL;
+    if (keygen_progress_id) {
+        g_source_remove(keygen_progress_id);
+        keygen_progress_id = 0;
+    }
+}
 
-    GString* keysfilename = g_string_new(otr_dir);
-    g_string_append(keysfilename, "/keys.txt");
-    log_debug("Generating private key file %s for %s", keysfilename->str, jid);
-    cons_show("Generating private key, this may take some time.");
-    cons_show("Moving the mouse randomly around the screen may speed up the process!");
-    ui_update();
-    err = otrl_privkey_generate(user_state, keysfilename->str, account->jid, "xmpp");
+static void
+_otr_keygen_finish(OtrKeygen* job)
+{
+    gcry_error_t err = otrl_privkey_generate_finish(user_state, job->newkey, job->keysfilename);
     if (err != GPG_ERR_NO_ERROR) {
-        g_string_free(keysfilename, TRUE);
         log_error("Failed to generate private key");
         cons_show_error("Failed to generate private key");
         return;
@@ -397,39 +436,122 @@ otr_keygen(ProfAccount* account)
     cons_show("");
     cons_show("Private key generation complete.");
 
-    GString* fpsfilename = g_string_new(otr_dir);
-    g_string_append(fpsfilename, "/fingerprints.txt");
-    log_debug("Generating fingerprints file %s for %s", fpsfilename->str, jid);
-    err = otrl_privkey_write_fingerprints(user_state, fpsfilename->str);
+    log_debug("Generating fingerprints file %s for %s", job->fpsfilename, job->jid);
+    err = otrl_privkey_write_fingerprints(user_state, job->fpsfilename);
     if (err != GPG_ERR_NO_ERROR) {
-        g_string_free(keysfilename, TRUE);
         log_error("Failed to create fingerprints file");
         cons_show_error("Failed to create fingerprints file");
         return;
     }
     log_info("Fingerprints file created");
 
-    err = otrl_privkey_read(user_state, keysfilename->str);
+    err = otrl_privkey_read(user_state, job->keysfilename);
     if (err != GPG_ERR_NO_ERROR) {
-        g_string_free(keysfilename, TRUE);
         log_error("Failed to load private key");
         data_loaded = FALSE;
         return;
     }
 
-    err = otrl_privkey_read_fingerprints(user_state, fpsfilename->str, NULL, NULL);
+    err = otrl_privkey_read_fingerprints(user_state, job->fpsfilename, NULL, NULL);
     if (err != GPG_ERR_NO_ERROR) {
-        g_string_free(keysfilename, TRUE);
         log_error("Failed to load fingerprints");
         data_loaded = FALSE;
         return;
     }
 
     data_loaded = TRUE;
+}
 
-    g_string_free(keysfilename, TRUE);
-    g_string_free(fpsfilename, TRUE);
-    return;
+// runs on the main loop once the worker thread is done
+static gboolean
+_otr_keygen_done(gpointer data)
+{
+    OtrKeygen* job = data;
+
+    if (job->generation != keygen_generation) {
+        log_info("Discarding OTR private key generated for %s, the account was disconnected", job->jid);
+        otrl_privkey_generate_cancelled(job->user_state, job->newkey);
+        if (job->owns_user_state) {
+            otrl_userstate_free(job->user_state);
+        }
+        _otr_keygen_free(job);
+        return G_SOURCE_REMOVE;
+    }
+
+    _otr_keygen_abandon();
+
+    if (job->err != GPG_ERR_NO_ERROR) {
+        log_error("Failed to generate private key: %s", gcry_strerror(job->err));
+        cons_show_error("Failed to generate private key");
+        otrl_privkey_generate_cancelled(user_state, job->newkey);
+    } else {
+        _otr_keygen_finish(job);
+    }
+
+    _otr_keygen_free(job);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer
+_otr_keygen_calculate(gpointer data)
+{
+    OtrKeygen* job = data;
+
+    // only touches the pending key, user_state stays with the main thread
+    job->err = otrl_privkey_generate_calculate(job->newkey);
+    g_idle_add(_otr_keygen_done, job);
+
+    return NULL;
+}
+
+void
+otr_keygen(ProfAccount* account)
+{
+    if (data_loaded) {
+        cons_show("OTR key already generated.");
+        return;
+    }
+
+    if (keygen) {
+        cons_show("OTR key generation already in progress.");
+        return;
+    }
+
+    free(jid);
+    jid = strdup(account->jid);
+    log_info("Generating OTR key for %s", jid);
+
+    auto_gchar gchar* otr_dir = files_file_in_account_data_path(DIR_OTR, jid, NULL);
+
+    if (!otr_dir) {
+        log_error("Could not create directory for account %s.", jid);
+        cons_show_error("Could not create directory for account %s.", jid);
+        return;
+    }
+
+    void* newkey = NULL;
+    gcry_error_t err = otrl_privkey_generate_start(user_state, account->jid, "xmpp", &newkey);
+    if (err != GPG_ERR_NO_ERROR) {
+        log_error("Failed to start private key generation: %s", gcry_strerror(err));
+        cons_show_error("Failed to generate private key");
+        return;
+    }
+
+    keygen = calloc(1, sizeof(OtrKeygen));
+    keygen->newkey = newkey;
+    keygen->user_state = user_state;
+    keygen->jid = strdup(account->jid);
+    keygen->keysfilename = g_strdup_printf("%s/keys.txt", otr_dir);
+    keygen->fpsfilename = g_strdup_printf("%s/fingerprints.txt", otr_dir);
+    keygen->generation = keygen_generation;
+    keygen->started = g_get_monotonic_time();
+
+    log_debug("Generating private key file %s for %s", keygen->keysfilename, jid);
+    cons_show("Generating private key in the background, this may take some time.");
+    cons_show("Moving the mouse randomly around the screen may speed up the process!");
+
+    keygen_progress_id = g_timeout_add_seconds(OTR_KEYGEN_PROGRESS_SECONDS, _otr_keygen_progress, NULL);
+    g_thread_unref(g_thread_new("otr-keygen", _otr_keygen_calculate, keygen));
 }
 
 gboolean
@@ -634,7 +756,7 @@ otr_get_their_fingerprint(const char* const recipient)
 prof_otrpolicy_t
 otr_get_policy(const char* const recipient)
 {
-    ProfAccount* account = accounts_get_account(session_get_account_name());
+    ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
     // check contact specific setting
     if (g_list_find_custom(account->otr_manual, recipient, (GCompareFunc)g_strcmp0)) {
         account_free(account);
@@ -71,6 +71,54 @@ static char* passphrase_attempt;
 
 static Autocomplete key_ac;
 
+// Contexts are reused between operations instead of creating one per call,
+// key lookups and the key listing are cached until the keyring files change.
+// gpg_lock guards what is shared with the worker thread.
+#define GPG_CTX_POOL_SIZE 4
+
+static GMutex gpg_lock;
+static GQueue ctx_pool = G_QUEUE_INIT;
+static GHashTable* key_handles = NULL; // "<secret>:<id>" -> gpgme_key_t
+static gchar* keyring_stamp = NULL;    // size and mtime of the keyring files the caches belong to
+static GHashTable* keys_cache = NULL;  // last keyring listing, see p_gpg_list_keys()
+
+// Requests run one after the other on the worker thread, their results are
+// handed back to the main loop. p_gpg_close() drops the requests still queued
+// and the results of those in flight.
+typedef struct gpg_request_t
+{
+    void (*run)(struct gpg_request_t* request); // on the worker thread, must not log or touch the UI
+    GSourceFunc done;                           // on the main loop, frees the request
+    guint generation;
+} GpgRequest;
+
+typedef struct gpg_verify_request_t
+{
+    GpgRequest base;
+    char* barejid;
+    char* sign;
+    char* keyid;
+    char* fpr;
+    char* error;
+} GpgVerifyRequest;
+
+typedef struct gpg_decrypt_request_t
+{
+    GpgRequest base;
+    char* cipher;
+    char* passphrase; // the cached one when pushed, the worker can't ask for it
+    char* plain;
+    char* recipients;
+    gpgme_error_t error;
+    ProfGpgDecryptCallback callback;
+    void* userdata;
+    GDestroyNotify userdata_free;
+} GpgDecryptRequest;
+
+static GThreadPool* gpg_worker = NULL;
+static guint gpg_generation = 0;
+static GQueue gpg_queued = G_QUEUE_INIT; // pushed but not yet started, guarded by gpg_lock
+
 static char* _remove_header_footer(char* str, const char* const footer);
 static char* _add_header_footer(const char* const str, const char* const header, const char* const footer);
 static char* _gpgme_data_to_char(gpgme_data_t data);
@@ -86,6 +134,153 @@ _p_gpg_free_pubkeyid(ProfPGPPubKeyId* pubkeyid)
     free(pubkeyid);
 }
 
+static gpgme_ctx_t
+_p_gpg_ctx_acquire(void)
+{
+    g_mutex_lock(&gpg_lock);
+    gpgme_ctx_t ctx = g_queue_pop_head(&ctx_pool);
+    g_mutex_unlock(&gpg_lock);
+
+    if (ctx == NULL && gpgme_new(&ctx) != GPG_ERR_NO_ERROR) {
+        return NULL;
+    }
+
+    return ctx;
+}
+
+static void
+_p_gpg_ctx_release(gpgme_ctx_t ctx)
+{
+    if (ctx == NULL) {
+        return;
+    }
+
+    // back to the state of a new context
+    gpgme_signers_clear(ctx);
+    gpgme_set_armor(ctx, 0);
+    gpgme_set_passphrase_cb(ctx, NULL, NULL);
+
+    g_mutex_lock(&gpg_lock);
+    if (g_queue_get_length(&ctx_pool) < GPG_CTX_POOL_SIZE) {
+        g_queue_push_head(&ctx_pool, ctx);
+        ctx = NULL;
+    }
+    g_mutex_unlock(&gpg_lock);
+
+    if (ctx) {
+        gpgme_release(ctx);
+    }
+}
+
+// Like gpgme_get_key() but served from key_handles when possible, the caller owns a reference
+static gpgme_error_t
+_p_gpg_get_key(gpgme_ctx_t ctx, const char* const id, int secret, gpgme_key_t* key)
+{
+    auto_gchar gchar* handle = g_strdup_printf("%d:%s", secret, id);
+
+    g_mutex_lock(&gpg_lock);
+    *key = key_handles ? g_hash_table_lookup(key_handles, handle) : NULL;
+    if (*key) {
+        gpgme_key_ref(*key);
+    }
+    g_mutex_unlock(&gpg_lock);
+
+    if (*key) {
+        return GPG_ERR_NO_ERROR;
+    }
+
+    gpgme_error_t error = gpgme_get_key(ctx, id, key, secret);
+    if (error || *key == NULL) {
+        return error;
+    }
+
+    g_mutex_lock(&gpg_lock);
+    if (key_handles == NULL) {
+        key_handles = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gpgme_key_unref);
+    }
+    gpgme_key_ref(*key);
+    g_hash_table_replace(key_handles, g_steal_pointer(&handle), *key);
+    g_mutex_unlock(&gpg_lock);
+
+    return GPG_ERR_NO_ERROR;
+}
+
+static void
+_p_gpg_caches_clear(void)
+{
+    g_mutex_lock(&gpg_lock);
+    if (key_handles) {
+        g_hash_table_destroy(key_handles);
+        key_handles = NULL;
+    }
+    g_mutex_unlock(&gpg_lock);
+
+    if (keys_cache) {
+        g_hash_table_unref(keys_cache);
+        keys_cache = NULL;
+    }
+    g_free(keyring_stamp);
+    keyring_stamp = NULL;
+}
+
+// Drops the caches when the keyring changed since they were filled
+static void
+_p_gpg_keyring_check(void)
+{
+    const char* homedir = gpgme_get_dirinfo("homedir");
+    if (homedir == NULL) {
+        return;
+    }
+
+    static const char* const files[] = { "pubring.kbx", "pubring.gpg", "secring.gpg", "private-keys-v1.d" };
+    GString* stamp = g_string_new(NULL);
+    for (size_t i = 0; i < ARRAY_SIZE(files); i++) {
+        auto_gchar gchar* path = g_build_filename(homedir, files[i], NULL);
+        GStatBuf st;
+        if (g_stat(path, &st) == 0) {
+            g_string_append_printf(stamp, "%s:%lld:%lld;", files[i], (long long)st.st_size, (long long)st.st_mtime);
+        }
+    }
+
+    if (g_strcmp0(stamp->str, keyring_stamp) != 0) {
+        if (keyring_stamp) {
+            log_debug("GPG: Keyring changed, dropping cached keys");
+        }
+        _p_gpg_caches_clear();
+        keyring_stamp = g_string_free(stamp, FALSE);
+    } else {
+        g_string_free(stamp, TRUE);
+    }
+}
+
+static void
+_p_gpg_worker_run(gpointer data, gpointer unused)
+{
+    GpgRequest* request = data;
+
+    g_mutex_lock(&gpg_lock);
+    g_queue_remove(&gpg_queued, request);
+    g_mutex_unlock(&gpg_lock);
+
+    request->run(request);
+    g_idle_add(request->done, request);
+}
+
+static void
+_p_gpg_request_push(GpgRequest* request)
+{
+    if (gpg_worker == NULL) {
+        gpg_worker = g_thread_pool_new(_p_gpg_worker_run, NULL, 1, FALSE, NULL);
+    }
+    request->generation = gpg_generation;
+
+    g_mutex_lock(&gpg_lock);
+    g_queue_push_tail(&gpg_queued, request);
+    g_mutex_unlock(&gpg_lock);
+
+    g_thread_pool_push(gpg_worker, request, NULL);
+}
+
 static gpgme_error_t*
 _p_gpg_passphrase_cb(void* hook, const char* uid_hint, const char* passphrase_info, int prev_was_bad, int fd)
 {
@@ -120,9 +315,8 @@ p_gpg_init(void)
 
     pubkeys = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_p_gpg_free_pubkeyid);
 
+    // the key list is read on first use, it can take seconds with a big keyring
     key_ac = autocomplete_new();
-    GHashTable* keys = p_gpg_list_keys();
-    p_gpg_free_keys(keys);
 
     passphrase = NULL;
     passphrase_attempt = NULL;
@@ -131,6 +325,24 @@ p_gpg_init(void)
 void
 p_gpg_close(void)
 {
+    // only the request in flight is waited for, its result is dropped
+    gpg_generation++;
+    if (gpg_worker) {
+        g_thread_pool_free(gpg_worker, TRUE, TRUE);
+        gpg_worker = NULL;
+    }
+
+    // never started, done on a request that didn't run only frees it
+    GpgRequest* request;
+    while ((request = g_queue_pop_head(&gpg_queued))) {
+        request->done(request);
+    }
+
+    _p_gpg_caches_clear();
+    g_mutex_lock(&gpg_lock);
+    g_queue_clear_full(&ctx_pool, (GDestroyNotify)gpgme_release);
+    g_mutex_unlock(&gpg_lock);
+
     if (pubkeys) {
         g_hash_table_destroy(pubkeys);
         pubkeys = NULL;
@@ -169,14 +381,13 @@ p_gpg_on_connect(const char* const barejid)
     gsize len = 0;
     auto_gcharv gchar** jids = g_key_file_get_groups(pubkeyfile, &len);
 
-    gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
-
-    if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
+        log_error("GPG: Failed to create gpgme context.");
         return;
     }
 
+    _p_gpg_keyring_check();
     for (int i = 0; i < len; i++) {
         GError* gerr = NULL;
         gchar* jid = jids[i];
@@ -186,7 +397,7 @@ p_gpg_on_connect(const char* const barejid)
             g_error_free(gerr);
         } else {
             gpgme_key_t key = NULL;
-            error = gpgme_get_key(ctx, keyid, &key, 0);
+            gpgme_error_t error = _p_gpg_get_key(ctx, keyid, 0, &key);
             if (error || key == NULL) {
                 log_warning("GPG: Failed to get key for %s: %s %s", jid, gpgme_strsource(error), gpgme_strerror(error));
                 continue;
@@ -200,7 +411,7 @@ p_gpg_on_connect(const char* const barejid)
         }
     }
 
-    gpgme_release(ctx);
+    _p_gpg_ctx_release(ctx);
 
     _save_pubkeys();
 }
@@ -216,16 +427,16 @@ p_gpg_on_disconnect(void)
 gboolean
 p_gpg_addkey(const char* const jid, const char* const keyid)
 {
-    gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
-    if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
+        log_error("GPG: Failed to create gpgme context.");
         return FALSE;
     }
 
+    _p_gpg_keyring_check();
     gpgme_key_t key = NULL;
-    error = gpgme_get_key(ctx, keyid, &key, 0);
-    gpgme_release(ctx);
+    gpgme_error_t error = _p_gpg_get_key(ctx, keyid, 0, &key);
+    _p_gpg_ctx_release(ctx);
 
     if (error || key == NULL) {
         log_error("GPG: Failed to get key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
@@ -283,21 +494,27 @@ p_gpg_free_key(ProfPGPKey* key)
  * @return A newly created GHashTable* containing ProfPGPKey objects, with the key name as the key.
  *         Returns NULL if an error occurs during key retrieval or if memory allocation fails.
  *
- * @note The returned hash table should be released using p_gpg_free_keys()
- *       when they are no longer needed to avoid memory leaks.
+ * The listing is cached and only redone after the keyring files changed.
+ *
+ * @note The returned hash table is shared with the cache, it must not be modified
+ *       and should be released using p_gpg_free_keys() when it is no longer needed.
  *
  * @note This function may perform additional operations, such as autocomplete, related to the retrieved keys.
  */
 GHashTable*
 p_gpg_list_keys(void)
 {
+    _p_gpg_keyring_check();
+    if (keys_cache) {
+        return g_hash_table_ref(keys_cache);
+    }
+
     gpgme_error_t error;
     GHashTable* result = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)p_gpg_free_key);
 
-    gpgme_ctx_t ctx;
-    error = gpgme_new(&ctx);
-    if (error) {
-        log_error("GPG: Could not create GPGME context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
+        log_error("GPG: Could not create GPGME context.");
         g_hash_table_destroy(result);
         return NULL;
     }
@@ -339,7 +556,7 @@ p_gpg_list_keys(void)
         }
     }
 
-    gpgme_release(ctx);
+    _p_gpg_ctx_release(ctx);
 
     // TODO: move autocomplete in other place
     autocomplete_clear(key_ac);
@@ -352,13 +569,17 @@ p_gpg_list_keys(void)
     }
     g_list_free(ids);
 
-    return result;
+    keys_cache = result;
+
+    return g_hash_table_ref(result);
 }
 
 void
 p_gpg_free_keys(GHashTable* keys)
 {
-    g_hash_table_destroy(keys);
+    if (keys) {
+        g_hash_table_unref(keys);
+    }
 }
 
 GHashTable*
@@ -379,29 +600,29 @@ p_gpg_libver(void)
 gboolean
 p_gpg_valid_key(const char* const keyid, char** err_str)
 {
-    gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
-    if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
+        log_error("GPG: Failed to create gpgme context.");
         if (err_str) {
-            *err_str = strdup(gpgme_strerror(error));
+            *err_str = strdup("Failed to create gpgme context");
         }
         return FALSE;
     }
 
+    _p_gpg_keyring_check();
     gpgme_key_t key = NULL;
-    error = gpgme_get_key(ctx, keyid, &key, 1);
+    gpgme_error_t error = _p_gpg_get_key(ctx, keyid, 1, &key);
 
     if (error || key == NULL) {
         log_error("GPG: Failed to get key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         if (err_str) {
             *err_str = strdup(error ? gpgme_strerror(error) : "gpgme didn't return any error, but it didn't return a key");
         }
-        gpgme_release(ctx);
+        _p_gpg_ctx_release(ctx);
         return FALSE;
     }
 
-    gpgme_release(ctx);
+    _p_gpg_ctx_release(ctx);
     gpgme_key_unref(key);
     return TRUE;
 }
@@ -413,78 +634,118 @@ p_gpg_available(const char* const barejid)
     return (pubkey != NULL);
 }
 
-void
-p_gpg_verify(const char* const barejid, const char* const sign)
+static void
+_p_gpg_verify_request_free(GpgVerifyRequest* request)
 {
-    if (!sign) {
-        return;
-    }
+    free(request->barejid);
+    free(request->sign);
+    free(request->keyid);
+    free(request->fpr);
+    g_free(request->error);
+    free(request);
+}
 
-    gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
+static void
+_p_gpg_verify_run(GpgRequest* base)
+{
+    GpgVerifyRequest* request = (GpgVerifyRequest*)base;
 
-    if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
+        request->error = g_strdup("Failed to create gpgme context.");
         return;
     }
 
-    auto_char char* sign_with_header_footer = _add_header_footer(sign, PGP_SIGNATURE_HEADER, PGP_SIGNATURE_FOOTER);
+    auto_char char* sign_with_header_footer = _add_header_footer(request->sign, PGP_SIGNATURE_HEADER, PGP_SIGNATURE_FOOTER);
     gpgme_data_t sign_data;
     gpgme_data_new_from_mem(&sign_data, sign_with_header_footer, strlen(sign_with_header_footer), 1);
 
     gpgme_data_t plain_data;
     gpgme_data_new(&plain_data);
 
-    error = gpgme_op_verify(ctx, sign_data, NULL, plain_data);
+    gpgme_error_t error = gpgme_op_verify(ctx, sign_data, NULL, plain_data);
     gpgme_data_release(sign_data);
     gpgme_data_release(plain_data);
 
     if (error) {
-        log_error("GPG: Failed to verify. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
+        request->error = g_strdup_printf("Failed to verify. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        _p_gpg_ctx_release(ctx);
         return;
     }
 
     gpgme_verify_result_t result = gpgme_op_verify_result(ctx);
-    if (result) {
-        if (result->signatures) {
-            gpgme_key_t key = NULL;
-            error = gpgme_get_key(ctx, result->signatures->fpr, &key, 0);
-            if (error) {
-                log_debug("Could not find PGP key with ID %s for %s", result->signatures->fpr, barejid);
-            } else {
-                log_debug("Fingerprint found for %s: %s ", barejid, key->subkeys->fpr);
-                ProfPGPPubKeyId* pubkeyid = malloc(sizeof(ProfPGPPubKeyId));
-                pubkeyid->id = strdup(key->subkeys->keyid);
-                pubkeyid->received = TRUE;
-                g_hash_table_replace(pubkeys, strdup(barejid), pubkeyid);
-            }
-
+    if (result && result->signatures) {
+        request->fpr = strdup(result->signatures->fpr);
+        gpgme_key_t key = NULL;
+        error = _p_gpg_get_key(ctx, result->signatures->fpr, 0, &key);
+        if (!error && key) {
+            request->keyid = strdup(key->subkeys->keyid);
             gpgme_key_unref(key);
         }
     }
 
-    gpgme_release(ctx);
+    _p_gpg_ctx_release(ctx);
+}
+
+static gboolean
+_p_gpg_verify_done(gpointer userdata)
+{
+    GpgVerifyRequest* request = userdata;
+
+    if (request->error) {
+        log_error("GPG: %s", request->error);
+    } else if (request->fpr && !request->keyid) {
+        log_debug("Could not find PGP key with ID %s for %s", request->fpr, request->barejid);
+    } else if (request->keyid && request->base.generation == gpg_generation && pubkeys) {
+        log_debug("Fingerprint found for %s: %s ", request->barejid, request->fpr);
+        ProfPGPPubKeyId* pubkeyid = malloc(sizeof(ProfPGPPubKeyId));
+        pubkeyid->id = strdup(request->keyid);
+        pubkeyid->received = TRUE;
+        g_hash_table_replace(pubkeys, strdup(request->barejid), pubkeyid);
+    }
+
+    _p_gpg_verify_request_free(request);
+
+    return G_SOURCE_REMOVE;
+}
+
+// Presence signatures arrive in bursts, verify them on the worker thread
+void
+p_gpg_verify(const char* const barejid, const char* const sign)
+{
+    if (!sign) {
+        return;
+    }
+
+    _p_gpg_keyring_check();
+
+    GpgVerifyRequest* request = calloc(1, sizeof(GpgVerifyRequest));
+    request->base.run = _p_gpg_verify_run;
+    request->base.done = _p_gpg_verify_done;
+    request->barejid = strdup(barejid);
+    request->sign = strdup(sign);
+
+    _p_gpg_request_push(&request->base);
 }
 
 char*
 p_gpg_sign(const char* const str, const char* const fp)
 {
-    gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
-    if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
+        log_error("GPG: Failed to create gpgme context.");
         return NULL;
     }
 
     gpgme_set_passphrase_cb(ctx, (gpgme_passphrase_cb_t)_p_gpg_passphrase_cb, NULL);
 
+    _p_gpg_keyring_check();
     gpgme_key_t key = NULL;
-    error = gpgme_get_key(ctx, fp, &key, 1);
+    gpgme_error_t error = _p_gpg_get_key(ctx, fp, 1, &key);
 
     if (error || key == NULL) {
         log_error("GPG: Failed to get key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
+        _p_gpg_ctx_release(ctx);
         return NULL;
     }
 
@@ -494,7 +755,7 @@ p_gpg_sign(const char* const str, const char* const fp)
 
     if (error) {
         log_error("GPG: Failed to load signer. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
+        _p_gpg_ctx_release(ctx);
         return NULL;
     }
 
@@ -513,7 +774,7 @@ p_gpg_sign(const char* const str, const char* const fp)
     gpgme_set_armor(ctx, 1);
     error = gpgme_op_sign(ctx, str_data, signed_data, GPGME_SIG_MODE_DETACH);
     gpgme_data_release(str_data);
-    gpgme_release(ctx);
+    _p_gpg_ctx_release(ctx);
 
     if (error) {
         log_error("GPG: Failed to sign string. %s %s", gpgme_strsource(error), gpgme_strerror(error));
@@ -557,27 +818,28 @@ p_gpg_encrypt(const char* const barejid, const char* const message, const char*
     keys[1] = NULL;
     keys[2] = NULL;
 
-    gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
-    if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
+        log_error("GPG: Failed to create gpgme context.");
         return NULL;
     }
 
+    _p_gpg_keyring_check();
     gpgme_key_t receiver_key;
-    error = gpgme_get_key(ctx, pubkeyid->id, &receiver_key, 0);
+    gpgme_error_t error = _p_gpg_get_key(ctx, pubkeyid->id, 0, &receiver_key);
     if (error || receiver_key == NULL) {
         log_error("GPG: Failed to get receiver_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
+        _p_gpg_ctx_release(ctx);
         return NULL;
     }
     keys[0] = receiver_key;
 
     gpgme_key_t sender_key = NULL;
-    error = gpgme_get_key(ctx, fp, &sender_key, 0);
+    error = _p_gpg_get_key(ctx, fp, 0, &sender_key);
     if (error || sender_key == NULL) {
         log_error("GPG: Failed to get sender_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        gpgme_release(ctx);
+        gpgme_key_unref(receiver_key);
+        _p_gpg_ctx_release(ctx);
         return NULL;
     }
     keys[1] = sender_key;
@@ -591,7 +853,7 @@ p_gpg_encrypt(const char* const barejid, const char* const message, const char*
     gpgme_set_armor(ctx, 1);
     error = gpgme_op_encrypt(ctx, keys, GPGME_ENCRYPT_ALWAYS_TRUST, plain, cipher);
     gpgme_data_release(plain);
-    gpgme_release(ctx);
+    _p_gpg_ctx_release(ctx);
     gpgme_key_unref(receiver_key);
     gpgme_key_unref(sender_key);
 
@@ -615,19 +877,23 @@ p_gpg_encrypt(const char* const barejid, const char* const message, const char*
     return result;
 }
 
-char*
-p_gpg_decrypt(const char* const cipher)
+// The worker can't ask, without a cached passphrase the request falls back to p_gpg_decrypt()
+static gpgme_error_t
+_p_gpg_passphrase_cached_cb(void* hook, const char* uid_hint, const char* passphrase_info, int prev_was_bad, int fd)
 {
-    gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
-
-    if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        return NULL;
+    const char* cached = hook;
+    if (cached == NULL || prev_was_bad) {
+        return gpg_error(GPG_ERR_CANCELED);
     }
 
-    gpgme_set_passphrase_cb(ctx, (gpgme_passphrase_cb_t)_p_gpg_passphrase_cb, NULL);
+    gpgme_io_write(fd, cached, strlen(cached));
+    return 0;
+}
 
+// Decrypts cipher with ctx, safe on the worker thread as it doesn't log
+static gpgme_error_t
+_p_gpg_decrypt_with(gpgme_ctx_t ctx, const char* const cipher, char** plain, char** recipients)
+{
     auto_char char* cipher_with_headers = _add_header_footer(cipher, PGP_MESSAGE_HEADER, PGP_MESSAGE_FOOTER);
     gpgme_data_t cipher_data;
     gpgme_data_new_from_mem(&cipher_data, cipher_with_headers, strlen(cipher_with_headers), 1);
@@ -635,14 +901,12 @@ p_gpg_decrypt(const char* const cipher)
     gpgme_data_t plain_data;
     gpgme_data_new(&plain_data);
 
-    error = gpgme_op_decrypt(ctx, cipher_data, plain_data);
+    gpgme_error_t error = gpgme_op_decrypt(ctx, cipher_data, plain_data);
     gpgme_data_release(cipher_data);
 
     if (error) {
-        log_error("GPG: Failed to encrypt message. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         gpgme_data_release(plain_data);
-        gpgme_release(ctx);
-        return NULL;
+        return error;
     }
 
     gpgme_decrypt_result_t res = gpgme_op_decrypt_result(ctx);
@@ -651,7 +915,7 @@ p_gpg_decrypt(const char* const cipher)
         gpgme_recipient_t recipient = res->recipients;
         while (recipient) {
             gpgme_key_t key;
-            error = gpgme_get_key(ctx, recipient->keyid, &key, 1);
+            error = _p_gpg_get_key(ctx, recipient->keyid, 1, &key);
 
             if (!error && key) {
                 const char* addr = gpgme_key_get_string_attr(key, GPGME_ATTR_EMAIL, NULL, 0);
@@ -667,17 +931,134 @@ p_gpg_decrypt(const char* const cipher)
 
             recipient = recipient->next;
         }
+        *recipients = g_string_free(recipients_str, FALSE);
+    }
+
+    size_t len = 0;
+    char* plain_str = gpgme_data_release_and_get_mem(plain_data, &len);
+    if (plain_str) {
+        *plain = malloc(len + 1);
+        memcpy(*plain, plain_str, len);
+        (*plain)[len] = '\0';
+        gpgme_free(plain_str);
+    }
+
+    return GPG_ERR_NO_ERROR;
+}
+
+char*
+p_gpg_decrypt(const char* const cipher)
+{
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
+        log_error("GPG: Failed to create gpgme context.");
+        return NULL;
+    }
 
-        log_debug("GPG: Decrypted message for recipients: %s", recipients_str->str);
-        g_string_free(recipients_str, TRUE);
+    gpgme_set_passphrase_cb(ctx, (gpgme_passphrase_cb_t)_p_gpg_passphrase_cb, NULL);
+
+    _p_gpg_keyring_check();
+    char* plain = NULL;
+    auto_gchar gchar* recipients = NULL;
+    gpgme_error_t error = _p_gpg_decrypt_with(ctx, cipher, &plain, &recipients);
+    _p_gpg_ctx_release(ctx);
+
+    if (error) {
+        log_error("GPG: Failed to decrypt message. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        return NULL;
+    }
+    if (recipients) {
+        log_debug("GPG: Decrypted message for recipients: %s", recipients);
+    }
+    if (plain == NULL) {
+        log_error("GPG: Unable to extract gpgmedata.");
     }
-    gpgme_release(ctx);
 
     if (passphrase_attempt) {
         passphrase = strdup(passphrase_attempt);
     }
 
-    return _gpgme_data_to_char(plain_data);
+    return plain;
+}
+
+static void
+_p_gpg_decrypt_request_free(GpgDecryptRequest* request)
+{
+    if (request->userdata_free) {
+        request->userdata_free(request->userdata);
+    }
+    free(request->cipher);
+    free(request->passphrase);
+    free(request->plain);
+    g_free(request->recipients);
+    free(request);
+}
+
+static void
+_p_gpg_decrypt_run(GpgRequest* base)
+{
+    GpgDecryptRequest* request = (GpgDecryptRequest*)base;
+
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
+        request->error = gpg_error(GPG_ERR_ENOMEM);
+        return;
+    }
+
+    gpgme_set_passphrase_cb(ctx, _p_gpg_passphrase_cached_cb, request->passphrase);
+    request->error = _p_gpg_decrypt_with(ctx, request->cipher, &request->plain, &request->recipients);
+    _p_gpg_ctx_release(ctx);
+}
+
+static gboolean
+_p_gpg_decrypt_done(gpointer userdata)
+{
+    GpgDecryptRequest* request = userdata;
+
+    if (request->base.generation != gpg_generation) {
+        _p_gpg_decrypt_request_free(request);
+        return G_SOURCE_REMOVE;
+    }
+
+    char* plain = NULL;
+    if (gpg_err_code(request->error) == GPG_ERR_CANCELED) {
+        // the key needs a passphrase we don't have, ask for it here
+        plain = p_gpg_decrypt(request->cipher);
+    } else if (request->error) {
+        log_error("GPG: Failed to decrypt message. %s %s", gpgme_strsource(request->error), gpgme_strerror(request->error));
+    } else {
+        if (request->recipients) {
+            log_debug("GPG: Decrypted message for recipients: %s", request->recipients);
+        }
+        plain = g_steal_pointer(&request->plain);
+        if (plain == NULL) {
+            log_error("GPG: Unable to extract gpgmedata.");
+        }
+    }
+
+    request->callback(plain, request->userdata);
+    _p_gpg_decrypt_request_free(request);
+
+    return G_SOURCE_REMOVE;
+}
+
+// Decrypting waits on gpg-agent, do it on the worker thread. Requests finish
+// in the order they were made, callback gets the plain text or NULL and owns it.
+void
+p_gpg_decrypt_async(const char* const cipher, ProfGpgDecryptCallback callback, void* userdata, GDestroyNotify userdata_free)
+{
+    _p_gpg_keyring_check();
+
+    GpgDecryptRequest* request = calloc(1, sizeof(GpgDecryptRequest));
+    request->base.run = _p_gpg_decrypt_run;
+    request->base.done = _p_gpg_decrypt_done;
+    request->cipher = strdup(cipher);
+    request->passphrase = passphrase ? strdup(passphrase) : NULL;
+    request->callback = callback;
+    request->userdata = userdata;
+    request->userdata_free = userdata_free;
+
+    _p_gpg_request_push(&request->base);
 }
 
 void
@@ -689,13 +1070,10 @@ p_gpg_free_decrypted(char* decrypted)
 char*
 p_gpg_autocomplete_key(const char* const search_str, gboolean previous, void* context)
 {
-    return autocomplete_complete(key_ac, search_str, TRUE, previous);
-}
+    // fills key_ac when the keys were not listed yet
+    p_gpg_free_keys(p_gpg_list_keys());
 
-void
-p_gpg_autocomplete_key_reset(void)
-{
-    autocomplete_reset(key_ac);
+    return autocomplete_complete(key_ac, search_str, TRUE, previous);
 }
 
 char*
@@ -737,9 +1115,9 @@ p_gpg_get_pubkey(const char* keyid)
     gpgme_error_t error = GPG_ERR_NO_ERROR;
     gpgme_data_t data = NULL;
 
-    error = gpgme_new(&context);
-    if (error != GPG_ERR_NO_ERROR) {
-        log_error("GPG: Failed to create gpgme context. %s", gpgme_strerror(error));
+    context = _p_gpg_ctx_acquire();
+    if (context == NULL) {
+        log_error("GPG: Failed to create gpgme context.");
         goto cleanup;
     }
 
@@ -758,7 +1136,7 @@ p_gpg_get_pubkey(const char* keyid)
     }
 
 cleanup:
-    gpgme_release(context);
+    _p_gpg_ctx_release(context);
     return _gpgme_data_to_char(data);
 }
 
@@ -799,10 +1177,10 @@ p_gpg_is_public_key_format(const char* buffer)
 ProfPGPKey*
 p_gpg_import_pubkey(const char* buffer)
 {
-    gpgme_ctx_t ctx;
     ProfPGPKey* result = NULL;
-    gpgme_error_t error = gpgme_new(&ctx);
-    if (error != GPG_ERR_NO_ERROR) {
+    gpgme_error_t error;
+    gpgme_ctx_t ctx = _p_gpg_ctx_acquire();
+    if (ctx == NULL) {
         log_error("GPG: Error creating GPGME context");
         goto out;
     }
@@ -823,6 +1201,9 @@ p_gpg_import_pubkey(const char* buffer)
         goto out;
     }
 
+    // don't wait for the keyring files to look different
+    _p_gpg_caches_clear();
+
     gpgme_import_result_t import_result = gpgme_op_import_result(ctx);
     gpgme_import_status_t status = import_result->imports;
     gboolean is_valid = (status && status->result == GPG_ERR_NO_ERROR);
@@ -843,7 +1224,7 @@ p_gpg_import_pubkey(const char* buffer)
     gpgme_key_release(key);
 
 out:
-    gpgme_release(ctx);
+    _p_gpg_ctx_release(ctx);
     return result;
 }
 
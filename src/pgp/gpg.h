@@ -54,6 +54,8 @@ typedef struct pgp_pubkeyid_t
     gboolean received;
 } ProfPGPPubKeyId;
 
+typedef void (*ProfGpgDecryptCallback)(char* plain, void* userdata);
+
 void p_gpg_init(void);
 void p_gpg_close(void);
 void p_gpg_on_connect(const char* const barejid);
@@ -69,9 +71,9 @@ char* p_gpg_sign(const char* const str, const char* const fp);
 void p_gpg_verify(const char* const barejid, const char* const sign);
 char* p_gpg_encrypt(const char* const barejid, const char* const message, const char* const fp);
 char* p_gpg_decrypt(const char* const cipher);
+void p_gpg_decrypt_async(const char* const cipher, ProfGpgDecryptCallback callback, void* userdata, GDestroyNotify userdata_free);
 void p_gpg_free_decrypted(char* decrypted);
 char* p_gpg_autocomplete_key(const char* const search_str, gboolean previous, void* context);
-void p_gpg_autocomplete_key_reset(void);
 char* p_gpg_format_fp_str(char* fp);
 char* p_gpg_get_pubkey(const char* const keyid);
 gboolean p_gpg_is_public_key_format(const char* buffer);
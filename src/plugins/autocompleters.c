@@ -186,26 +186,6 @@ autocompleters_complete(const char* const input, gboolean previous)
     return NULL;
 }
 
-void
-autocompleters_reset(void)
-{
-    GList* ac_hashes = g_hash_table_get_values(plugin_to_acs);
-    GList* curr_hash = ac_hashes;
-    while (curr_hash) {
-        GList* acs = g_hash_table_get_values(curr_hash->data);
-        GList* curr = acs;
-        while (curr) {
-            autocomplete_reset(curr->data);
-            curr = g_list_next(curr);
-        }
-
-        g_list_free(acs);
-        curr_hash = g_list_next(curr_hash);
-    }
-
-    g_list_free(ac_hashes);
-}
-
 void
 autocompleters_destroy(void)
 {
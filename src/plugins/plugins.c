@@ -50,6 +50,7 @@
 #include "plugins/themes.h"
 #include "plugins/settings.h"
 #include "plugins/disco.h"
+#include "tools/perf.h"
 #include "ui/ui.h"
 #include "xmpp/xmpp.h"
 
@@ -80,49 +81,68 @@ plugins_init(void)
 #ifdef HAVE_C
     c_env_init();
 #endif
+}
 
-    // load plugins
+/*
+ * Load and start the plugins from the preferences. Importing them can take
+ * a while, so this runs from the main loop once the UI is up rather than
+ * from plugins_init().
+ */
+void
+plugins_load_startup(void)
+{
     auto_gcharv gchar** plugins_pref = prefs_get_plugins();
     if (!plugins_pref) {
         return;
     }
+
+    GList* loaded_plugins = NULL;
     for (int i = 0; i < g_strv_length(plugins_pref); i++) {
-        gboolean loaded = FALSE;
+        ProfPlugin* plugin = NULL;
         gchar* filename = plugins_pref[i];
+        if (g_hash_table_contains(plugins, filename)) {
+            continue;
+        }
 #ifdef HAVE_PYTHON
         if (g_str_has_suffix(filename, ".py")) {
-            ProfPlugin* plugin = python_plugin_create(filename);
-            if (plugin) {
-                g_hash_table_insert(plugins, strdup(filename), plugin);
-                loaded = TRUE;
-            }
+            plugin = python_plugin_create(filename);
         }
 #endif
 #ifdef HAVE_C
         if (g_str_has_suffix(filename, ".so")) {
-            ProfPlugin* plugin = c_plugin_create(filename);
-            if (plugin) {
-                g_hash_table_insert(plugins, strdup(filename), plugin);
-                loaded = TRUE;
-            }
+            plugin = c_plugin_create(filename);
         }
 #endif
-        if (loaded) {
+        if (plugin) {
+            g_hash_table_insert(plugins, strdup(filename), plugin);
+            loaded_plugins = g_list_append(loaded_plugins, plugin);
             log_info("Loaded plugin: %s", filename);
         } else {
             log_info("Failed to load plugin: %s", filename);
         }
     }
 
-    // initialise plugins
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
+    // initialise plugins, the account may already be connecting
+    GList* curr = loaded_plugins;
     while (curr) {
         ProfPlugin* plugin = curr->data;
-        plugin->init_func(plugin, PACKAGE_VERSION, PACKAGE_STATUS, NULL, NULL);
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.init", plugin->name);
+        if (connection_get_status() == JABBER_CONNECTED) {
+            plugin->init_func(plugin, PACKAGE_VERSION, PACKAGE_STATUS, session_get_account_name(), connection_get_fulljid());
+        } else {
+            plugin->init_func(plugin, PACKAGE_VERSION, PACKAGE_STATUS, NULL, NULL);
+        }
         curr = g_list_next(curr);
     }
-    g_list_free(values);
+
+    curr = loaded_plugins;
+    while (curr) {
+        ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_start", plugin->name);
+        plugin->on_start_func(plugin);
+        curr = g_list_next(curr);
+    }
+    g_list_free(loaded_plugins);
 }
 
 void
@@ -400,12 +420,6 @@ plugins_autocomplete(const char* const input, gboolean previous)
     return autocompleters_complete(input, previous);
 }
 
-void
-plugins_reset_autocomplete(void)
-{
-    autocompleters_reset();
-}
-
 void
 plugins_win_process_line(char* win, const char* const line)
 {
@@ -428,6 +442,7 @@ plugins_on_start(void)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_start", plugin->name);
         plugin->on_start_func(plugin);
         curr = g_list_next(curr);
     }
@@ -441,6 +456,7 @@ plugins_on_shutdown(void)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_shutdown", plugin->name);
         plugin->on_shutdown_func(plugin);
         curr = g_list_next(curr);
     }
@@ -454,6 +470,7 @@ plugins_on_connect(const char* const account_name, const char* const fulljid)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_connect", plugin->name);
         plugin->on_connect_func(plugin, account_name, fulljid);
         curr = g_list_next(curr);
     }
@@ -467,6 +484,7 @@ plugins_on_disconnect(const char* const account_name, const char* const fulljid)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_disconnect", plugin->name);
         plugin->on_disconnect_func(plugin, account_name, fulljid);
         curr = g_list_next(curr);
     }
@@ -483,6 +501,7 @@ plugins_pre_chat_message_display(const char* const barejid, const char* const re
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.pre_chat_message_display", plugin->name);
         new_message = plugin->pre_chat_message_display(plugin, barejid, resource, curr_message);
         if (new_message) {
             free(curr_message);
@@ -502,6 +521,7 @@ plugins_post_chat_message_display(const char* const barejid, const char* const r
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.post_chat_message_display", plugin->name);
         plugin->post_chat_message_display(plugin, barejid, resource, message);
         curr = g_list_next(curr);
     }
@@ -518,6 +538,7 @@ plugins_pre_chat_message_send(const char* const barejid, const char* message)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.pre_chat_message_send", plugin->name);
         if (plugin->contains_hook(plugin, "prof_pre_chat_message_send")) {
             new_message = plugin->pre_chat_message_send(plugin, barejid, curr_message);
             if (new_message) {
@@ -545,6 +566,7 @@ plugins_post_chat_message_send(const char* const barejid, const char* message)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.post_chat_message_send", plugin->name);
         plugin->post_chat_message_send(plugin, barejid, message);
         curr = g_list_next(curr);
     }
@@ -561,6 +583,7 @@ plugins_pre_room_message_display(const char* const barejid, const char* const ni
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.pre_room_message_display", plugin->name);
         new_message = plugin->pre_room_message_display(plugin, barejid, nick, curr_message);
         if (new_message) {
             free(curr_message);
@@ -581,6 +604,7 @@ plugins_post_room_message_display(const char* const barejid, const char* const n
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.post_room_message_display", plugin->name);
         plugin->post_room_message_display(plugin, barejid, nick, message);
         curr = g_list_next(curr);
     }
@@ -597,6 +621,7 @@ plugins_pre_room_message_send(const char* const barejid, const char* message)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.pre_room_message_send", plugin->name);
         if (plugin->contains_hook(plugin, "prof_pre_room_message_send")) {
             new_message = plugin->pre_room_message_send(plugin, barejid, curr_message);
             if (new_message) {
@@ -624,6 +649,7 @@ plugins_post_room_message_send(const char* const barejid, const char* message)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.post_room_message_send", plugin->name);
         plugin->post_room_message_send(plugin, barejid, message);
         curr = g_list_next(curr);
     }
@@ -645,6 +671,7 @@ plugins_on_room_history_message(const char* const barejid, const char* const nic
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_room_history_message", plugin->name);
         plugin->on_room_history_message(plugin, barejid, nick, message, timestamp_str);
         curr = g_list_next(curr);
     }
@@ -664,6 +691,7 @@ plugins_pre_priv_message_display(const char* const fulljid, const char* message)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.pre_priv_message_display", plugin->name);
         new_message = plugin->pre_priv_message_display(plugin, jidp->barejid, jidp->resourcepart, curr_message);
         if (new_message) {
             free(curr_message);
@@ -685,6 +713,7 @@ plugins_post_priv_message_display(const char* const fulljid, const char* message
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.post_priv_message_display", plugin->name);
         plugin->post_priv_message_display(plugin, jidp->barejid, jidp->resourcepart, message);
         curr = g_list_next(curr);
     }
@@ -702,6 +731,7 @@ plugins_pre_priv_message_send(const char* const fulljid, const char* const messa
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.pre_priv_message_send", plugin->name);
         if (plugin->contains_hook(plugin, "prof_pre_priv_message_send")) {
             new_message = plugin->pre_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, curr_message);
             if (new_message) {
@@ -731,6 +761,7 @@ plugins_post_priv_message_send(const char* const fulljid, const char* const mess
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.post_priv_message_send", plugin->name);
         plugin->post_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, message);
         curr = g_list_next(curr);
     }
@@ -748,6 +779,7 @@ plugins_on_message_stanza_send(const char* const text)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_message_stanza_send", plugin->name);
         new_stanza = plugin->on_message_stanza_send(plugin, curr_stanza);
         if (new_stanza) {
             free(curr_stanza);
@@ -770,6 +802,7 @@ plugins_on_message_stanza_receive(const char* const text)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_message_stanza_receive", plugin->name);
         gboolean res = plugin->on_message_stanza_receive(plugin, text);
         if (res == FALSE) {
             cont = FALSE;
@@ -791,6 +824,7 @@ plugins_on_presence_stanza_send(const char* const text)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_presence_stanza_send", plugin->name);
         new_stanza = plugin->on_presence_stanza_send(plugin, curr_stanza);
         if (new_stanza) {
             free(curr_stanza);
@@ -813,6 +847,7 @@ plugins_on_presence_stanza_receive(const char* const text)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_presence_stanza_receive", plugin->name);
         gboolean res = plugin->on_presence_stanza_receive(plugin, text);
         if (res == FALSE) {
             cont = FALSE;
@@ -834,6 +869,7 @@ plugins_on_iq_stanza_send(const char* const text)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_iq_stanza_send", plugin->name);
         new_stanza = plugin->on_iq_stanza_send(plugin, curr_stanza);
         if (new_stanza) {
             free(curr_stanza);
@@ -856,6 +892,7 @@ plugins_on_iq_stanza_receive(const char* const text)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_iq_stanza_receive", plugin->name);
         gboolean res = plugin->on_iq_stanza_receive(plugin, text);
         if (res == FALSE) {
             cont = FALSE;
@@ -874,6 +911,7 @@ plugins_on_contact_offline(const char* const barejid, const char* const resource
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_contact_offline", plugin->name);
         plugin->on_contact_offline(plugin, barejid, resource, status);
         curr = g_list_next(curr);
     }
@@ -887,6 +925,7 @@ plugins_on_contact_presence(const char* const barejid, const char* const resourc
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_contact_presence", plugin->name);
         plugin->on_contact_presence(plugin, barejid, resource, presence, status, priority);
         curr = g_list_next(curr);
     }
@@ -900,6 +939,7 @@ plugins_on_chat_win_focus(const char* const barejid)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_chat_win_focus", plugin->name);
         plugin->on_chat_win_focus(plugin, barejid);
         curr = g_list_next(curr);
     }
@@ -913,6 +953,7 @@ plugins_on_room_win_focus(const char* const barejid)
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        auto_perf ProfPerfTimer timer = perf_timer_start("plugin.on_room_win_focus", plugin->name);
         plugin->on_room_win_focus(plugin, barejid);
         curr = g_list_next(curr);
     }
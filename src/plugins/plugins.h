@@ -109,10 +109,10 @@ typedef struct prof_plugin_t
 } ProfPlugin;
 
 void plugins_init(void);
+void plugins_load_startup(void);
 GSList* plugins_unloaded_list(void);
 GList* plugins_loaded_list(void);
 char* plugins_autocomplete(const char* const input, gboolean previous);
-void plugins_reset_autocomplete(void);
 void plugins_shutdown(void);
 
 void plugins_free_install_result(PluginsInstallResult* result);
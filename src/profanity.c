@@ -60,6 +60,8 @@
 #include "command/cmd_defs.h"
 #include "plugins/plugins.h"
 #include "event/client_events.h"
+#include "tools/http_common.h"
+#include "tools/perf.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/resource.h"
@@ -86,20 +88,44 @@
 static void _init(char* log_level, char* config_file, char* log_file, char* theme_name);
 static void _shutdown(void);
 static void _connect_default(const char* const account);
+static void _startup_phase(const char* const name);
+static gboolean _startup_deferred(gpointer data);
+
+typedef struct startup_phase_t
+{
+    const char* name;
+    gint64 elapsed_us;
+} StartupPhase;
 
 pthread_mutex_t lock;
 static gboolean force_quit = FALSE;
 
+// phases recorded for --startup-trace, NULL when not tracing
+static GArray* startup_trace = NULL;
+static gint64 startup_begin = 0;
+static gint64 startup_mark = 0;
+static gint64 startup_first_prompt = 0;
+
 void
-prof_run(char* log_level, char* account_name, char* config_file, char* log_file, char* theme_name)
+prof_run(char* log_level, char* account_name, char* config_file, char* log_file, char* theme_name, gboolean trace_startup)
 {
     gboolean cont = TRUE;
 
+    if (trace_startup) {
+        startup_trace = g_array_new(FALSE, FALSE, sizeof(StartupPhase));
+        startup_begin = startup_mark = g_get_monotonic_time();
+    }
+
     _init(log_level, config_file, log_file, theme_name);
-    plugins_on_start();
     _connect_default(account_name);
+    _startup_phase("connect");
 
     ui_update();
+    _startup_phase("ui_update");
+    startup_first_prompt = g_get_monotonic_time() - startup_begin;
+
+    // plugins are imported once the prompt is usable
+    g_idle_add(_startup_deferred, NULL);
 
     log_info("Starting main event loop");
 
@@ -112,6 +138,7 @@ prof_run(char* log_level, char* account_name, char* config_file, char* log_file,
 
         line = inp_readline();
         if (line) {
+            auto_perf ProfPerfTimer timer = perf_timer_start("loop.command", NULL);
             ProfWin* window = wins_get_current();
             cont = cmd_process_input(window, line);
             free(line);
@@ -123,14 +150,24 @@ prof_run(char* log_level, char* account_name, char* config_file, char* log_file,
 #ifdef HAVE_LIBOTR
         otr_poll();
 #endif
+        ProfPerfTimer timer = perf_timer_start("loop.plugins_run_timed", NULL);
         plugins_run_timed();
+        perf_timer_stop(&timer);
         notify_remind();
+        timer = perf_timer_start("loop.session_process_events", NULL);
         session_process_events();
+        perf_timer_stop(&timer);
+        // run callbacks posted by other threads through g_idle_add()
+        g_main_context_iteration(NULL, FALSE);
         iq_autoping_check();
+        timer = perf_timer_start("loop.ui_update", NULL);
         ui_update();
+        perf_timer_stop(&timer);
 #ifdef HAVE_GTK
         tray_update();
 #endif
+        perf_count("loop.iterations", NULL, 1);
+        perf_log_check();
     }
 }
 
@@ -142,6 +179,48 @@ prof_set_quit(void)
     return ret;
 }
 
+static void
+_startup_phase(const char* const name)
+{
+    if (startup_trace) {
+        gint64 now = g_get_monotonic_time();
+        StartupPhase phase = { name, now - startup_mark };
+        g_array_append_val(startup_trace, phase);
+        startup_mark = now;
+    }
+}
+
+static void
+_startup_report(void)
+{
+    ProfWin* console = wins_get_console();
+    win_println(console, THEME_DEFAULT, "-", "Startup trace:");
+    for (guint i = 0; i < startup_trace->len; i++) {
+        StartupPhase* phase = &g_array_index(startup_trace, StartupPhase, i);
+        win_println(console, THEME_DEFAULT, "-", "  %-32s %8.1f ms", phase->name, phase->elapsed_us / 1000.0);
+        log_info("Startup trace: %s %.1f ms", phase->name, phase->elapsed_us / 1000.0);
+    }
+    win_println(console, THEME_DEFAULT, "-", "  %-32s %8.1f ms", "time to first prompt", startup_first_prompt / 1000.0);
+    log_info("Startup trace: time to first prompt %.1f ms", startup_first_prompt / 1000.0);
+
+    g_array_free(startup_trace, TRUE);
+    startup_trace = NULL;
+}
+
+static gboolean
+_startup_deferred(gpointer data)
+{
+    startup_mark = g_get_monotonic_time();
+    plugins_load_startup();
+    _startup_phase("plugins_load_startup (deferred)");
+
+    if (startup_trace) {
+        _startup_report();
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
 static void
 _connect_default(const char* const account)
 {
@@ -175,6 +254,7 @@ _init(char* log_level, char* config_file, char* log_file, char* theme_name)
     log_level_t prof_log_level;
     log_level_from_string(log_level, &prof_log_level);
     prefs_load(config_file);
+    _startup_phase("prefs_load");
     log_init(prof_log_level, log_file);
     log_stderr_init(PROF_LEVEL_ERROR);
 
@@ -183,7 +263,9 @@ _init(char* log_level, char* config_file, char* log_file, char* theme_name)
 
     chat_log_init();
     groupchat_log_init();
+    _startup_phase("log_init");
     accounts_load();
+    _startup_phase("accounts_load");
 
     if (theme_name) {
         theme_init(theme_name);
@@ -191,6 +273,7 @@ _init(char* log_level, char* config_file, char* log_file, char* theme_name)
         auto_gchar gchar* theme = prefs_get_string(PREF_THEME);
         theme_init(theme);
     }
+    _startup_phase("theme_init");
 
     ui_init();
     if (prof_log_level == PROF_LEVEL_DEBUG) {
@@ -198,28 +281,37 @@ _init(char* log_level, char* config_file, char* log_file, char* theme_name)
         win_println(console, THEME_DEFAULT, "-", "Debug mode enabled! Logging to: ");
         win_println(console, THEME_DEFAULT, "-", get_log_file_location());
     }
+    _startup_phase("ui_init");
     session_init();
     cmd_init();
+    _startup_phase("cmd_init");
     log_info("Initialising contact list");
     muc_init();
     tlscerts_init();
     scripts_init();
+    _startup_phase("tlscerts_init, scripts_init");
 #ifdef HAVE_LIBOTR
     otr_init();
+    _startup_phase("otr_init");
 #endif
 #ifdef HAVE_LIBGPGME
     p_gpg_init();
+    _startup_phase("p_gpg_init");
 #endif
 #ifdef HAVE_OMEMO
     omemo_init();
+    _startup_phase("omemo_init");
 #endif
     atexit(_shutdown);
     plugins_init();
+    _startup_phase("plugins_init");
 #ifdef HAVE_GTK
     tray_init();
+    _startup_phase("tray_init");
 #endif
     inp_nonblocking(TRUE);
     ui_resize();
+    _startup_phase("ui_resize");
 }
 
 static void
@@ -241,6 +333,7 @@ _shutdown(void)
     tray_shutdown();
 #endif
     session_shutdown();
+    http_transfer_close();
     plugins_on_shutdown();
     muc_close();
     caps_close();
@@ -259,6 +352,7 @@ _shutdown(void)
     tlscerts_close();
     log_stderr_close();
     plugins_shutdown();
+    perf_close();
     cmd_uninit();
     ui_close();
     prefs_close();
@@ -43,7 +43,6 @@
 #include <sys/types.h>
 #include <curl/curl.h>
 #include <gio/gio.h>
-#include <pthread.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -59,11 +58,9 @@
 
 #define FALLBACK_MSG ""
 
-void*
-aesgcm_file_get(void* userdata)
+void
+aesgcm_file_get(AESGCMDownload* aesgcm_dl)
 {
-    AESGCMDownload* aesgcm_dl = (AESGCMDownload*)userdata;
-
     char* https_url = NULL;
     char* fragment = NULL;
 
@@ -74,109 +71,42 @@ aesgcm_file_get(void* userdata)
         http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
                                    "Download failed: Cannot parse URL '%s'.",
                                    aesgcm_dl->url);
-        return NULL;
+        goto out;
     }
 
-    // Create a temporary file used for storing the ciphertext that is to be
-    // retrieved from the https:// URL.
-    gchar* tmpname = NULL;
-    gint tmpfd;
-    if ((tmpfd = g_file_open_tmp("profanity.XXXXXX", &tmpname, NULL)) == -1) {
+    OmemoAesgcmStream* stream = omemo_decrypt_stream_new(fragment);
+    if (stream == NULL) {
         http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                   "Downloading '%s' failed: Unable to create "
-                                   "temporary ciphertext file for writing "
-                                   "(%s).",
-                                   https_url, g_strerror(errno));
-        return NULL;
+                                   "Downloading '%s' failed: Unable to set up "
+                                   "decryption.",
+                                   https_url);
+        goto out;
     }
 
-    // Open the target file for storing the cleartext.
-    FILE* outfh = fopen(aesgcm_dl->filename, "wb");
-    if (outfh == NULL) {
-        http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                   "Downloading '%s' failed: Unable to open "
-                                   "output file at '%s' for writing (%s).",
-                                   https_url, aesgcm_dl->filename,
-                                   g_strerror(errno));
-        return NULL;
-    }
-
-    // We wrap the HTTPDownload tool and use it for retrieving the ciphertext
-    // and storing it in the temporary file previously opened.
+    // We wrap the HTTPDownload tool and use it for retrieving the ciphertext.
+    // It is decrypted as it arrives, so only the cleartext is written to the
+    // target file.
     HTTPDownload* http_dl = malloc(sizeof(HTTPDownload));
     http_dl->window = aesgcm_dl->window;
-    http_dl->worker = aesgcm_dl->worker;
     http_dl->id = strdup(aesgcm_dl->id);
     http_dl->url = strdup(https_url);
-    http_dl->filename = strdup(tmpname);
-    http_dl->cmd_template = NULL;
+    http_dl->filename = strdup(aesgcm_dl->filename);
+    http_dl->cmd_template = aesgcm_dl->cmd_template ? strdup(aesgcm_dl->cmd_template) : NULL;
     http_dl->silent = FALSE;
-    aesgcm_dl->http_dl = http_dl;
-
-    http_file_get(http_dl); // TODO(wstrm): Verify result.
-
-    FILE* tmpfh = fopen(tmpname, "rb");
-    if (tmpfh == NULL) {
-        http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                   "Downloading '%s' failed: Unable to open "
-                                   "temporary file at '%s' for reading (%s).",
-                                   aesgcm_dl->url, tmpname,
-                                   g_strerror(errno));
-        return NULL;
-    }
-
-    gcry_error_t crypt_res;
-    crypt_res = omemo_decrypt_file(tmpfh, outfh,
-                                   http_dl->bytes_received, fragment);
-
-    if (fclose(tmpfh) == EOF) {
-        cons_show_error(g_strerror(errno));
-    }
-
-    close(tmpfd);
-    remove(tmpname);
-    g_free(tmpname);
+    http_dl->omemo_stream = stream;
+    http_dl->on_complete = NULL;
 
-    if (crypt_res != GPG_ERR_NO_ERROR) {
-        http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                   "Downloading '%s' failed: Failed to decrypt "
-                                   "file (%s).",
-                                   https_url, gcry_strerror(crypt_res));
-    }
-
-    if (fclose(outfh) == EOF) {
-        cons_show_error(g_strerror(errno));
-    }
+    http_file_get(http_dl);
 
+out:
     free(https_url);
     free(fragment);
 
-    if (aesgcm_dl->cmd_template != NULL) {
-        gchar** argv = format_call_external_argv(aesgcm_dl->cmd_template,
-                                                 aesgcm_dl->filename,
-                                                 aesgcm_dl->filename);
-
-        // TODO: Log the error.
-        if (!call_external(argv)) {
-            http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                       "Downloading '%s' failed: Unable to call "
-                                       "command '%s' with file at '%s' (%s).",
-                                       aesgcm_dl->url,
-                                       aesgcm_dl->cmd_template,
-                                       aesgcm_dl->filename,
-                                       "TODO: Log the error");
-        }
-
-        g_strfreev(argv);
-        free(aesgcm_dl->cmd_template);
-    }
-
+    free(aesgcm_dl->cmd_template);
     free(aesgcm_dl->id);
     free(aesgcm_dl->filename);
     free(aesgcm_dl->url);
     free(aesgcm_dl);
-
-    return NULL;
 }
 
 void
@@ -184,9 +114,3 @@ aesgcm_download_cancel_processes(ProfWin* window)
 {
     http_download_cancel_processes(window);
 }
-
-void
-aesgcm_download_add_download(AESGCMDownload* aesgcm_dl)
-{
-    http_download_add_download(aesgcm_dl->http_dl);
-}
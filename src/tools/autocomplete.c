@@ -55,8 +55,13 @@ struct autocomplete_t
     GList* items;
     GList* last_found;
     gchar* search_str;
+    guint generation;
 };
 
+// bumped instead of resetting every autocompleter each time the input changes,
+// autocompleters compare it to their own before continuing a search
+static guint ac_generation = 0;
+
 static gchar* _search(Autocomplete ac, GList* curr, gboolean quote, search_direction direction);
 
 Autocomplete
@@ -66,6 +71,7 @@ autocomplete_new(void)
     new->items = NULL;
     new->last_found = NULL;
     new->search_str = NULL;
+    new->generation = ac_generation;
 
     return new;
 }
@@ -88,6 +94,27 @@ autocomplete_reset(Autocomplete ac)
 {
     ac->last_found = NULL;
     FREE_SET_NULL(ac->search_str);
+    ac->generation = ac_generation;
+}
+
+void
+autocomplete_reset_all(void)
+{
+    ac_generation++;
+}
+
+guint
+autocomplete_generation(void)
+{
+    return ac_generation;
+}
+
+static void
+_autocomplete_sync(Autocomplete ac)
+{
+    if (ac->generation != ac_generation) {
+        autocomplete_reset(ac);
+    }
 }
 
 void
@@ -117,6 +144,7 @@ autocomplete_update(Autocomplete ac, char** items)
     auto_gchar gchar* last_found = NULL;
     auto_gchar gchar* search_str = NULL;
 
+    _autocomplete_sync(ac);
     if (ac->last_found) {
         last_found = strdup(ac->last_found->data);
     }
@@ -254,6 +282,8 @@ autocomplete_complete(Autocomplete ac, const gchar* search_str, gboolean quote,
         return NULL;
     }
 
+    _autocomplete_sync(ac);
+
     // no items to search
     if (!ac->items) {
         return NULL;
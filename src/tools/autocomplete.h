@@ -74,6 +74,11 @@ char* autocomplete_param_no_with_func(const char* const input, char* command,
 
 void autocomplete_reset(Autocomplete ac);
 
+// start a new completion session, every autocompleter forgets its last search
+// the next time it is used
+void autocomplete_reset_all(void);
+guint autocomplete_generation(void);
+
 gboolean autocomplete_contains(Autocomplete ac, const char* value);
 
 void autocomplete_remove_older_than_max_reverse(Autocomplete ac, int maxsize);
@@ -46,6 +46,7 @@
 #include "log.h"
 #include "common.h"
 #include "xmpp/xmpp.h"
+#include "ui/ui.h"
 
 // Returns true if an error occurred
 gboolean
@@ -102,6 +103,8 @@ get_message_from_editor(gchar* message, gchar** returned_message)
             return TRUE;
         }
         waitpid(pid, NULL, 0);
+        // editors commonly turn bracketed paste off when they exit
+        ui_terminal_bracketed_paste(TRUE);
 
         gchar* contents;
         gsize length;
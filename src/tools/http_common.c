@@ -38,12 +38,63 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 #include <gio/gio.h>
 
+#include "log.h"
+#include "common.h"
+#include "config/accounts.h"
+#include "config/cafile.h"
+#include "config/preferences.h"
 #include "tools/http_common.h"
+#include "xmpp/xmpp.h"
 
 #define FALLBACK_MSG ""
 
+// Transfers running at the same time, further ones wait in the queue
+#define HTTP_TRANSFER_MAX_ACTIVE 4
+// Transfers waiting to be started, further ones are rejected
+#define HTTP_TRANSFER_MAX_QUEUED 32
+// Minimum time between two progress updates of a transfer
+#define HTTP_TRANSFER_PROGRESS_INTERVAL (250 * G_TIME_SPAN_MILLISECOND)
+// Maximum time in ms the transfer thread sleeps without activity
+#define HTTP_TRANSFER_POLL_TIMEOUT 1000
+
+struct http_transfer_t
+{
+    CURL* curl;
+    HTTPTransferProgress progress;
+    HTTPTransferDone done;
+    void* userdata;
+    CURLcode res;
+    gint refcnt;
+    gint canceled;
+    gboolean finished;
+    // Guarded by transfer_engine.lock
+    gboolean progress_queued;
+    curl_off_t progress_now;
+    curl_off_t progress_total;
+    // Only accessed by the transfer thread
+    gint64 progress_time;
+};
+
+// All HTTP transfers are run by a single thread driving a curl multi handle.
+// Connections, DNS lookups and TLS sessions are reused between transfers.
+static struct http_transfer_engine_t
+{
+    gboolean running;
+    gboolean quit;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    CURLM* multi;
+    CURLSH* share;
+    // The share is used by the transfer thread and by the main thread when
+    // it sets up and cleans up easy handles
+    pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+    GQueue* queued;
+    int active;
+} transfer_engine;
+
 void
 http_print_transfer_update(ProfWin* window, char* id, const char* fmt, ...)
 {
@@ -77,3 +128,315 @@ http_print_transfer(ProfWin* window, char* id, const char* fmt, ...)
 
     g_string_free(msg, TRUE);
 }
+
+static void
+_transfer_unref(HTTPTransfer* transfer)
+{
+    if (g_atomic_int_dec_and_test(&transfer->refcnt)) {
+        g_free(transfer);
+    }
+}
+
+static gboolean
+_transfer_progress_idle(gpointer data)
+{
+    HTTPTransfer* transfer = (HTTPTransfer*)data;
+
+    pthread_mutex_lock(&transfer_engine.lock);
+    curl_off_t now = transfer->progress_now;
+    curl_off_t total = transfer->progress_total;
+    transfer->progress_queued = FALSE;
+    pthread_mutex_unlock(&transfer_engine.lock);
+
+    if (!transfer->finished && !g_atomic_int_get(&transfer->canceled)) {
+        transfer->progress(transfer->userdata, now, total);
+    }
+
+    _transfer_unref(transfer);
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+_transfer_done_idle(gpointer data)
+{
+    HTTPTransfer* transfer = (HTTPTransfer*)data;
+
+    transfer->finished = TRUE;
+    transfer->done(transfer->userdata, transfer->curl, transfer->res);
+    curl_easy_cleanup(transfer->curl);
+    transfer->curl = NULL;
+
+    _transfer_unref(transfer);
+
+    return G_SOURCE_REMOVE;
+}
+
+static int
+_transfer_xferinfo(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+    HTTPTransfer* transfer = (HTTPTransfer*)userdata;
+
+    if (g_atomic_int_get(&transfer->canceled)) {
+        return 1;
+    }
+
+    if (!transfer->progress) {
+        return 0;
+    }
+
+    // Rate limit the updates posted to the main thread.
+    gint64 now = g_get_monotonic_time();
+    if (now - transfer->progress_time < HTTP_TRANSFER_PROGRESS_INTERVAL) {
+        return 0;
+    }
+    transfer->progress_time = now;
+
+    pthread_mutex_lock(&transfer_engine.lock);
+    if (ultotal != 0) {
+        transfer->progress_now = ulnow;
+        transfer->progress_total = ultotal;
+    } else {
+        transfer->progress_now = dlnow;
+        transfer->progress_total = dltotal;
+    }
+    gboolean queued = transfer->progress_queued;
+    transfer->progress_queued = TRUE;
+    pthread_mutex_unlock(&transfer_engine.lock);
+
+    if (!queued) {
+        g_atomic_int_inc(&transfer->refcnt);
+        g_idle_add(_transfer_progress_idle, transfer);
+    }
+
+    return 0;
+}
+
+static void
+_transfer_finish(HTTPTransfer* transfer, CURLcode res)
+{
+    transfer->res = res;
+    g_idle_add(_transfer_done_idle, transfer);
+}
+
+static void
+_transfer_share_lock(CURL* curl, curl_lock_data data, curl_lock_access access, void* userdata)
+{
+    pthread_mutex_lock(&transfer_engine.share_locks[data]);
+}
+
+static void
+_transfer_share_unlock(CURL* curl, curl_lock_data data, void* userdata)
+{
+    pthread_mutex_unlock(&transfer_engine.share_locks[data]);
+}
+
+static void*
+_transfer_engine_run(void* userdata)
+{
+    int running = 0;
+
+    while (TRUE) {
+        pthread_mutex_lock(&transfer_engine.lock);
+        if (transfer_engine.quit) {
+            pthread_mutex_unlock(&transfer_engine.lock);
+            break;
+        }
+        while (transfer_engine.active < HTTP_TRANSFER_MAX_ACTIVE && !g_queue_is_empty(transfer_engine.queued)) {
+            HTTPTransfer* transfer = g_queue_pop_head(transfer_engine.queued);
+            if (g_atomic_int_get(&transfer->canceled)) {
+                _transfer_finish(transfer, CURLE_ABORTED_BY_CALLBACK);
+            } else {
+                curl_multi_add_handle(transfer_engine.multi, transfer->curl);
+                transfer_engine.active++;
+            }
+        }
+        pthread_mutex_unlock(&transfer_engine.lock);
+
+        curl_multi_perform(transfer_engine.multi, &running);
+
+        CURLMsg* msg;
+        int msgs_left;
+        while ((msg = curl_multi_info_read(transfer_engine.multi, &msgs_left))) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            CURL* curl = msg->easy_handle;
+            CURLcode res = msg->data.result;
+            char* transfer = NULL;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, &transfer);
+            curl_multi_remove_handle(transfer_engine.multi, curl);
+            transfer_engine.active--;
+
+            _transfer_finish((HTTPTransfer*)transfer, res);
+        }
+
+        curl_multi_poll(transfer_engine.multi, NULL, 0, HTTP_TRANSFER_POLL_TIMEOUT, NULL);
+    }
+
+    return NULL;
+}
+
+static void
+_transfer_share_locks_destroy(void)
+{
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&transfer_engine.share_locks[i]);
+    }
+}
+
+static gboolean
+_transfer_engine_start(void)
+{
+    if (transfer_engine.running) {
+        return TRUE;
+    }
+
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    transfer_engine.quit = FALSE;
+    transfer_engine.active = 0;
+    transfer_engine.queued = g_queue_new();
+    transfer_engine.multi = curl_multi_init();
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&transfer_engine.share_locks[i], NULL);
+    }
+    transfer_engine.share = curl_share_init();
+    curl_share_setopt(transfer_engine.share, CURLSHOPT_LOCKFUNC, _transfer_share_lock);
+    curl_share_setopt(transfer_engine.share, CURLSHOPT_UNLOCKFUNC, _transfer_share_unlock);
+    curl_share_setopt(transfer_engine.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(transfer_engine.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_multi_setopt(transfer_engine.multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)HTTP_TRANSFER_MAX_ACTIVE);
+    pthread_mutex_init(&transfer_engine.lock, NULL);
+
+    if (pthread_create(&transfer_engine.thread, NULL, _transfer_engine_run, NULL) != 0) {
+        log_error("[HTTP] Unable to start transfer thread");
+        pthread_mutex_destroy(&transfer_engine.lock);
+        curl_share_cleanup(transfer_engine.share);
+        _transfer_share_locks_destroy();
+        curl_multi_cleanup(transfer_engine.multi);
+        g_queue_free(transfer_engine.queued);
+        curl_global_cleanup();
+        return FALSE;
+    }
+
+    transfer_engine.running = TRUE;
+    return TRUE;
+}
+
+/**
+ * Create a curl easy handle with the options shared by all transfers.
+ *
+ * @return the new handle, NULL if the transfer thread could not be started
+ */
+CURL*
+http_transfer_curl_new(void)
+{
+    if (!_transfer_engine_start()) {
+        return NULL;
+    }
+
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        return NULL;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_SHARE, transfer_engine.share);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "profanity");
+
+    auto_gchar gchar* cert_path = prefs_get_string(PREF_TLS_CERTPATH);
+    auto_gchar gchar* cafile = cafile_get_name();
+    if (cafile) {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, cafile);
+    }
+    if (cert_path) {
+        curl_easy_setopt(curl, CURLOPT_CAPATH, cert_path);
+    }
+
+    ProfAccount* account = accounts_get_account(session_get_account_name());
+    if (account) {
+        if (account->tls_policy && strcmp(account->tls_policy, "trust") == 0) {
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        }
+        account_free(account);
+    }
+
+    return curl;
+}
+
+/**
+ * Queue a transfer on the transfer thread. On success the transfer takes
+ * ownership of curl and frees it after done has been called.
+ *
+ * @param curl handle created by http_transfer_curl_new()
+ * @param progress called with rate limited progress updates, may be NULL
+ * @param done called once the transfer has finished or was canceled
+ * @param userdata passed to progress and done
+ * @return the transfer, NULL if too many transfers are queued
+ */
+HTTPTransfer*
+http_transfer_start(CURL* curl, HTTPTransferProgress progress, HTTPTransferDone done, void* userdata)
+{
+    if (!_transfer_engine_start()) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&transfer_engine.lock);
+    if (g_queue_get_length(transfer_engine.queued) >= HTTP_TRANSFER_MAX_QUEUED) {
+        pthread_mutex_unlock(&transfer_engine.lock);
+        log_warning("[HTTP] Too many queued transfers");
+        return NULL;
+    }
+
+    HTTPTransfer* transfer = g_new0(HTTPTransfer, 1);
+    transfer->curl = curl;
+    transfer->progress = progress;
+    transfer->done = done;
+    transfer->userdata = userdata;
+    transfer->refcnt = 1;
+
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, _transfer_xferinfo);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, transfer);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+
+    g_queue_push_tail(transfer_engine.queued, transfer);
+    pthread_mutex_unlock(&transfer_engine.lock);
+
+    curl_multi_wakeup(transfer_engine.multi);
+
+    return transfer;
+}
+
+void
+http_transfer_cancel(HTTPTransfer* transfer)
+{
+    g_atomic_int_set(&transfer->canceled, 1);
+    curl_multi_wakeup(transfer_engine.multi);
+}
+
+void
+http_transfer_close(void)
+{
+    if (!transfer_engine.running) {
+        return;
+    }
+
+    pthread_mutex_lock(&transfer_engine.lock);
+    transfer_engine.quit = TRUE;
+    pthread_mutex_unlock(&transfer_engine.lock);
+    curl_multi_wakeup(transfer_engine.multi);
+    pthread_join(transfer_engine.thread, NULL);
+
+    // Transfers that are still queued or running are dropped.
+    curl_multi_cleanup(transfer_engine.multi);
+    curl_share_cleanup(transfer_engine.share);
+    _transfer_share_locks_destroy();
+    g_queue_free(transfer_engine.queued);
+    pthread_mutex_destroy(&transfer_engine.lock);
+    curl_global_cleanup();
+
+    transfer_engine.running = FALSE;
+}
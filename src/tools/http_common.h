@@ -36,9 +36,22 @@
 #ifndef TOOLS_HTTP_COMMON_H
 #define TOOLS_HTTP_COMMON_H
 
+#include <curl/curl.h>
+
 #include "ui/window.h"
 
+typedef struct http_transfer_t HTTPTransfer;
+
+// Transfer callbacks, both are run on the main thread
+typedef void (*HTTPTransferProgress)(void* userdata, curl_off_t now, curl_off_t total);
+typedef void (*HTTPTransferDone)(void* userdata, CURL* curl, CURLcode res);
+
 void http_print_transfer(ProfWin* window, char* id, const char* fmt, ...);
 void http_print_transfer_update(ProfWin* window, char* id, const char* fmt, ...);
 
+CURL* http_transfer_curl_new(void);
+HTTPTransfer* http_transfer_start(CURL* curl, HTTPTransferProgress progress, HTTPTransferDone done, void* userdata);
+void http_transfer_cancel(HTTPTransfer* transfer);
+void http_transfer_close(void);
+
 #endif
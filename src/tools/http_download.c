@@ -44,166 +44,147 @@
 #include <sys/types.h>
 #include <curl/curl.h>
 #include <gio/gio.h>
-#include <pthread.h>
 #include <assert.h>
 #include <errno.h>
 
 #include "profanity.h"
 #include "event/client_events.h"
 #include "tools/http_download.h"
-#include "config/cafile.h"
-#include "config/preferences.h"
 #include "ui/ui.h"
 #include "ui/window.h"
 #include "common.h"
 
+#ifdef HAVE_OMEMO
+#include "omemo/omemo.h"
+#endif
+
 GSList* download_processes = NULL;
-gboolean silent = FALSE;
 
-static int
-_xferinfo(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+static void
+_download_progress(void* userdata, curl_off_t now, curl_off_t total)
 {
     HTTPDownload* download = (HTTPDownload*)userdata;
 
-    pthread_mutex_lock(&lock);
-
-    if (download->cancel) {
-        pthread_mutex_unlock(&lock);
-        return 1;
-    }
-
-    if (download->bytes_received == dlnow) {
-        pthread_mutex_unlock(&lock);
-        return 0;
-    } else {
-        download->bytes_received = dlnow;
+    if (download->bytes_received == now) {
+        return;
     }
+    download->bytes_received = now;
 
     unsigned int dlperc = 0;
-    if (dltotal != 0) {
-        dlperc = (100 * dlnow) / dltotal;
+    if (total != 0) {
+        dlperc = (100 * now) / total;
     }
 
-    if (!silent)
-        http_print_transfer_update(download->window, download->url,
+    if (!download->silent)
+        http_print_transfer_update(download->window, download->id,
                                    "Downloading '%s': %d%%", download->url, dlperc);
-
-    pthread_mutex_unlock(&lock);
-
-    return 0;
-}
-
-#if LIBCURL_VERSION_NUM < 0x072000
-static int
-_older_progress(void* p, double dltotal, double dlnow, double ultotal, double ulnow)
-{
-    return _xferinfo(p, (curl_off_t)dltotal, (curl_off_t)dlnow, (curl_off_t)ultotal, (curl_off_t)ulnow);
 }
-#endif
 
-void*
-http_file_get(void* userdata)
+#ifdef HAVE_OMEMO
+static size_t
+_omemo_write_callback(char* ptr, size_t size, size_t nmemb, void* userdata)
 {
     HTTPDownload* download = (HTTPDownload*)userdata;
+    size_t realsize = size * nmemb;
 
-    char* err = NULL;
+    gcry_error_t crypt_res = omemo_decrypt_stream_write(download->omemo_stream, (unsigned char*)ptr, realsize, download->outfh);
+    if (crypt_res != GPG_ERR_NO_ERROR) {
+        download->err = g_strdup_printf("Failed to decrypt file (%s).", gcry_strerror(crypt_res));
+        return 0;
+    }
 
-    CURL* curl;
-    CURLcode res;
-    silent = download->silent;
+    return realsize;
+}
+#endif
 
-    download->cancel = 0;
-    download->bytes_received = 0;
+static void
+_download_finish(HTTPDownload* download, gboolean success)
+{
+    if (success && download->cmd_template != NULL) {
+        // The URL of an encrypted file is of no use, pass the decrypted file.
+        const char* url = download->omemo_stream ? download->filename : download->url;
+        gchar** argv = format_call_external_argv(download->cmd_template,
+                                                 url,
+                                                 download->filename);
 
-    pthread_mutex_lock(&lock);
-    if (!silent) {
-        http_print_transfer(download->window, download->id,
-                            "Downloading '%s': 0%%", download->url);
-    }
+        // TODO: Log the error.
+        if (!call_external(argv)) {
+            http_print_transfer_update(download->window, download->id,
+                                       "Downloading '%s' failed: Unable to call "
+                                       "command '%s' with file at '%s' (%s).",
+                                       download->url,
+                                       download->cmd_template,
+                                       download->filename,
+                                       "TODO: Log the error");
+        }
 
-    FILE* outfh = fopen(download->filename, "wb");
-    if (outfh == NULL) {
-        http_print_transfer_update(download->window, download->id,
-                                   "Downloading '%s' failed: Unable to open "
-                                   "output file at '%s' for writing (%s).",
-                                   download->url, download->filename,
-                                   g_strerror(errno));
-        goto out;
+        g_strfreev(argv);
     }
 
-    gchar* cert_path = prefs_get_string(PREF_TLS_CERTPATH);
-    gchar* cafile = cafile_get_name();
-    ProfAccount* account = accounts_get_account(session_get_account_name());
-    gboolean insecure = FALSE;
-    if (account) {
-        insecure = account->tls_policy && strcmp(account->tls_policy, "trust") == 0;
+    if (download->on_complete) {
+        download->on_complete(download, success);
     }
-    account_free(account);
-    pthread_mutex_unlock(&lock);
-
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
 
-    curl_easy_setopt(curl, CURLOPT_URL, download->url);
+    download_processes = g_slist_remove(download_processes, download);
 
-#if LIBCURL_VERSION_NUM >= 0x072000
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, _xferinfo);
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, download);
-#else
-    curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, _older_progress);
-    curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, download);
+#ifdef HAVE_OMEMO
+    omemo_aesgcm_stream_free(download->omemo_stream);
 #endif
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)outfh);
+    g_free(download->err);
+    free(download->cmd_template);
+    free(download->id);
+    free(download->url);
+    free(download->filename);
+    free(download);
+}
 
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "profanity");
+static void
+_download_done(void* userdata, CURL* curl, CURLcode res)
+{
+    HTTPDownload* download = (HTTPDownload*)userdata;
 
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    // An error raised by the write callback takes precedence.
+    auto_gchar gchar* err = download->err;
+    download->err = NULL;
 
-    if (cafile) {
-        curl_easy_setopt(curl, CURLOPT_CAINFO, cafile);
-    }
-    if (cert_path) {
-        curl_easy_setopt(curl, CURLOPT_CAPATH, cert_path);
-    }
-    if (insecure) {
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    if (!err && res != CURLE_OK) {
+        err = g_strdup(curl_easy_strerror(res));
     }
 
-    if ((res = curl_easy_perform(curl)) != CURLE_OK) {
-        err = strdup(curl_easy_strerror(res));
+#ifdef HAVE_OMEMO
+    if (!err && download->omemo_stream) {
+        gcry_error_t crypt_res = omemo_decrypt_stream_finish(download->omemo_stream);
+        if (crypt_res != GPG_ERR_NO_ERROR) {
+            err = g_strdup_printf("Failed to decrypt file (%s).", gcry_strerror(crypt_res));
+        }
     }
+#endif
 
-    if (ftell(outfh) == 0) {
-        err = strdup("Output file is empty.");
+    if (!err && ftell(download->outfh) == 0) {
+        err = g_strdup("Output file is empty.");
     }
 
-    curl_easy_cleanup(curl);
-    curl_global_cleanup();
-
-    if (fclose(outfh) == EOF) {
-        err = strdup(g_strerror(errno));
+    if (fclose(download->outfh) == EOF && !err) {
+        err = g_strdup(g_strerror(errno));
     }
+    download->outfh = NULL;
 
-    pthread_mutex_lock(&lock);
-    g_free(cafile);
-    g_free(cert_path);
     if (err) {
+        // Don't leave unauthenticated cleartext behind.
+        if (download->omemo_stream) {
+            remove(download->filename);
+        }
+
         if (download->cancel) {
-            http_print_transfer_update(download->window, download->id,
-                                       "Downloading '%s' failed: "
-                                       "Download was canceled",
-                                       download->url);
+            // The window might be gone already.
+            cons_show_error("Downloading '%s' failed: Download was canceled", download->url);
         } else {
             http_print_transfer_update(download->window, download->id,
                                        "Downloading '%s' failed: %s",
                                        download->url, err);
         }
-        free(err);
     } else {
-        if (!download->cancel && !silent) {
+        if (!download->cancel && !download->silent) {
             http_print_transfer_update(download->window, download->id,
                                        "Downloading '%s': done\nSaved to '%s'",
                                        download->url, download->filename);
@@ -211,37 +192,66 @@ http_file_get(void* userdata)
         }
     }
 
-    if (download->cmd_template != NULL) {
-        gchar** argv = format_call_external_argv(download->cmd_template,
-                                                 download->url,
-                                                 download->filename);
+    _download_finish(download, err == NULL);
+}
 
-        // TODO: Log the error.
-        if (!call_external(argv)) {
-            http_print_transfer_update(download->window, download->id,
-                                       "Downloading '%s' failed: Unable to call "
-                                       "command '%s' with file at '%s' (%s).",
-                                       download->url,
-                                       download->cmd_template,
-                                       download->filename,
-                                       "TODO: Log the error");
-        }
+void
+http_file_get(HTTPDownload* download)
+{
+    download->cancel = 0;
+    download->bytes_received = 0;
+    download->transfer = NULL;
+    download->outfh = NULL;
+    download->err = NULL;
 
-        g_strfreev(argv);
-        free(download->cmd_template);
+    if (!download->silent) {
+        http_print_transfer(download->window, download->id,
+                            "Downloading '%s': 0%%", download->url);
     }
 
-out:
+    download->outfh = fopen(download->filename, "wb");
+    if (download->outfh == NULL) {
+        http_print_transfer_update(download->window, download->id,
+                                   "Downloading '%s' failed: Unable to open "
+                                   "output file at '%s' for writing (%s).",
+                                   download->url, download->filename,
+                                   g_strerror(errno));
+        _download_finish(download, FALSE);
+        return;
+    }
 
-    download_processes = g_slist_remove(download_processes, download);
-    pthread_mutex_unlock(&lock);
+    CURL* curl = http_transfer_curl_new();
+    if (curl) {
+        curl_easy_setopt(curl, CURLOPT_URL, download->url);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)download->outfh);
+#ifdef HAVE_OMEMO
+        if (download->omemo_stream) {
+            // Decrypt the ciphertext as it arrives and only write the cleartext.
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _omemo_write_callback);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)download);
+        }
+#endif
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
 
-    free(download->id);
-    free(download->url);
-    free(download->filename);
-    free(download);
+        download->transfer = http_transfer_start(curl, _download_progress, _download_done, download);
+        if (!download->transfer) {
+            curl_easy_cleanup(curl);
+        }
+    }
+
+    if (!download->transfer) {
+        fclose(download->outfh);
+        download->outfh = NULL;
+        remove(download->filename);
+        http_print_transfer_update(download->window, download->id,
+                                   "Downloading '%s' failed: Too many transfers "
+                                   "in progress.",
+                                   download->url);
+        _download_finish(download, FALSE);
+        return;
+    }
 
-    return NULL;
+    download_processes = g_slist_append(download_processes, download);
 }
 
 void
@@ -252,14 +262,8 @@ http_download_cancel_processes(ProfWin* window)
         HTTPDownload* download = download_process->data;
         if (download->window == window) {
             download->cancel = 1;
-            break;
+            http_transfer_cancel(download->transfer);
         }
         download_process = g_slist_next(download_process);
     }
 }
-
-void
-http_download_add_download(HTTPDownload* download)
-{
-    download_processes = g_slist_append(download_processes, download);
-}
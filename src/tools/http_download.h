@@ -54,15 +54,23 @@ typedef struct http_download_t
     char* filename;
     char* cmd_template;
     curl_off_t bytes_received;
+    // Decrypts the received data before it is written to filename
+    // (NULL for unencrypted downloads)
+    struct omemo_aesgcm_stream_t* omemo_stream;
+    // Called once the download has finished, before it is freed
+    // (NULL if nothing else needs to be done)
+    void (*on_complete)(struct http_download_t* download, gboolean success);
     ProfWin* window;
-    pthread_t worker;
+    HTTPTransfer* transfer;
+    FILE* outfh;
+    // Error raised while receiving data
+    gchar* err;
     int cancel;
     gboolean silent;
 } HTTPDownload;
 
-void* http_file_get(void* userdata);
+void http_file_get(HTTPDownload* download);
 
 void http_download_cancel_processes(ProfWin* window);
-void http_download_add_download(HTTPDownload* download);
 
 #endif
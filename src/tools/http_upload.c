@@ -42,53 +42,63 @@
 #include <sys/types.h>
 #include <curl/curl.h>
 #include <gio/gio.h>
-#include <pthread.h>
 #include <assert.h>
 
 #include "profanity.h"
 #include "event/client_events.h"
+#include "tools/http_common.h"
 #include "tools/http_upload.h"
-#include "config/cafile.h"
-#include "config/preferences.h"
 #include "ui/ui.h"
 #include "ui/window.h"
 #include "common.h"
 
+#ifdef HAVE_OMEMO
+#include "omemo/omemo.h"
+#endif
+
 #define FALLBACK_MIMETYPE           "application/octet-stream"
 #define FALLBACK_CONTENTTYPE_HEADER "Content-Type: application/octet-stream"
 #define FALLBACK_MSG                ""
 #define FILE_HEADER_BYTES           512
 
-struct curl_data_t
-{
-    char* buffer;
-    size_t size;
-};
-
 GSList* upload_processes = NULL;
 
-static int
-_xferinfo(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+static void
+_upload_free(HTTPUpload* upload)
 {
-    HTTPUpload* upload = (HTTPUpload*)userdata;
+    if (upload->filehandle) {
+        fclose(upload->filehandle);
+    }
+#ifdef HAVE_OMEMO
+    omemo_aesgcm_stream_free(upload->omemo_stream);
+#endif
+    curl_slist_free_all(upload->headers);
 
-    pthread_mutex_lock(&lock);
+    free(upload->filename);
+    free(upload->mime_type);
+    free(upload->get_url);
+    free(upload->put_url);
+    free(upload->alt_scheme);
+    free(upload->alt_fragment);
+    free(upload->authorization);
+    free(upload->cookie);
+    free(upload->expires);
+    free(upload);
+}
 
-    if (upload->cancel) {
-        pthread_mutex_unlock(&lock);
-        return 1;
-    }
+static void
+_upload_progress(void* userdata, curl_off_t now, curl_off_t total)
+{
+    HTTPUpload* upload = (HTTPUpload*)userdata;
 
-    if (upload->bytes_sent == ulnow) {
-        pthread_mutex_unlock(&lock);
-        return 0;
-    } else {
-        upload->bytes_sent = ulnow;
+    if (upload->bytes_sent == now) {
+        return;
     }
+    upload->bytes_sent = now;
 
     unsigned int ulperc = 0;
-    if (ultotal != 0) {
-        ulperc = (100 * ulnow) / ultotal;
+    if (total != 0) {
+        ulperc = (100 * now) / total;
     }
 
     gchar* msg = g_strdup_printf("Uploading '%s': %d%%", upload->filename, ulperc);
@@ -97,35 +107,31 @@ _xferinfo(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultot
     }
     win_update_entry_message(upload->window, upload->put_url, msg);
     g_free(msg);
-
-    pthread_mutex_unlock(&lock);
-
-    return 0;
 }
 
-#if LIBCURL_VERSION_NUM < 0x072000
-static int
-_older_progress(void* p, double dltotal, double dlnow, double ultotal, double ulnow)
+static size_t
+_data_callback(void* ptr, size_t size, size_t nmemb, void* data)
 {
-    return _xferinfo(p, (curl_off_t)dltotal, (curl_off_t)dlnow, (curl_off_t)ultotal, (curl_off_t)ulnow);
+    // The response body isn't used, only the status code.
+    return size * nmemb;
 }
-#endif
 
+#ifdef HAVE_OMEMO
 static size_t
-_data_callback(void* ptr, size_t size, size_t nmemb, void* data)
+_omemo_read_callback(char* buffer, size_t size, size_t nitems, void* userdata)
 {
-    size_t realsize = size * nmemb;
-    struct curl_data_t* mem = (struct curl_data_t*)data;
-    mem->buffer = realloc(mem->buffer, mem->size + realsize + 1);
-
-    if (mem->buffer) {
-        memcpy(&(mem->buffer[mem->size]), ptr, realsize);
-        mem->size += realsize;
-        mem->buffer[mem->size] = 0;
+    HTTPUpload* upload = (HTTPUpload*)userdata;
+    gcry_error_t crypt_res;
+
+    size_t bytes = omemo_encrypt_stream_read(upload->omemo_stream, upload->filehandle,
+                                             (unsigned char*)buffer, size * nitems, &crypt_res);
+    if (crypt_res != GPG_ERR_NO_ERROR) {
+        return CURL_READFUNC_ABORT;
     }
 
-    return realsize;
+    return bytes;
 }
+#endif
 
 int
 format_alt_url(char* original_url, char* new_scheme, char* new_fragment, char** new_url)
@@ -156,154 +162,24 @@ out:
     return ret;
 }
 
-void*
-http_file_put(void* userdata)
+static void
+_upload_done(void* userdata, CURL* curl, CURLcode res)
 {
     HTTPUpload* upload = (HTTPUpload*)userdata;
 
-    FILE* fh = NULL;
-
     auto_char char* err = NULL;
-    gchar* content_type_header;
-    // Optional headers
-    gchar* auth_header = NULL;
-    gchar* cookie_header = NULL;
-    gchar* expires_header = NULL;
-
-    CURL* curl;
-    CURLcode res;
-
-    upload->cancel = 0;
-    upload->bytes_sent = 0;
-
-    pthread_mutex_lock(&lock);
-    gchar* msg = g_strdup_printf("Uploading '%s': 0%%", upload->filename);
-    if (!msg) {
-        msg = g_strdup(FALLBACK_MSG);
-    }
-    win_print_http_transfer(upload->window, msg, upload->put_url);
-    g_free(msg);
-
-    auto_gchar gchar* cert_path = prefs_get_string(PREF_TLS_CERTPATH);
-    gchar* cafile = cafile_get_name();
-    gboolean insecure = FALSE;
-    ProfAccount* account = accounts_get_account(session_get_account_name());
-    if (account) {
-        insecure = account->tls_policy && strcmp(account->tls_policy, "trust") == 0;
-    }
-    account_free(account);
-    pthread_mutex_unlock(&lock);
-
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
-
-    curl_easy_setopt(curl, CURLOPT_URL, upload->put_url);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-
-    struct curl_slist* headers = NULL;
-    content_type_header = g_strdup_printf("Content-Type: %s", upload->mime_type);
-    if (!content_type_header) {
-        content_type_header = g_strdup(FALLBACK_CONTENTTYPE_HEADER);
-    }
-    headers = curl_slist_append(headers, content_type_header);
-    headers = curl_slist_append(headers, "Expect:");
-
-    // Optional headers
-    if (upload->authorization) {
-        auth_header = g_strdup_printf("Authorization: %s", upload->authorization);
-        if (!auth_header) {
-            auth_header = g_strdup(FALLBACK_MSG);
-        }
-        headers = curl_slist_append(headers, auth_header);
-    }
-    if (upload->cookie) {
-        cookie_header = g_strdup_printf("Cookie: %s", upload->cookie);
-        if (!cookie_header) {
-            cookie_header = g_strdup(FALLBACK_MSG);
-        }
-        headers = curl_slist_append(headers, cookie_header);
-    }
-    if (upload->expires) {
-        expires_header = g_strdup_printf("Expires: %s", upload->expires);
-        if (!expires_header) {
-            expires_header = g_strdup(FALLBACK_MSG);
-        }
-        headers = curl_slist_append(headers, expires_header);
-    }
-
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-#if LIBCURL_VERSION_NUM >= 0x072000
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, _xferinfo);
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, upload);
-#else
-    curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, _older_progress);
-    curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, upload);
-#endif
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-
-    struct curl_data_t output;
-    output.buffer = NULL;
-    output.size = 0;
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _data_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)&output);
-
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "profanity");
-
-    fh = upload->filehandle;
-
-    if (cafile) {
-        curl_easy_setopt(curl, CURLOPT_CAINFO, cafile);
-    }
-    if (cert_path) {
-        curl_easy_setopt(curl, CURLOPT_CAPATH, cert_path);
-    }
-    if (insecure) {
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-    }
-
-    curl_easy_setopt(curl, CURLOPT_READDATA, fh);
-    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)(upload->filesize));
-    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
 
-    if ((res = curl_easy_perform(curl)) != CURLE_OK) {
+    if (res != CURLE_OK) {
         err = strdup(curl_easy_strerror(res));
     } else {
         long http_code = 0;
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
 
-        if (output.buffer) {
-            output.buffer[output.size++] = '\0';
-        }
-
         // XEP-0363 specifies 201 but prosody returns 200
         if (http_code != 200 && http_code != 201) {
             err = g_strdup_printf("Server returned %lu", http_code);
         }
-
-#if 0
-        printf("HTTP Status: %lu\n", http_code);
-        printf("%s\n", output.buffer);
-        printf("%lu bytes retrieved\n", (long)output.size);
-#endif
-    }
-
-    curl_easy_cleanup(curl);
-    curl_global_cleanup();
-    curl_slist_free_all(headers);
-
-    if (fh) {
-        fclose(fh);
     }
-    free(output.buffer);
-    g_free(content_type_header);
-    g_free(auth_header);
-    g_free(cookie_header);
-    g_free(expires_header);
-
-    pthread_mutex_lock(&lock);
-    g_free(cafile);
 
     if (err) {
         gchar* msg;
@@ -323,7 +199,7 @@ http_file_put(void* userdata)
         g_free(msg);
     } else {
         if (!upload->cancel) {
-            msg = g_strdup_printf("Uploading '%s': 100%%", upload->filename);
+            gchar* msg = g_strdup_printf("Uploading '%s': 100%%", upload->filename);
             if (!msg) {
                 msg = g_strdup(FALLBACK_MSG);
             }
@@ -372,20 +248,94 @@ http_file_put(void* userdata)
     }
 
     upload_processes = g_slist_remove(upload_processes, upload);
-    pthread_mutex_unlock(&lock);
+    _upload_free(upload);
+}
 
-    free(upload->filename);
-    free(upload->mime_type);
-    free(upload->get_url);
-    free(upload->put_url);
-    free(upload->alt_scheme);
-    free(upload->alt_fragment);
-    free(upload->authorization);
-    free(upload->cookie);
-    free(upload->expires);
-    free(upload);
+void
+http_file_put(HTTPUpload* upload)
+{
+    upload->cancel = 0;
+    upload->bytes_sent = 0;
+    upload->headers = NULL;
+
+    gchar* msg = g_strdup_printf("Uploading '%s': 0%%", upload->filename);
+    if (!msg) {
+        msg = g_strdup(FALLBACK_MSG);
+    }
+    win_print_http_transfer(upload->window, msg, upload->put_url);
+    g_free(msg);
+
+    CURL* curl = http_transfer_curl_new();
+    if (!curl) {
+        cons_show_error("Uploading '%s' failed: Unable to start transfer", upload->filename);
+        _upload_free(upload);
+        return;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, upload->put_url);
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
 
-    return NULL;
+    auto_gchar gchar* content_type_header = g_strdup_printf("Content-Type: %s", upload->mime_type);
+    if (!content_type_header) {
+        content_type_header = g_strdup(FALLBACK_CONTENTTYPE_HEADER);
+    }
+    upload->headers = curl_slist_append(upload->headers, content_type_header);
+    upload->headers = curl_slist_append(upload->headers, "Expect:");
+
+    // Optional headers
+    if (upload->authorization) {
+        auto_gchar gchar* auth_header = g_strdup_printf("Authorization: %s", upload->authorization);
+        if (!auth_header) {
+            auth_header = g_strdup(FALLBACK_MSG);
+        }
+        upload->headers = curl_slist_append(upload->headers, auth_header);
+    }
+    if (upload->cookie) {
+        auto_gchar gchar* cookie_header = g_strdup_printf("Cookie: %s", upload->cookie);
+        if (!cookie_header) {
+            cookie_header = g_strdup(FALLBACK_MSG);
+        }
+        upload->headers = curl_slist_append(upload->headers, cookie_header);
+    }
+    if (upload->expires) {
+        auto_gchar gchar* expires_header = g_strdup_printf("Expires: %s", upload->expires);
+        if (!expires_header) {
+            expires_header = g_strdup(FALLBACK_MSG);
+        }
+        upload->headers = curl_slist_append(upload->headers, expires_header);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, upload->headers);
+
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _data_callback);
+
+    curl_easy_setopt(curl, CURLOPT_READDATA, upload->filehandle);
+#ifdef HAVE_OMEMO
+    if (upload->omemo_stream) {
+        // Encrypt the file chunk by chunk while it's uploaded, so no
+        // ciphertext copy has to be written to disk beforehand.
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, _omemo_read_callback);
+        curl_easy_setopt(curl, CURLOPT_READDATA, upload);
+    }
+#endif
+    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)(upload->filesize));
+    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+
+    upload->transfer = http_transfer_start(curl, _upload_progress, _upload_done, upload);
+    if (!upload->transfer) {
+        curl_easy_cleanup(curl);
+        msg = g_strdup_printf("Uploading '%s' failed: Too many transfers in progress", upload->filename);
+        if (!msg) {
+            msg = g_strdup(FALLBACK_MSG);
+        }
+        win_update_entry_message(upload->window, upload->put_url, msg);
+        cons_show_error(msg);
+        g_free(msg);
+        _upload_free(upload);
+        return;
+    }
+
+    upload_processes = g_slist_append(upload_processes, upload);
 }
 
 char*
@@ -426,14 +376,8 @@ http_upload_cancel_processes(ProfWin* window)
         HTTPUpload* upload = upload_process->data;
         if (upload->window == window) {
             upload->cancel = 1;
-            break;
+            http_transfer_cancel(upload->transfer);
         }
         upload_process = g_slist_next(upload_process);
     }
 }
-
-void
-http_upload_add_upload(HTTPUpload* upload)
-{
-    upload_processes = g_slist_append(upload_processes, upload);
-}
@@ -56,8 +56,12 @@ typedef struct http_upload_t
     char* put_url;
     char* alt_scheme;
     char* alt_fragment;
+    // Encrypts the file contents while they are read by curl
+    // (NULL for unencrypted uploads)
+    struct omemo_aesgcm_stream_t* omemo_stream;
     ProfWin* window;
-    pthread_t worker;
+    struct http_transfer_t* transfer;
+    struct curl_slist* headers;
     int cancel;
     // Additional headers
     // (NULL if they shouldn't be send in the PUT)
@@ -66,12 +70,11 @@ typedef struct http_upload_t
     char* expires;
 } HTTPUpload;
 
-void* http_file_put(void* userdata);
+void http_file_put(HTTPUpload* upload);
 
 char* file_mime_type(const char* const filename);
 off_t file_size(int filedes);
 
 void http_upload_cancel_processes(ProfWin* window);
-void http_upload_add_upload(HTTPUpload* upload);
 
 #endif
@@ -0,0 +1,174 @@
+/*
+ * notify_queue.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2024 Michael Vetter <jubalh@iodoru.org>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "log.h"
+#include "tools/notify_queue.h"
+
+struct notify_queue_t
+{
+    GMutex lock;
+    GCond cond;
+    GQueue* requests;
+    GHashTable* by_key;
+    guint max_length;
+    gboolean closed;
+};
+
+NotifyQueue*
+notify_queue_new(guint max_length)
+{
+    NotifyQueue* queue = g_new0(NotifyQueue, 1);
+    g_mutex_init(&queue->lock);
+    g_cond_init(&queue->cond);
+    queue->requests = g_queue_new();
+    queue->by_key = g_hash_table_new(g_str_hash, g_str_equal);
+    queue->max_length = MAX(max_length, 1);
+
+    return queue;
+}
+
+void
+notify_queue_free(NotifyQueue* queue)
+{
+    if (queue) {
+        g_hash_table_destroy(queue->by_key);
+        g_queue_free_full(queue->requests, (GDestroyNotify)notify_request_free);
+        g_cond_clear(&queue->cond);
+        g_mutex_clear(&queue->lock);
+        g_free(queue);
+    }
+}
+
+void
+notify_request_free(NotifyRequest* request)
+{
+    if (request) {
+        g_free(request->key);
+        g_free(request->message);
+        g_free(request->category);
+        g_free(request);
+    }
+}
+
+void
+notify_queue_push(NotifyQueue* queue, const char* const key, const char* const message, int timeout, const char* const category)
+{
+    g_mutex_lock(&queue->lock);
+
+    if (queue->closed) {
+        g_mutex_unlock(&queue->lock);
+        return;
+    }
+
+    NotifyRequest* request = key ? g_hash_table_lookup(queue->by_key, key) : NULL;
+    if (request) {
+        // keep the place in the queue, show the latest text
+        g_free(request->message);
+        request->message = g_strdup(message);
+        g_free(request->category);
+        request->category = g_strdup(category);
+        request->timeout = timeout;
+        request->count++;
+    } else {
+        if (g_queue_get_length(queue->requests) >= queue->max_length) {
+            NotifyRequest* oldest = g_queue_pop_head(queue->requests);
+            if (oldest->key) {
+                g_hash_table_remove(queue->by_key, oldest->key);
+            }
+            log_debug("Notification queue full, dropping: %s", oldest->message);
+            notify_request_free(oldest);
+        }
+
+        request = g_new0(NotifyRequest, 1);
+        request->key = g_strdup(key);
+        request->message = g_strdup(message);
+        request->category = g_strdup(category);
+        request->timeout = timeout;
+        request->count = 1;
+        g_queue_push_tail(queue->requests, request);
+        if (request->key) {
+            g_hash_table_insert(queue->by_key, request->key, request);
+        }
+        g_cond_signal(&queue->cond);
+    }
+
+    g_mutex_unlock(&queue->lock);
+}
+
+/* Waits for the next request. Returns NULL once the queue is closed. */
+NotifyRequest*
+notify_queue_pop(NotifyQueue* queue)
+{
+    g_mutex_lock(&queue->lock);
+
+    while (!queue->closed && g_queue_is_empty(queue->requests)) {
+        g_cond_wait(&queue->cond, &queue->lock);
+    }
+
+    NotifyRequest* request = NULL;
+    if (!queue->closed) {
+        request = g_queue_pop_head(queue->requests);
+        if (request->key) {
+            g_hash_table_remove(queue->by_key, request->key);
+        }
+    }
+
+    g_mutex_unlock(&queue->lock);
+
+    return request;
+}
+
+void
+notify_queue_close(NotifyQueue* queue)
+{
+    g_mutex_lock(&queue->lock);
+    queue->closed = TRUE;
+    g_cond_broadcast(&queue->cond);
+    g_mutex_unlock(&queue->lock);
+}
+
+guint
+notify_queue_length(NotifyQueue* queue)
+{
+    g_mutex_lock(&queue->lock);
+    guint length = g_queue_get_length(queue->requests);
+    g_mutex_unlock(&queue->lock);
+
+    return length;
+}
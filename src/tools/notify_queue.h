@@ -0,0 +1,69 @@
+/*
+ * notify_queue.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2024 Michael Vetter <jubalh@iodoru.org>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_NOTIFY_QUEUE_H
+#define TOOLS_NOTIFY_QUEUE_H
+
+#include <glib.h>
+
+/*
+ * Bounded queue of desktop notifications, shared by the main thread
+ * which pushes and the notifier worker which pops.
+ *
+ * A request pushed with a key replaces a pending request with the same
+ * key, adding to its count. When the queue is full the oldest request is
+ * dropped.
+ */
+
+typedef struct notify_request_t
+{
+    gchar* key;
+    gchar* message;
+    gchar* category;
+    int timeout;
+    int count;
+} NotifyRequest;
+
+typedef struct notify_queue_t NotifyQueue;
+
+NotifyQueue* notify_queue_new(guint max_length);
+void notify_queue_free(NotifyQueue* queue);
+void notify_queue_push(NotifyQueue* queue, const char* const key, const char* const message, int timeout, const char* const category);
+NotifyRequest* notify_queue_pop(NotifyQueue* queue);
+void notify_queue_close(NotifyQueue* queue);
+guint notify_queue_length(NotifyQueue* queue);
+void notify_request_free(NotifyRequest* request);
+
+#endif
@@ -0,0 +1,263 @@
+/*
+ * perf.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2024 Michael Vetter <jubalh@iodoru.org>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "log.h"
+#include "common.h"
+#include "tools/perf.h"
+
+gboolean perf_enabled = FALSE;
+
+static GHashTable* metrics = NULL;
+static GString* lookup_key = NULL;
+static int log_interval = 0;
+static gint64 last_log = 0;
+
+static void
+_metric_free(ProfPerfMetric* metric)
+{
+    if (metric) {
+        g_free(metric->name);
+        g_free(metric);
+    }
+}
+
+static ProfPerfMetric*
+_get_metric(const char* const name, const char* const detail, gboolean timed)
+{
+    perf_init();
+
+    const char* key = name;
+    if (detail) {
+        g_string_printf(lookup_key, "%s:%s", name, detail);
+        key = lookup_key->str;
+    }
+
+    ProfPerfMetric* metric = g_hash_table_lookup(metrics, key);
+    if (!metric) {
+        metric = g_new0(ProfPerfMetric, 1);
+        metric->name = g_strdup(key);
+        metric->timed = timed;
+        g_hash_table_insert(metrics, metric->name, metric);
+    }
+
+    return metric;
+}
+
+static gint
+_cmp_metrics(gconstpointer a, gconstpointer b)
+{
+    const ProfPerfMetric* metric_a = a;
+    const ProfPerfMetric* metric_b = b;
+
+    // timed metrics first, the most expensive at the top, then counters by name
+    if (metric_a->timed != metric_b->timed) {
+        return metric_a->timed ? -1 : 1;
+    }
+    if (metric_a->timed && metric_a->total_us != metric_b->total_us) {
+        return metric_a->total_us > metric_b->total_us ? -1 : 1;
+    }
+
+    return g_strcmp0(metric_a->name, metric_b->name);
+}
+
+void
+perf_init(void)
+{
+    if (!metrics) {
+        metrics = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)_metric_free);
+        lookup_key = g_string_new(NULL);
+    }
+}
+
+void
+perf_close(void)
+{
+    perf_enabled = FALSE;
+    log_interval = 0;
+    if (metrics) {
+        g_hash_table_destroy(metrics);
+        metrics = NULL;
+        g_string_free(lookup_key, TRUE);
+        lookup_key = NULL;
+    }
+}
+
+void
+perf_set_enabled(gboolean enabled)
+{
+    if (enabled) {
+        perf_init();
+        last_log = g_get_monotonic_time();
+    }
+    perf_enabled = enabled;
+}
+
+void
+perf_reset(void)
+{
+    if (metrics) {
+        g_hash_table_remove_all(metrics);
+    }
+}
+
+void
+perf_record(const char* const name, const char* const detail, gint64 elapsed_us)
+{
+    if (!perf_enabled) {
+        return;
+    }
+
+    if (elapsed_us < 0) {
+        elapsed_us = 0;
+    }
+
+    ProfPerfMetric* metric = _get_metric(name, detail, TRUE);
+    if (metric->count == 0 || elapsed_us < metric->min_us) {
+        metric->min_us = elapsed_us;
+    }
+    if (elapsed_us > metric->max_us) {
+        metric->max_us = elapsed_us;
+    }
+    metric->count++;
+    metric->total_us += elapsed_us;
+
+    // bucket 0 holds 0us, bucket i holds [2^(i-1), 2^i) us
+    guint bucket = elapsed_us == 0 ? 0 : g_bit_storage((guint64)elapsed_us);
+    metric->buckets[MIN(bucket, PERF_BUCKETS - 1)]++;
+}
+
+void
+perf_count(const char* const name, const char* const detail, guint64 n)
+{
+    if (!perf_enabled) {
+        return;
+    }
+
+    ProfPerfMetric* metric = _get_metric(name, detail, FALSE);
+    metric->count += n;
+}
+
+GList*
+perf_get_metrics(void)
+{
+    if (!metrics) {
+        return NULL;
+    }
+
+    return g_list_sort(g_hash_table_get_values(metrics), _cmp_metrics);
+}
+
+gint64
+perf_metric_percentile(const ProfPerfMetric* const metric, double percentile)
+{
+    if (!metric->timed || metric->count == 0) {
+        return 0;
+    }
+
+    guint64 rank = (guint64)(percentile * (metric->count - 1)) + 1;
+    guint64 seen = 0;
+    for (int i = 0; i < PERF_BUCKETS; i++) {
+        seen += metric->buckets[i];
+        if (seen >= rank) {
+            gint64 upper = i == 0 ? 0 : ((gint64)1 << i) - 1;
+            return MIN(upper, metric->max_us);
+        }
+    }
+
+    return metric->max_us;
+}
+
+gchar*
+perf_metric_summary(const ProfPerfMetric* const metric)
+{
+    if (!metric->timed) {
+        return g_strdup_printf("count=%" G_GUINT64_FORMAT, metric->count);
+    }
+
+    return g_strdup_printf("count=%" G_GUINT64_FORMAT " total=%" G_GINT64_FORMAT "ms avg=%" G_GINT64_FORMAT "us"
+                           " min=%" G_GINT64_FORMAT "us p50=%" G_GINT64_FORMAT "us p95=%" G_GINT64_FORMAT "us"
+                           " p99=%" G_GINT64_FORMAT "us max=%" G_GINT64_FORMAT "us",
+                           metric->count,
+                           metric->total_us / 1000,
+                           metric->total_us / (gint64)metric->count,
+                           metric->min_us,
+                           perf_metric_percentile(metric, 0.50),
+                           perf_metric_percentile(metric, 0.95),
+                           perf_metric_percentile(metric, 0.99),
+                           metric->max_us);
+}
+
+void
+perf_set_log_interval(int seconds)
+{
+    log_interval = seconds > 0 ? seconds : 0;
+    last_log = g_get_monotonic_time();
+}
+
+int
+perf_get_log_interval(void)
+{
+    return log_interval;
+}
+
+void
+perf_log_check(void)
+{
+    if (!perf_enabled || log_interval == 0) {
+        return;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    if (now - last_log >= (gint64)log_interval * G_USEC_PER_SEC) {
+        perf_log_dump();
+        last_log = now;
+    }
+}
+
+void
+perf_log_dump(void)
+{
+    GList* list = perf_get_metrics();
+    for (GList* curr = list; curr; curr = g_list_next(curr)) {
+        ProfPerfMetric* metric = curr->data;
+        auto_gchar gchar* summary = perf_metric_summary(metric);
+        log_info("perf: %s %s", metric->name, summary);
+    }
+    g_list_free(list);
+}
@@ -0,0 +1,115 @@
+/*
+ * perf.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2024 Michael Vetter <jubalh@iodoru.org>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_PERF_H
+#define TOOLS_PERF_H
+
+#include <glib.h>
+
+/*
+ * Runtime instrumentation shown by /perf.
+ *
+ * Metrics are created on first use and keyed by name, or by "name:detail"
+ * when a detail such as a plugin name is given. A timed metric keeps the
+ * number of samples, total, min and max time and a histogram with log2
+ * buckets in microseconds, a counter only keeps its count.
+ *
+ * Only call these from the main thread. While perf is disabled a timer is
+ * a single flag test and nothing is recorded.
+ */
+
+#define PERF_BUCKETS 32
+
+typedef struct prof_perf_metric_t
+{
+    gchar* name;
+    gboolean timed;
+    guint64 count;
+    gint64 total_us;
+    gint64 min_us;
+    gint64 max_us;
+    guint64 buckets[PERF_BUCKETS];
+} ProfPerfMetric;
+
+typedef struct prof_perf_timer_t
+{
+    const char* name;
+    const char* detail;
+    gint64 start;
+} ProfPerfTimer;
+
+extern gboolean perf_enabled;
+
+void perf_init(void);
+void perf_close(void);
+void perf_set_enabled(gboolean enabled);
+void perf_reset(void);
+void perf_record(const char* const name, const char* const detail, gint64 elapsed_us);
+void perf_count(const char* const name, const char* const detail, guint64 n);
+GList* perf_get_metrics(void);
+gint64 perf_metric_percentile(const ProfPerfMetric* const metric, double percentile);
+gchar* perf_metric_summary(const ProfPerfMetric* const metric);
+void perf_set_log_interval(int seconds);
+int perf_get_log_interval(void);
+void perf_log_check(void);
+void perf_log_dump(void);
+
+static inline ProfPerfTimer
+perf_timer_start(const char* const name, const char* const detail)
+{
+    ProfPerfTimer timer = { name, detail, perf_enabled ? g_get_monotonic_time() : 0 };
+    return timer;
+}
+
+static inline void
+perf_timer_stop(ProfPerfTimer* timer)
+{
+    if (timer->start) {
+        perf_record(timer->name, timer->detail, g_get_monotonic_time() - timer->start);
+        timer->start = 0;
+    }
+}
+
+/**
+ * Stops a ProfPerfTimer when it goes out of scope.
+ *
+ * Example:
+ * ```
+ * auto_perf ProfPerfTimer timer = perf_timer_start("xmpp.message", NULL);
+ * ```
+ */
+#define auto_perf __attribute__((__cleanup__(perf_timer_stop)))
+
+#endif
@@ -43,7 +43,6 @@
 #include <sys/types.h>
 #include <curl/curl.h>
 #include <gio/gio.h>
-#include <pthread.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -59,21 +58,21 @@
 
 #define FALLBACK_MSG ""
 
-void*
-plugin_download_install(void* userdata)
+static void
+_plugin_download_complete(HTTPDownload* plugin_dl, gboolean success)
 {
-    HTTPDownload* plugin_dl = (HTTPDownload*)userdata;
-
-    auto_char char* path = strdup(plugin_dl->filename);
-    auto_char char* https_url = strdup(plugin_dl->url);
-    plugin_dl->silent = TRUE;
-
-    http_file_get(plugin_dl);
+    if (!success) {
+        // whatever was written is partial, don't install it
+        auto_char char* plugin_name = basename_from_url(plugin_dl->url);
+        cons_show_error("Failed to install plugin: %s. The download failed.", plugin_name);
+        remove(plugin_dl->filename);
+        return;
+    }
 
-    if (is_regular_file(path)) {
+    if (is_regular_file(plugin_dl->filename)) {
         GString* error_message = g_string_new(NULL);
-        auto_char char* plugin_name = basename_from_url(https_url);
-        gboolean result = plugins_install(plugin_name, path, error_message);
+        auto_char char* plugin_name = basename_from_url(plugin_dl->url);
+        gboolean result = plugins_install(plugin_name, plugin_dl->filename, error_message);
         if (result) {
             cons_show("Plugin installed and loaded: %s", plugin_name);
         } else {
@@ -84,13 +83,14 @@ plugin_download_install(void* userdata)
         cons_show_error("Downloaded file is not a file (?)");
     }
 
-    remove(path);
-
-    return NULL;
+    remove(plugin_dl->filename);
 }
 
 void
-plugin_download_add_download(HTTPDownload* plugin_dl)
+plugin_download_install(HTTPDownload* plugin_dl)
 {
-    http_download_add_download(plugin_dl);
+    plugin_dl->silent = TRUE;
+    plugin_dl->on_complete = _plugin_download_complete;
+
+    http_file_get(plugin_dl);
 }
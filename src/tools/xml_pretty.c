@@ -0,0 +1,114 @@
+/*
+ * xml_pretty.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2024 Michael Vetter <jubalh@iodoru.org>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+
+#include "common.h"
+#include "tools/xml_pretty.h"
+
+// One element per line, indented by depth; text content stays on the line of its element
+gchar*
+xml_pretty_print(const char* const xml)
+{
+    GString* out = g_string_sized_new(strlen(xml) * 2);
+    int depth = 0;
+    gboolean after_text = FALSE;
+    const char* p = xml;
+
+    while (*p) {
+        if (*p != '<') {
+            const char* next = strchr(p, '<');
+            size_t len = next ? (size_t)(next - p) : strlen(p);
+            auto_gchar gchar* text = g_strndup(p, len);
+            g_strstrip(text);
+            if (text[0] != '\0') {
+                g_string_append(out, text);
+                after_text = TRUE;
+            }
+            p += len;
+            continue;
+        }
+
+        const char* end = strchr(p, '>');
+        if (end == NULL) {
+            g_string_append(out, p);
+            break;
+        }
+
+        gboolean closing = p[1] == '/';
+        gboolean self_closing = end[-1] == '/' || p[1] == '?' || p[1] == '!';
+        if (closing && depth > 0) {
+            depth--;
+        }
+        if (out->len > 0 && !(closing && after_text)) {
+            g_string_append_c(out, '\n');
+            for (int i = 0; i < depth; i++) {
+                g_string_append(out, "  ");
+            }
+        }
+        g_string_append_len(out, p, end + 1 - p);
+        if (!closing && !self_closing) {
+            depth++;
+        }
+        after_text = FALSE;
+        p = end + 1;
+    }
+
+    return g_string_free(out, FALSE);
+}
+
+// A copy of text cut to at most max bytes at a character boundary, noting how much was left out
+gchar*
+xml_pretty_truncate(const char* const text, gsize max)
+{
+    gsize len = strlen(text);
+    if (len <= max) {
+        return g_strdup(text);
+    }
+
+    const char* cut = text + max;
+    if (((guchar)*cut & 0xC0) == 0x80) {
+        // inside a multi-byte character, keep it out
+        const char* start = g_utf8_find_prev_char(text, cut);
+        cut = start ? start : text;
+    }
+    gsize kept = cut - text;
+
+    return g_strdup_printf("%.*s… (%" G_GSIZE_FORMAT " bytes not shown)", (int)kept, text, len - kept);
+}
@@ -67,7 +67,7 @@ gboolean
 _pgp_automatic_start(const char* const recipient)
 {
     gboolean result = FALSE;
-    ProfAccount* account = accounts_get_account(session_get_account_name());
+    ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
 
     if (g_list_find_custom(account->pgp_enabled, recipient, (GCompareFunc)g_strcmp0)) {
         result = TRUE;
@@ -81,7 +81,7 @@ gboolean
 _ox_automatic_start(const char* const recipient)
 {
     gboolean result = FALSE;
-    ProfAccount* account = accounts_get_account(session_get_account_name());
+    ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
 
     if (g_list_find_custom(account->ox_enabled, recipient, (GCompareFunc)g_strcmp0)) {
         result = TRUE;
@@ -1378,6 +1378,13 @@ cons_rooms_cache_setting(void)
     } else {
         cons_show("Room list cache (/rooms cache)  : OFF");
     }
+    cons_show("Room list cache TTL             : %d seconds", prefs_get_rooms_cache_ttl());
+}
+
+void
+cons_caps_setting(void)
+{
+    cons_show("Caps queries in flight (/caps)  : %d", prefs_get_caps_requests_max());
 }
 
 void
@@ -1845,6 +1852,20 @@ cons_receipts_setting(void)
         cons_show("Send receipts (/receipts)     : OFF");
 }
 
+void
+cons_csi_setting(void)
+{
+    if (prefs_get_boolean(PREF_CSI))
+        cons_show("Client state indication (/csi) : ON");
+    else
+        cons_show("Client state indication (/csi) : OFF");
+
+    if (prefs_get_boolean(PREF_CSI_FOCUS))
+        cons_show("CSI on terminal focus (/csi)   : ON");
+    else
+        cons_show("CSI on terminal focus (/csi)   : OFF");
+}
+
 void
 cons_show_chat_prefs(void)
 {
@@ -2188,7 +2209,9 @@ cons_show_connection_prefs(void)
     cons_autoping_setting();
     cons_autoconnect_setting();
     cons_rooms_cache_setting();
+    cons_caps_setting();
     cons_strophe_setting();
+    cons_csi_setting();
 
     cons_alert(NULL);
 }
@@ -2885,7 +2908,7 @@ cons_privacy_setting(void)
     }
 
     if (connection_get_status() == JABBER_CONNECTED) {
-        ProfAccount* account = accounts_get_account(session_get_account_name());
+        ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
 
         if (account->client) {
             cons_show("Client name (/account set <account> clientid)              : %s", account->client);
@@ -81,6 +81,7 @@
 static int inp_size;
 static gboolean perform_resize = FALSE;
 static GTimer* ui_idle_time;
+static gboolean terminal_focus = TRUE;
 static WINDOW* main_scr;
 
 #ifdef HAVE_LIBXSS
@@ -118,6 +119,11 @@ ui_init(void)
     inp_size = 0;
     ProfWin* window = wins_get_current();
     win_update_virtual(window);
+
+    if (prefs_get_boolean(PREF_CSI_FOCUS)) {
+        ui_terminal_focus_reporting(TRUE);
+    }
+    ui_terminal_bracketed_paste(TRUE);
 }
 
 void
@@ -180,9 +186,42 @@ ui_reset_idle_time(void)
     g_timer_start(ui_idle_time);
 }
 
+void
+ui_terminal_focus_reporting(gboolean enabled)
+{
+    // ask the terminal to send \e[I and \e[O when it gains and loses focus
+    fprintf(stdout, enabled ? "\e[?1004h" : "\e[?1004l");
+    fflush(stdout);
+    terminal_focus = TRUE;
+}
+
+void
+ui_terminal_bracketed_paste(gboolean enabled)
+{
+    // ask the terminal to wrap pasted text in \e[200~ and \e[201~
+    fprintf(stdout, enabled ? "\e[?2004h" : "\e[?2004l");
+    fflush(stdout);
+}
+
+void
+ui_set_terminal_focus(gboolean focused)
+{
+    terminal_focus = focused;
+}
+
+gboolean
+ui_has_terminal_focus(void)
+{
+    return terminal_focus;
+}
+
 void
 ui_close(void)
 {
+    if (prefs_get_boolean(PREF_CSI_FOCUS)) {
+        ui_terminal_focus_reporting(FALSE);
+    }
+    ui_terminal_bracketed_paste(FALSE);
     g_timer_destroy(ui_idle_time);
     endwin();
     notifier_uninit();
@@ -683,6 +722,10 @@ ui_focus_win(ProfWin* window)
     int i = wins_get_num(window);
     wins_set_current_by_num(i);
 
+    if (window->type == WIN_XML) {
+        xmlwin_focus((ProfXMLWin*)window);
+    }
+
     if (i == 1) {
         title_bar_console();
         rosterwin_roster();
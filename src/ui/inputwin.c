@@ -76,6 +76,7 @@
 #include "xmpp/roster_list.h"
 #include "xmpp/chat_state.h"
 #include "tools/editor.h"
+#include "tools/perf.h"
 
 static WINDOW* inp_win;
 static int pad_start = 0;
@@ -90,6 +91,7 @@ static fd_set fds;
 static int r;
 static char* inp_line = NULL;
 static gboolean get_password = FALSE;
+static gboolean pasting = FALSE;
 
 static void _inp_win_update_virtual(void);
 static int _inp_edited(const wint_t ch);
@@ -139,6 +141,9 @@ static int _inp_rl_down_arrow_handler(int count, int key);
 static int _inp_rl_scroll_handler(int count, int key);
 static int _inp_rl_send_to_editor(int count, int key);
 static int _inp_rl_print_newline_symbol(int count, int key);
+static int _inp_rl_focus_in_handler(int count, int key);
+static int _inp_rl_focus_out_handler(int count, int key);
+static int _inp_rl_paste_handler(int count, int key);
 
 void
 create_input_window(void)
@@ -182,8 +187,11 @@ inp_readline(void)
     FD_SET(fileno(rl_instream), &fds);
     errno = 0;
     pthread_mutex_unlock(&lock);
+    ProfPerfTimer wait_timer = perf_timer_start("loop.input_wait", NULL);
     r = select(FD_SETSIZE, &fds, NULL, NULL, &p_rl_timeout);
+    perf_timer_stop(&wait_timer);
     pthread_mutex_lock(&lock);
+    auto_perf ProfPerfTimer timer = perf_timer_start("loop.input", NULL);
     if (r < 0) {
         if (errno != EINTR) {
             const char* err_msg = strerror(errno);
@@ -564,6 +572,13 @@ _inp_rl_startup_hook(void)
 
     rl_bind_keyseq("\\e\\C-\r", _inp_rl_print_newline_symbol); // alt+enter
 
+    // terminal focus reporting, see ui_terminal_focus_reporting()
+    rl_bind_keyseq("\\e[I", _inp_rl_focus_in_handler);
+    rl_bind_keyseq("\\e[O", _inp_rl_focus_out_handler);
+
+    // bracketed paste, see ui_terminal_bracketed_paste()
+    rl_bind_keyseq("\\e[200~", _inp_rl_paste_handler);
+
     // unbind unwanted mappings
     rl_bind_keyseq("\\e=", NULL);
 
@@ -601,6 +616,11 @@ _inp_rl_getc(FILE* stream)
 {
     int ch = rl_getc(stream);
 
+    // pasted text is inserted at once by _inp_rl_paste_handler()
+    if (pasting) {
+        return ch;
+    }
+
     // 27, 91, 90 = Shift tab
     if (ch == 27) {
         shift_tab = TRUE;
@@ -616,12 +636,7 @@ _inp_rl_getc(FILE* stream)
     shift_tab = FALSE;
 
     if (_inp_edited(ch)) {
-        ProfWin* window = wins_get_current();
-        cmd_ac_reset(window);
-
-        if ((window->type == WIN_CHAT || window->type == WIN_MUC || window->type == WIN_PRIVATE) && window->quotes_ac != NULL) {
-            autocomplete_reset(window->quotes_ac);
-        }
+        cmd_ac_reset();
     }
     return ch;
 }
@@ -991,3 +1006,49 @@ _inp_rl_print_newline_symbol(int count, int key)
     rl_insert_text("\n");
     return 0;
 }
+
+static int
+_inp_rl_focus_in_handler(int count, int key)
+{
+    ui_set_terminal_focus(TRUE);
+    return 0;
+}
+
+static int
+_inp_rl_focus_out_handler(int count, int key)
+{
+    ui_set_terminal_focus(FALSE);
+    return 0;
+}
+
+// Reads everything up to the end of paste sequence and inserts it in one go,
+// so the input line is redrawn once instead of after every pasted character
+static int
+_inp_rl_paste_handler(int count, int key)
+{
+    static const char paste_end[] = "\e[201~";
+    const gsize paste_end_len = strlen(paste_end);
+    GString* pasted = g_string_new(NULL);
+
+    pasting = TRUE;
+    while (TRUE) {
+        int ch = rl_read_key();
+        if (ch < 0) {
+            break;
+        }
+        g_string_append_c(pasted, ch == '\r' ? '\n' : ch);
+        if (pasted->len >= paste_end_len && memcmp(pasted->str + pasted->len - paste_end_len, paste_end, paste_end_len) == 0) {
+            g_string_truncate(pasted, pasted->len - paste_end_len);
+            break;
+        }
+    }
+    pasting = FALSE;
+
+    if (pasted->len > 0) {
+        rl_insert_text(pasted->str);
+        cmd_ac_reset();
+    }
+    g_string_free(pasted, TRUE);
+
+    return 0;
+}
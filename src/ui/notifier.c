@@ -34,6 +34,7 @@
  */
 #include "config.h"
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -50,27 +51,38 @@
 
 #include "log.h"
 #include "config/preferences.h"
+#include "tools/notify_queue.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/muc.h"
 
+// notifications waiting for the worker, bursts beyond this drop the oldest
+#define NOTIFY_QUEUE_MAX 32
+
 static GTimer* remind_timer;
+static NotifyQueue* notify_queue;
+static GThread* notify_thread;
+
+static gpointer _notifier_worker(gpointer data);
+static void _notify(const char* const key, const char* const message, int timeout, const char* const category);
 
 void
 notifier_initialise(void)
 {
     remind_timer = g_timer_new();
+    notify_queue = notify_queue_new(NOTIFY_QUEUE_MAX);
+    notify_thread = g_thread_new("notifier", _notifier_worker, notify_queue);
 }
 
 void
 notifier_uninit(void)
 {
-#ifdef HAVE_LIBNOTIFY
-    if (notify_is_initted()) {
-        notify_uninit();
-    }
-#endif
+    notify_queue_close(notify_queue);
+    g_thread_join(notify_thread);
+    notify_thread = NULL;
+    notify_queue_free(notify_queue);
+    notify_queue = NULL;
     g_timer_destroy(remind_timer);
 }
 
@@ -111,7 +123,8 @@ notify_message(const char* const name, int num, const char* const text)
         g_string_append_printf(message, "\n%s", text);
     }
 
-    notify(message->str, 10000, "incoming message");
+    auto_gchar gchar* key = g_strdup_printf("chat:%s", name);
+    _notify(key, message->str, 10000, "incoming message");
     g_string_free(message, TRUE);
 }
 
@@ -129,7 +142,8 @@ notify_room_message(const char* const nick, const char* const room, int num, con
         g_string_append_printf(message, "\n%s", text);
     }
 
-    notify(message->str, 10000, "incoming message");
+    auto_gchar gchar* key = g_strdup_printf("room:%s", room);
+    _notify(key, message->str, 10000, "incoming message");
 
     g_string_free(message, TRUE);
 }
@@ -197,38 +211,125 @@ notify_remind(void)
 void
 notify(const char* const message, int timeout, const char* const category)
 {
+    _notify(NULL, message, timeout, category);
+}
+
+/*
+ * Hand a notification to the worker. Notifications with the same key are
+ * coalesced: while one is still pending or on screen, the next one updates
+ * it instead of adding another.
+ */
+static void
+_notify(const char* const key, const char* const message, int timeout, const char* const category)
+{
+    if (!notify_queue) {
+        log_debug("Notifier not running, dropping notification: %s", message);
+        return;
+    }
+
+    log_debug("Queueing notification: %s", message);
+    notify_queue_push(notify_queue, key, message, timeout, category);
+}
+
+#if defined(HAVE_LIBNOTIFY) || defined(HAVE_OSXNOTIFY)
+typedef struct notifier_log_t
+{
+    log_level_t level;
+    gchar* msg;
+} NotifierLog;
+
+static gboolean
+_notifier_log_idle(gpointer data)
+{
+    NotifierLog* entry = data;
+    log_msg(entry->level, "prof", entry->msg);
+    g_free(entry->msg);
+    g_free(entry);
+
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Logging from the worker thread, log_msg() is not thread safe so the
+ * message is written from the main loop.
+ */
+static void
+_notifier_log(log_level_t level, const char* const fmt, ...)
+{
+    va_list arg;
+    va_start(arg, fmt);
+    NotifierLog* entry = g_new0(NotifierLog, 1);
+    entry->level = level;
+    entry->msg = g_strdup_vprintf(fmt, arg);
+    va_end(arg);
+
+    g_idle_add(_notifier_log_idle, entry);
+}
+#endif
+
 #ifdef HAVE_LIBNOTIFY
-    log_debug("Attempting notification: %s", message);
-    if (notify_is_initted()) {
-        log_debug("Reinitialising libnotify");
-        notify_uninit();
-    } else {
-        log_debug("Initialising libnotify");
+typedef struct notify_shown_t
+{
+    NotifyNotification* notification;
+    gint64 expires;
+    int count;
+} NotifyShown;
+
+static void
+_notify_shown_free(NotifyShown* shown)
+{
+    if (shown) {
+        g_object_unref(shown->notification);
+        g_free(shown);
     }
-    notify_init("Profanity");
+}
 
-    if (notify_is_initted()) {
-        NotifyNotification* notification;
-        notification = notify_notification_new("Profanity", message, NULL);
-        notify_notification_set_timeout(notification, timeout);
-        notify_notification_set_category(notification, category);
-        notify_notification_set_urgency(notification, NOTIFY_URGENCY_NORMAL);
-
-        GError* error = NULL;
-        gboolean notify_success = notify_notification_show(notification, &error);
-
-        if (!notify_success) {
-            log_error("Error sending desktop notification:");
-            log_error("  -> Message : %s", message);
-            log_error("  -> Error   : %s", error->message);
-            g_error_free(error);
-        } else {
-            log_debug("Notification sent.");
+static void
+_notify_libnotify(GHashTable* shown_by_key, NotifyRequest* request)
+{
+    _notifier_log(PROF_LEVEL_DEBUG, "Attempting notification: %s", request->message);
+
+    gint64 now = g_get_monotonic_time();
+    NotifyShown* shown = request->key ? g_hash_table_lookup(shown_by_key, request->key) : NULL;
+    if (shown && shown->expires > now) {
+        shown->count += request->count;
+    } else {
+        shown = g_new0(NotifyShown, 1);
+        shown->notification = notify_notification_new("Profanity", NULL, NULL);
+        shown->count = request->count;
+        if (request->key) {
+            g_hash_table_replace(shown_by_key, g_strdup(request->key), shown);
         }
+    }
+    shown->expires = now + (gint64)request->timeout * 1000;
+
+    auto_gchar gchar* summary = shown->count > 1 ? g_strdup_printf("Profanity (%d new)", shown->count) : g_strdup("Profanity");
+    notify_notification_update(shown->notification, summary, request->message, NULL);
+    notify_notification_set_timeout(shown->notification, request->timeout);
+    notify_notification_set_category(shown->notification, request->category);
+    notify_notification_set_urgency(shown->notification, NOTIFY_URGENCY_NORMAL);
+
+    GError* error = NULL;
+    gboolean notify_success = notify_notification_show(shown->notification, &error);
+
+    if (!notify_success) {
+        _notifier_log(PROF_LEVEL_ERROR, "Error sending desktop notification:");
+        _notifier_log(PROF_LEVEL_ERROR, "  -> Message : %s", request->message);
+        _notifier_log(PROF_LEVEL_ERROR, "  -> Error   : %s", error->message);
+        g_error_free(error);
     } else {
-        log_error("Libnotify not initialised.");
+        _notifier_log(PROF_LEVEL_DEBUG, "Notification sent.");
     }
+
+    if (!request->key) {
+        _notify_shown_free(shown);
+    }
+}
 #endif
+
+static void
+_notify_platform(const char* const message, int timeout, const char* const category)
+{
 #ifdef PLATFORM_CYGWIN
     NOTIFYICONDATA nid;
     memset(&nid, 0, sizeof(nid));
@@ -289,9 +390,44 @@ notify(const char* const message, int timeout, const char* const category)
 
     int res = system(notify_command->str);
     if (res == -1) {
-        log_error("Could not send desktop notification.");
+        _notifier_log(PROF_LEVEL_ERROR, "Could not send desktop notification.");
     }
 
     g_string_free(notify_command, TRUE);
 #endif
 }
+
+// owns libnotify, so D-Bus round trips never block the main thread
+static gpointer
+_notifier_worker(gpointer data)
+{
+    NotifyQueue* queue = data;
+
+#ifdef HAVE_LIBNOTIFY
+    _notifier_log(PROF_LEVEL_DEBUG, "Initialising libnotify");
+    notify_init("Profanity");
+    GHashTable* shown_by_key = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_notify_shown_free);
+#endif
+
+    NotifyRequest* request;
+    while ((request = notify_queue_pop(queue))) {
+#ifdef HAVE_LIBNOTIFY
+        if (notify_is_initted()) {
+            _notify_libnotify(shown_by_key, request);
+        } else {
+            _notifier_log(PROF_LEVEL_ERROR, "Libnotify not initialised.");
+        }
+#endif
+        _notify_platform(request->message, request->timeout, request->category);
+        notify_request_free(request);
+    }
+
+#ifdef HAVE_LIBNOTIFY
+    g_hash_table_destroy(shown_by_key);
+    if (notify_is_initted()) {
+        notify_uninit();
+    }
+#endif
+
+    return NULL;
+}
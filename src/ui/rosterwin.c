@@ -53,6 +53,28 @@ typedef enum {
     ROSTER_CONTACT_UNREAD
 } roster_contact_theme_t;
 
+// A contact or room line as drawn last time, kept as the prints that drew it
+// so it still wraps to the current panel width. It is replayed on repaint
+// while nothing it was rendered from has changed.
+typedef struct roster_row_op_t
+{
+    int attrs;
+    gboolean newline;
+    gboolean wrap;
+    int indent;
+    char* text;
+} RosterRowOp;
+
+typedef struct roster_row_t
+{
+    guint version; // p_contact_version() for contacts
+    int state;     // theme of the line
+    int unread;
+    char* title; // rooms only
+    guint painted;
+    GPtrArray* ops;
+} RosterRow;
+
 static void _rosterwin_contacts_all(ProfLayoutSplit* layout);
 static void _rosterwin_contacts_by_presence(ProfLayoutSplit* layout, const char* const presence, char* title);
 static void _rosterwin_contacts_by_group(ProfLayoutSplit* layout, char* group);
@@ -61,6 +83,8 @@ static void _rosterwin_contacts_header(ProfLayoutSplit* layout, const char* titl
 static void _rosterwin_unsubscribed_header(ProfLayoutSplit* layout, GList* wins);
 
 static void _rosterwin_contact(ProfLayoutSplit* layout, PContact contact);
+static void _rosterwin_contact_render(ProfLayoutSplit* layout, PContact contact, roster_contact_theme_t theme_type,
+                                      int unread);
 static void _rosterwin_unsubscribed_item(ProfLayoutSplit* layout, ProfChatWin* chatwin);
 static void _rosterwin_presence(ProfLayoutSplit* layout, const char* presence, const char* status,
                                 int current_indent);
@@ -82,6 +106,19 @@ static theme_item_t _get_roster_theme(roster_contact_theme_t theme_type, const c
 static int _compare_rooms_name(ProfMucWin* a, ProfMucWin* b);
 static int _compare_rooms_unread(ProfMucWin* a, ProfMucWin* b);
 
+static void _rosterwin_rows_begin(void);
+static void _rosterwin_rows_end(void);
+static RosterRow* _rosterwin_row_record(GHashTable* rows, const char* const key);
+static void _rosterwin_row_draw(ProfLayoutSplit* layout, RosterRow* row);
+static void _rosterwin_print(ProfLayoutSplit* layout, int attrs, gboolean newline, const char* const text,
+                             gboolean wrap, int indent);
+
+static GHashTable* contact_rows = NULL;
+static GHashTable* room_rows = NULL;
+static RosterRow* recording = NULL;
+static gchar* rows_prefs = NULL;
+static guint rows_painted = 0;
+
 void
 rosterwin_roster(void)
 {
@@ -103,6 +140,7 @@ rosterwin_roster(void)
     }
 
     werase(layout->subwin);
+    _rosterwin_rows_begin();
 
     auto_gchar gchar* roomspos = prefs_get_string(PREF_ROSTER_ROOMS_POS);
     if (prefs_get_boolean(PREF_ROSTER_ROOMS) && (g_strcmp0(roomspos, "first") == 0)) {
@@ -176,6 +214,8 @@ rosterwin_roster(void)
         g_list_free(privchats);
         g_list_free(orphaned_privchats);
     }
+
+    _rosterwin_rows_end();
 }
 
 static void
@@ -332,9 +372,6 @@ _rosterwin_unsubscribed_item(ProfLayoutSplit* layout, ProfChatWin* chatwin)
 static void
 _rosterwin_contact(ProfLayoutSplit* layout, PContact contact)
 {
-    const char* name = p_contact_name_or_jid(contact);
-    const char* presence = p_contact_presence(contact);
-    const char* status = p_contact_status(contact);
     const char* barejid = p_contact_barejid(contact);
     int unread = 0;
 
@@ -349,13 +386,33 @@ _rosterwin_contact(ProfLayoutSplit* layout, PContact contact)
         }
     }
 
+    RosterRow* row = g_hash_table_lookup(contact_rows, barejid);
+    if (row && row->version == p_contact_version(contact) && row->state == theme_type && row->unread == unread) {
+        _rosterwin_row_draw(layout, row);
+        return;
+    }
+
+    row = _rosterwin_row_record(contact_rows, barejid);
+    row->version = p_contact_version(contact);
+    row->state = theme_type;
+    row->unread = unread;
+    _rosterwin_contact_render(layout, contact, theme_type, unread);
+    recording = NULL;
+}
+
+static void
+_rosterwin_contact_render(ProfLayoutSplit* layout, PContact contact, roster_contact_theme_t theme_type, int unread)
+{
+    const char* name = p_contact_name_or_jid(contact);
+    const char* presence = p_contact_presence(contact);
+    const char* status = p_contact_status(contact);
+
     theme_item_t presence_colour = _get_roster_theme(theme_type, presence);
     int colour = 0;
     if (prefs_get_boolean(PREF_ROSTER_COLOR_NICK)) {
         colour = theme_hash_attrs(name);
-        wattron(layout->subwin, colour);
     } else {
-        wattron(layout->subwin, theme_attrs(presence_colour));
+        colour = theme_attrs(presence_colour);
     }
 
     GString* msg = g_string_new(" ");
@@ -388,28 +445,16 @@ _rosterwin_contact(ProfLayoutSplit* layout, PContact contact)
         }
     }
 
-    win_sub_newline_lazy(layout->subwin);
     gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
-    win_sub_print(layout->subwin, msg->str, FALSE, wrap, current_indent);
+    _rosterwin_print(layout, colour, TRUE, msg->str, wrap, current_indent);
     g_string_free(msg, TRUE);
 
-    if (prefs_get_boolean(PREF_ROSTER_COLOR_NICK)) {
-        wattroff(layout->subwin, colour);
-    } else {
-        wattroff(layout->subwin, theme_attrs(presence_colour));
-    }
-
     if (prefs_get_boolean(PREF_ROSTER_RESOURCE)) {
         _rosterwin_resources(layout, contact, current_indent, theme_type, unread);
     } else if (prefs_get_boolean(PREF_ROSTER_PRESENCE) || prefs_get_boolean(PREF_ROSTER_STATUS)) {
         if (unread > 0) {
-            GString* unreadmsg = g_string_new("");
-            g_string_append_printf(unreadmsg, " (%d)", unread);
-
-            wattron(layout->subwin, theme_attrs(presence_colour));
-            win_sub_print(layout->subwin, unreadmsg->str, FALSE, wrap, current_indent);
-            g_string_free(unreadmsg, TRUE);
-            wattroff(layout->subwin, theme_attrs(presence_colour));
+            auto_gchar gchar* unreadmsg = g_strdup_printf(" (%d)", unread);
+            _rosterwin_print(layout, theme_attrs(presence_colour), FALSE, unreadmsg, wrap, current_indent);
         }
 
         _rosterwin_presence(layout, presence, status, current_indent);
@@ -435,19 +480,16 @@ _rosterwin_presence(ProfLayoutSplit* layout, const char* presence, const char* s
     }
 
     gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
-    theme_item_t colour = _get_roster_theme(ROSTER_CONTACT, presence);
+    int colour = theme_attrs(_get_roster_theme(ROSTER_CONTACT, presence));
 
     // show only status when grouped by presence
     if (by_presence) {
         if (status && prefs_get_boolean(PREF_ROSTER_STATUS)) {
-
-            wattron(layout->subwin, theme_attrs(colour));
             if (presence_indent == -1) {
                 GString* msg = g_string_new("");
                 g_string_append_printf(msg, ": \"%s\"", status);
-                win_sub_print(layout->subwin, msg->str, FALSE, wrap, current_indent);
+                _rosterwin_print(layout, colour, FALSE, msg->str, wrap, current_indent);
                 g_string_free(msg, TRUE);
-                wattroff(layout->subwin, theme_attrs(colour));
             } else {
                 GString* msg = g_string_new(" ");
                 while (current_indent > 0) {
@@ -455,16 +497,13 @@ _rosterwin_presence(ProfLayoutSplit* layout, const char* presence, const char* s
                     current_indent--;
                 }
                 g_string_append_printf(msg, "\"%s\"", status);
-                win_sub_newline_lazy(layout->subwin);
-                win_sub_print(layout->subwin, msg->str, FALSE, wrap, current_indent);
+                _rosterwin_print(layout, colour, TRUE, msg->str, wrap, current_indent);
                 g_string_free(msg, TRUE);
-                wattroff(layout->subwin, theme_attrs(colour));
             }
         }
 
         // show both presence and status when not grouped by presence
     } else if (prefs_get_boolean(PREF_ROSTER_PRESENCE) || (status && prefs_get_boolean(PREF_ROSTER_STATUS))) {
-        wattron(layout->subwin, theme_attrs(colour));
         if (presence_indent == -1) {
             GString* msg = g_string_new("");
             if (prefs_get_boolean(PREF_ROSTER_PRESENCE)) {
@@ -475,9 +514,8 @@ _rosterwin_presence(ProfLayoutSplit* layout, const char* presence, const char* s
             } else if (status && prefs_get_boolean(PREF_ROSTER_STATUS)) {
                 g_string_append_printf(msg, ": \"%s\"", status);
             }
-            win_sub_print(layout->subwin, msg->str, FALSE, wrap, current_indent);
+            _rosterwin_print(layout, colour, FALSE, msg->str, wrap, current_indent);
             g_string_free(msg, TRUE);
-            wattroff(layout->subwin, theme_attrs(colour));
         } else {
             GString* msg = g_string_new(" ");
             while (current_indent > 0) {
@@ -492,10 +530,8 @@ _rosterwin_presence(ProfLayoutSplit* layout, const char* presence, const char* s
             } else if (status && prefs_get_boolean(PREF_ROSTER_STATUS)) {
                 g_string_append_printf(msg, "\"%s\"", status);
             }
-            win_sub_newline_lazy(layout->subwin);
-            win_sub_print(layout->subwin, msg->str, FALSE, wrap, current_indent);
+            _rosterwin_print(layout, colour, TRUE, msg->str, wrap, current_indent);
             g_string_free(msg, TRUE);
-            wattroff(layout->subwin, theme_attrs(colour));
         }
     }
 }
@@ -505,6 +541,8 @@ _rosterwin_resources(ProfLayoutSplit* layout, PContact contact, int current_inde
                      int unread)
 {
     gboolean join = prefs_get_boolean(PREF_ROSTER_RESOURCE_JOIN);
+    gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
+    auto_gchar gchar* unreadpos = prefs_get_string(PREF_ROSTER_UNREAD);
 
     GList* resources = p_contact_get_available_resources(contact);
     if (resources) {
@@ -515,7 +553,6 @@ _rosterwin_resources(ProfLayoutSplit* layout, PContact contact, int current_inde
             const char* resource_presence = string_from_resource_presence(resource->presence);
             theme_item_t resource_presence_colour = _get_roster_theme(theme_type, resource_presence);
 
-            wattron(layout->subwin, theme_attrs(resource_presence_colour));
             GString* msg = g_string_new("");
             auto_gchar gchar* ch = prefs_get_roster_resource_char();
             if (ch) {
@@ -528,15 +565,12 @@ _rosterwin_resources(ProfLayoutSplit* layout, PContact contact, int current_inde
                 g_string_append_printf(msg, " %d", resource->priority);
             }
 
-            auto_gchar gchar* unreadpos = prefs_get_string(PREF_ROSTER_UNREAD);
             if ((g_strcmp0(unreadpos, "after") == 0) && unread > 0) {
                 g_string_append_printf(msg, " (%d)", unread);
             }
 
-            gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
-            win_sub_print(layout->subwin, msg->str, FALSE, wrap, 0);
+            _rosterwin_print(layout, theme_attrs(resource_presence_colour), FALSE, msg->str, wrap, 0);
             g_string_free(msg, TRUE);
-            wattroff(layout->subwin, theme_attrs(resource_presence_colour));
 
             if (prefs_get_boolean(PREF_ROSTER_PRESENCE) || prefs_get_boolean(PREF_ROSTER_STATUS)) {
                 _rosterwin_presence(layout, resource_presence, resource->status, current_indent);
@@ -544,20 +578,12 @@ _rosterwin_resources(ProfLayoutSplit* layout, PContact contact, int current_inde
 
             // resource(s) on new lines
         } else {
-            gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
-
-            auto_gchar gchar* unreadpos = prefs_get_string(PREF_ROSTER_UNREAD);
             if ((g_strcmp0(unreadpos, "after") == 0) && unread > 0) {
-                GString* unreadmsg = g_string_new("");
-                g_string_append_printf(unreadmsg, " (%d)", unread);
-
+                auto_gchar gchar* unreadmsg = g_strdup_printf(" (%d)", unread);
                 const char* presence = p_contact_presence(contact);
                 theme_item_t presence_colour = _get_roster_theme(theme_type, presence);
 
-                wattron(layout->subwin, theme_attrs(presence_colour));
-                win_sub_print(layout->subwin, unreadmsg->str, FALSE, wrap, current_indent);
-                g_string_free(unreadmsg, TRUE);
-                wattroff(layout->subwin, theme_attrs(presence_colour));
+                _rosterwin_print(layout, theme_attrs(presence_colour), FALSE, unreadmsg, wrap, current_indent);
             }
 
             int resource_indent = prefs_get_roster_resource_indent();
@@ -565,20 +591,19 @@ _rosterwin_resources(ProfLayoutSplit* layout, PContact contact, int current_inde
                 current_indent += resource_indent;
             }
 
+            auto_char char* ch = prefs_get_roster_resource_char();
             GList* curr_resource = resources;
             while (curr_resource) {
                 Resource* resource = curr_resource->data;
                 const char* resource_presence = string_from_resource_presence(resource->presence);
                 theme_item_t resource_presence_colour = _get_roster_theme(ROSTER_CONTACT, resource_presence);
 
-                wattron(layout->subwin, theme_attrs(resource_presence_colour));
                 GString* msg = g_string_new(" ");
                 int this_indent = current_indent;
                 while (this_indent > 0) {
                     g_string_append(msg, " ");
                     this_indent--;
                 }
-                auto_char char* ch = prefs_get_roster_resource_char();
                 if (ch) {
                     g_string_append_printf(msg, "%s", ch);
                 }
@@ -586,10 +611,8 @@ _rosterwin_resources(ProfLayoutSplit* layout, PContact contact, int current_inde
                 if (prefs_get_boolean(PREF_ROSTER_PRIORITY)) {
                     g_string_append_printf(msg, " %d", resource->priority);
                 }
-                win_sub_newline_lazy(layout->subwin);
-                win_sub_print(layout->subwin, msg->str, FALSE, wrap, current_indent);
+                _rosterwin_print(layout, theme_attrs(resource_presence_colour), TRUE, msg->str, wrap, current_indent);
                 g_string_free(msg, TRUE);
-                wattroff(layout->subwin, theme_attrs(resource_presence_colour));
 
                 if (prefs_get_boolean(PREF_ROSTER_PRESENCE) || prefs_get_boolean(PREF_ROSTER_STATUS)) {
                     _rosterwin_presence(layout, resource_presence, resource->status, current_indent);
@@ -602,33 +625,19 @@ _rosterwin_resources(ProfLayoutSplit* layout, PContact contact, int current_inde
         const char* presence = p_contact_presence(contact);
         const char* status = p_contact_status(contact);
         theme_item_t presence_colour = _get_roster_theme(theme_type, presence);
-        gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
 
-        auto_gchar gchar* unreadpos = prefs_get_string(PREF_ROSTER_UNREAD);
         if ((g_strcmp0(unreadpos, "after") == 0) && unread > 0) {
-            GString* unreadmsg = g_string_new("");
-            g_string_append_printf(unreadmsg, " (%d)", unread);
-
-            wattron(layout->subwin, theme_attrs(presence_colour));
-            win_sub_print(layout->subwin, unreadmsg->str, FALSE, wrap, current_indent);
-            g_string_free(unreadmsg, TRUE);
-            wattroff(layout->subwin, theme_attrs(presence_colour));
+            auto_gchar gchar* unreadmsg = g_strdup_printf(" (%d)", unread);
+            _rosterwin_print(layout, theme_attrs(presence_colour), FALSE, unreadmsg, wrap, current_indent);
         }
         _rosterwin_presence(layout, presence, status, current_indent);
     } else {
-        gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
-
-        auto_gchar gchar* unreadpos = prefs_get_string(PREF_ROSTER_UNREAD);
         if ((g_strcmp0(unreadpos, "after") == 0) && unread > 0) {
-            GString* unreadmsg = g_string_new("");
-            g_string_append_printf(unreadmsg, " (%d)", unread);
+            auto_gchar gchar* unreadmsg = g_strdup_printf(" (%d)", unread);
             const char* presence = p_contact_presence(contact);
             theme_item_t presence_colour = _get_roster_theme(theme_type, presence);
 
-            wattron(layout->subwin, theme_attrs(presence_colour));
-            win_sub_print(layout->subwin, unreadmsg->str, FALSE, wrap, current_indent);
-            g_string_free(unreadmsg, TRUE);
-            wattroff(layout->subwin, theme_attrs(presence_colour));
+            _rosterwin_print(layout, theme_attrs(presence_colour), FALSE, unreadmsg, wrap, current_indent);
         }
     }
 
@@ -714,61 +723,62 @@ _rosterwin_rooms_by_service(ProfLayoutSplit* layout)
 static void
 _rosterwin_room(ProfLayoutSplit* layout, ProfMucWin* mucwin)
 {
-    GString* msg = g_string_new(" ");
-
+    theme_item_t room_colour = THEME_ROSTER_ROOM;
     if (mucwin->unread_mentions) {
-        wattron(layout->subwin, theme_attrs(THEME_ROSTER_ROOM_MENTION));
+        room_colour = THEME_ROSTER_ROOM_MENTION;
     } else if (mucwin->unread_triggers) {
-        wattron(layout->subwin, theme_attrs(THEME_ROSTER_ROOM_TRIGGER));
+        room_colour = THEME_ROSTER_ROOM_TRIGGER;
     } else if (mucwin->unread > 0) {
-        wattron(layout->subwin, theme_attrs(THEME_ROSTER_ROOM_UNREAD));
-    } else {
-        wattron(layout->subwin, theme_attrs(THEME_ROSTER_ROOM));
+        room_colour = THEME_ROSTER_ROOM_UNREAD;
     }
 
-    int indent = prefs_get_roster_contact_indent();
-    int current_indent = 0;
-    if (indent > 0) {
-        current_indent += indent;
-        while (indent > 0) {
-            g_string_append(msg, " ");
-            indent--;
-        }
-    }
-    auto_gchar gchar* ch = prefs_get_roster_room_char();
-    if (ch) {
-        g_string_append_printf(msg, "%s", ch);
-    }
+    auto_gchar gchar* mucwin_title = mucwin_generate_title(mucwin->roomjid, PREF_ROSTER_ROOMS_TITLE);
 
-    auto_gchar gchar* unreadpos = prefs_get_string(PREF_ROSTER_ROOMS_UNREAD);
-    if ((g_strcmp0(unreadpos, "before") == 0) && mucwin->unread > 0) {
-        g_string_append_printf(msg, "(%d) ", mucwin->unread);
-    }
+    RosterRow* row = g_hash_table_lookup(room_rows, mucwin->roomjid);
+    if (row && row->state == room_colour && row->unread == mucwin->unread && g_strcmp0(row->title, mucwin_title) == 0) {
+        _rosterwin_row_draw(layout, row);
+    } else {
+        row = _rosterwin_row_record(room_rows, mucwin->roomjid);
+        row->state = room_colour;
+        row->unread = mucwin->unread;
+        row->title = strdup(mucwin_title);
+
+        GString* msg = g_string_new(" ");
+        int indent = prefs_get_roster_contact_indent();
+        int current_indent = 0;
+        if (indent > 0) {
+            current_indent += indent;
+            while (indent > 0) {
+                g_string_append(msg, " ");
+                indent--;
+            }
+        }
+        auto_gchar gchar* ch = prefs_get_roster_room_char();
+        if (ch) {
+            g_string_append_printf(msg, "%s", ch);
+        }
 
-    auto_gchar gchar* mucwin_title = mucwin_generate_title(mucwin->roomjid, PREF_ROSTER_ROOMS_TITLE);
-    g_string_append(msg, mucwin_title);
+        auto_gchar gchar* unreadpos = prefs_get_string(PREF_ROSTER_ROOMS_UNREAD);
+        if ((g_strcmp0(unreadpos, "before") == 0) && mucwin->unread > 0) {
+            g_string_append_printf(msg, "(%d) ", mucwin->unread);
+        }
 
-    if ((g_strcmp0(unreadpos, "after") == 0) && mucwin->unread > 0) {
-        g_string_append_printf(msg, " (%d)", mucwin->unread);
-    }
+        g_string_append(msg, mucwin_title);
 
-    win_sub_newline_lazy(layout->subwin);
-    gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
-    win_sub_print(layout->subwin, msg->str, FALSE, wrap, current_indent);
-    g_string_free(msg, TRUE);
+        if ((g_strcmp0(unreadpos, "after") == 0) && mucwin->unread > 0) {
+            g_string_append_printf(msg, " (%d)", mucwin->unread);
+        }
 
-    if (mucwin->unread_mentions) {
-        wattroff(layout->subwin, theme_attrs(THEME_ROSTER_ROOM_MENTION));
-    } else if (mucwin->unread_triggers) {
-        wattroff(layout->subwin, theme_attrs(THEME_ROSTER_ROOM_TRIGGER));
-    } else if (mucwin->unread > 0) {
-        wattroff(layout->subwin, theme_attrs(THEME_ROSTER_ROOM_UNREAD));
-    } else {
-        wattroff(layout->subwin, theme_attrs(THEME_ROSTER_ROOM));
+        gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
+        _rosterwin_print(layout, theme_attrs(room_colour), TRUE, msg->str, wrap, current_indent);
+        g_string_free(msg, TRUE);
+        recording = NULL;
     }
 
+    // private chats in the room follow occupant presence, not cached
     auto_gchar gchar* privpref = prefs_get_string(PREF_ROSTER_PRIVATE);
     if (g_strcmp0(privpref, "room") == 0) {
+        gboolean wrap = prefs_get_boolean(PREF_ROSTER_WRAP);
         GList* privs = wins_get_private_chats(mucwin->roomjid);
         GList* curr = privs;
         while (curr) {
@@ -776,8 +786,8 @@ _rosterwin_room(ProfLayoutSplit* layout, ProfMucWin* mucwin)
             win_sub_newline_lazy(layout->subwin);
 
             GString* privmsg = g_string_new(" ");
-            indent = prefs_get_roster_contact_indent();
-            current_indent = 0;
+            int indent = prefs_get_roster_contact_indent();
+            int current_indent = 0;
             if (indent > 0) {
                 current_indent += indent;
                 while (indent > 0) {
@@ -1242,3 +1252,140 @@ _filter_contacts_with_presence(GSList* contacts, const char* const presence)
 
     return filtered_contacts;
 }
+
+static void
+_rosterwin_row_op_free(RosterRowOp* op)
+{
+    if (op) {
+        free(op->text);
+        free(op);
+    }
+}
+
+static void
+_rosterwin_row_free(RosterRow* row)
+{
+    if (row) {
+        free(row->title);
+        g_ptr_array_free(row->ops, TRUE);
+        free(row);
+    }
+}
+
+// Everything a row's look depends on besides its contact or room, a
+// change drops all cached rows
+static gchar*
+_rosterwin_rows_prefs(void)
+{
+    auto_gchar gchar* unread = prefs_get_string(PREF_ROSTER_UNREAD);
+    auto_gchar gchar* by = prefs_get_string(PREF_ROSTER_BY);
+    auto_gchar gchar* rooms_unread = prefs_get_string(PREF_ROSTER_ROOMS_UNREAD);
+    auto_gchar gchar* color_nick = prefs_get_string(PREF_COLOR_NICK);
+    auto_gchar gchar* contact_ch = prefs_get_roster_contact_char();
+    auto_gchar gchar* resource_ch = prefs_get_roster_resource_char();
+    auto_gchar gchar* room_ch = prefs_get_roster_room_char();
+
+    return g_strdup_printf("%u|%d%d%d%d%d%d%d|%s|%s|%s|%s|%d|%d|%d|%s|%s|%s",
+                           theme_get_generation(),
+                           prefs_get_boolean(PREF_ROSTER_COLOR_NICK),
+                           prefs_get_boolean(PREF_ROSTER_RESOURCE),
+                           prefs_get_boolean(PREF_ROSTER_RESOURCE_JOIN),
+                           prefs_get_boolean(PREF_ROSTER_PRESENCE),
+                           prefs_get_boolean(PREF_ROSTER_STATUS),
+                           prefs_get_boolean(PREF_ROSTER_PRIORITY),
+                           prefs_get_boolean(PREF_ROSTER_WRAP),
+                           unread, by, rooms_unread, color_nick,
+                           prefs_get_roster_contact_indent(),
+                           prefs_get_roster_presence_indent(),
+                           prefs_get_roster_resource_indent(),
+                           contact_ch ? contact_ch : "",
+                           resource_ch ? resource_ch : "",
+                           room_ch ? room_ch : "");
+}
+
+static void
+_rosterwin_rows_begin(void)
+{
+    if (!contact_rows) {
+        contact_rows = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_rosterwin_row_free);
+        room_rows = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_rosterwin_row_free);
+    }
+
+    gchar* prefs = _rosterwin_rows_prefs();
+    if (g_strcmp0(prefs, rows_prefs) != 0) {
+        g_hash_table_remove_all(contact_rows);
+        g_hash_table_remove_all(room_rows);
+        g_free(rows_prefs);
+        rows_prefs = prefs;
+    } else {
+        g_free(prefs);
+    }
+
+    rows_painted++;
+}
+
+static gboolean
+_rosterwin_row_unused(gpointer key, RosterRow* row, gpointer userdata)
+{
+    return row->painted != rows_painted;
+}
+
+// drop rows of contacts and rooms that are gone or filtered out
+static void
+_rosterwin_rows_end(void)
+{
+    g_hash_table_foreach_remove(contact_rows, (GHRFunc)_rosterwin_row_unused, NULL);
+    g_hash_table_foreach_remove(room_rows, (GHRFunc)_rosterwin_row_unused, NULL);
+}
+
+// Start a fresh row for key, the following _rosterwin_print() calls are
+// recorded into it until recording is reset
+static RosterRow*
+_rosterwin_row_record(GHashTable* rows, const char* const key)
+{
+    RosterRow* row = calloc(1, sizeof(RosterRow));
+    row->ops = g_ptr_array_new_with_free_func((GDestroyNotify)_rosterwin_row_op_free);
+    row->painted = rows_painted;
+    g_hash_table_replace(rows, strdup(key), row);
+
+    recording = row;
+    return row;
+}
+
+static void
+_rosterwin_draw(ProfLayoutSplit* layout, int attrs, gboolean newline, char* text, gboolean wrap, int indent)
+{
+    wattron(layout->subwin, attrs);
+    if (newline) {
+        win_sub_newline_lazy(layout->subwin);
+    }
+    win_sub_print(layout->subwin, text, FALSE, wrap, indent);
+    wattroff(layout->subwin, attrs);
+}
+
+static void
+_rosterwin_row_draw(ProfLayoutSplit* layout, RosterRow* row)
+{
+    row->painted = rows_painted;
+    for (guint i = 0; i < row->ops->len; i++) {
+        RosterRowOp* op = g_ptr_array_index(row->ops, i);
+        _rosterwin_draw(layout, op->attrs, op->newline, op->text, op->wrap, op->indent);
+    }
+}
+
+static void
+_rosterwin_print(ProfLayoutSplit* layout, int attrs, gboolean newline, const char* const text, gboolean wrap,
+                 int indent)
+{
+    _rosterwin_draw(layout, attrs, newline, (char*)text, wrap, indent);
+
+    if (recording) {
+        RosterRowOp* op = malloc(sizeof(RosterRowOp));
+        op->attrs = attrs;
+        op->newline = newline;
+        op->wrap = wrap;
+        op->indent = indent;
+        op->text = strdup(text);
+        g_ptr_array_add(recording->ops, op);
+    }
+}
@@ -70,6 +70,7 @@ typedef struct _status_bar_t
     gchar* time;
     char* prompt;
     char* fulljid;
+    gchar* progress;
     GHashTable* tabs;
     int current_tab;
 } StatusBar;
@@ -81,6 +82,7 @@ static WINDOW* statusbar_win;
 void _get_range_bounds(int* start, int* end, gboolean is_static);
 static int _status_bar_draw_time(int pos);
 static int _status_bar_draw_maintext(int pos);
+static int _status_bar_draw_progress(int pos);
 static int _status_bar_draw_bracket(gboolean current, int pos, const char* ch);
 static int _status_bar_draw_extended_tabs(int pos, gboolean prefix, int start, int end, gboolean is_static);
 static int _status_bar_draw_tab(StatusBarTab* tab, int pos, int num, gboolean include_brackets);
@@ -101,6 +103,7 @@ status_bar_init(void)
     statusbar->time = NULL;
     statusbar->prompt = NULL;
     statusbar->fulljid = NULL;
+    statusbar->progress = NULL;
     statusbar->tabs = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_destroy_tab);
     StatusBarTab* console = calloc(1, sizeof(StatusBarTab));
     console->window_type = WIN_CONSOLE;
@@ -130,6 +133,7 @@ status_bar_close(void)
         if (statusbar->fulljid) {
             free(statusbar->fulljid);
         }
+        g_free(statusbar->progress);
         if (statusbar->tabs) {
             g_hash_table_destroy(statusbar->tabs);
         }
@@ -257,6 +261,30 @@ status_bar_clear_prompt(void)
     status_bar_draw();
 }
 
+void
+status_bar_set_progress(const char* const progress)
+{
+    if (g_strcmp0(statusbar->progress, progress) == 0) {
+        return;
+    }
+    g_free(statusbar->progress);
+    statusbar->progress = g_strdup(progress);
+
+    status_bar_draw();
+}
+
+void
+status_bar_clear_progress(void)
+{
+    if (!statusbar->progress) {
+        return;
+    }
+    g_free(statusbar->progress);
+    statusbar->progress = NULL;
+
+    status_bar_draw();
+}
+
 void
 status_bar_set_fulljid(const char* const fulljid)
 {
@@ -291,6 +319,7 @@ status_bar_draw(void)
 
     pos = _status_bar_draw_time(pos);
     pos = _status_bar_draw_maintext(pos);
+    pos = _status_bar_draw_progress(pos);
     if (max_tabs != 0)
         pos = _status_bar_draw_tabs(pos);
 
@@ -581,6 +610,23 @@ _status_bar_draw_maintext(int pos)
     return pos;
 }
 
+// background work such as archive sync, hidden while a prompt is shown
+static int
+_status_bar_draw_progress(int pos)
+{
+    if (!statusbar->progress || statusbar->prompt) {
+        return pos;
+    }
+
+    pos++;
+    pos = _status_bar_draw_bracket(FALSE, pos, "[");
+    mvwprintw(statusbar_win, 0, pos, "%s", statusbar->progress);
+    pos += utf8_display_len(statusbar->progress);
+    pos = _status_bar_draw_bracket(FALSE, pos, "]");
+
+    return pos;
+}
+
 static void
 _destroy_tab(StatusBarTab* tab)
 {
@@ -70,6 +70,10 @@ void ui_sigwinch_handler(int sig);
 void ui_handle_otr_error(const char* const barejid, const char* const message);
 unsigned long ui_get_idle_time(void);
 void ui_reset_idle_time(void);
+void ui_terminal_focus_reporting(gboolean enabled);
+void ui_terminal_bracketed_paste(gboolean enabled);
+void ui_set_terminal_focus(gboolean focused);
+gboolean ui_has_terminal_focus(void);
 void ui_print_system_msg_from_recipient(const char* const barejid, const char* message);
 void ui_close_connected_win(int index);
 int ui_close_all_wins(void);
@@ -233,6 +237,12 @@ gchar* confwin_get_string(ProfConfWin* confwin);
 // xml console
 void xmlwin_show(ProfXMLWin* xmlwin, const char* const msg);
 gchar* xmlwin_get_string(ProfXMLWin* xmlwin);
+void xmlwin_redraw(ProfXMLWin* xmlwin);
+void xmlwin_focus(ProfXMLWin* xmlwin);
+void xmlwin_clear(ProfXMLWin* xmlwin);
+void xmlwin_free(ProfXMLWin* xmlwin);
+void xmlwin_set_filter(ProfXMLWin* xmlwin, const char* const type, const char* const jid);
+void xmlwin_set_pretty(ProfXMLWin* xmlwin, gboolean pretty);
 
 // vCard window
 void vcardwin_show_vcard_config(ProfVcardWin* vcardwin);
@@ -326,12 +336,14 @@ void cons_gone_setting(void);
 void cons_history_setting(void);
 void cons_carbons_setting(void);
 void cons_receipts_setting(void);
+void cons_csi_setting(void);
 void cons_log_setting(void);
 void cons_logging_setting(void);
 void cons_autoaway_setting(void);
 void cons_reconnect_setting(void);
 void cons_autoping_setting(void);
 void cons_autoconnect_setting(void);
+void cons_caps_setting(void);
 void cons_room_cache_setting(void);
 void cons_inpblock_setting(void);
 void cons_statusbar_setting(void);
@@ -365,6 +377,8 @@ void status_bar_inactive(const int win);
 void status_bar_active(const int win, win_type_t wintype, char* identifier);
 void status_bar_new(const int win, win_type_t wintype, char* identifier);
 void status_bar_set_all_inactive(void);
+void status_bar_set_progress(const char* const progress);
+void status_bar_clear_progress(void);
 
 // roster window
 void rosterwin_roster(void);
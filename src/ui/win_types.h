@@ -52,6 +52,7 @@
 #include "tools/autocomplete.h"
 #include "ui/buffer.h"
 #include "xmpp/chat_state.h"
+#include "xmpp/jid.h"
 #include "xmpp/vcard.h"
 
 #define LAYOUT_SPLIT_MEMCHECK   12345671
@@ -170,6 +171,7 @@ typedef struct prof_chat_win_t
 {
     ProfWin window;
     char* barejid;
+    Jid* jid; // shared Jid of barejid, see wins_get_chat()
     int unread;
     ChatState* state;
     gboolean is_otr;
@@ -238,6 +240,12 @@ typedef struct prof_private_win_t
 typedef struct prof_xml_win_t
 {
     ProfWin window;
+    GQueue* stanzas;     // raw stanzas, oldest first, see xmlwin.c
+    gsize stanzas_size;  // bytes of stanza text held
+    gboolean stale;      // stanzas arrived while the window was not shown
+    char* filter_type;   // only show stanzas with this element name
+    char* filter_jid;    // only show stanzas containing this JID
+    gboolean pretty;
     unsigned long memcheck;
 } ProfXMLWin;
 
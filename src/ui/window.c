@@ -148,6 +148,7 @@ win_create_chat(const char* const barejid)
     new_win->window.layout = _win_create_simple_layout();
 
     new_win->barejid = strdup(barejid);
+    new_win->jid = jid_create(barejid);
     new_win->resource_override = NULL;
     new_win->is_otr = FALSE;
     new_win->otr_is_trusted = FALSE;
@@ -268,6 +269,12 @@ win_create_xmlconsole(void)
     new_win->window.type = WIN_XML;
     new_win->window.scroll_state = WIN_SCROLL_INNER;
     new_win->window.layout = _win_create_simple_layout();
+    new_win->stanzas = g_queue_new();
+    new_win->stanzas_size = 0;
+    new_win->stale = FALSE;
+    new_win->filter_type = NULL;
+    new_win->filter_jid = NULL;
+    new_win->pretty = FALSE;
 
     new_win->memcheck = PROFXMLWIN_MEMCHECK;
 
@@ -579,6 +586,7 @@ win_free(ProfWin* window)
     {
         ProfChatWin* chatwin = (ProfChatWin*)window;
         free(chatwin->barejid);
+        jid_destroy(chatwin->jid);
         free(chatwin->resource_override);
         free(chatwin->enctext);
         free(chatwin->incoming_char);
@@ -619,6 +627,11 @@ win_free(ProfWin* window)
         free(pluginwin->plugin_name);
         break;
     }
+    case WIN_XML:
+    {
+        xmlwin_free((ProfXMLWin*)window);
+        break;
+    }
     default:
         break;
     }
@@ -782,6 +795,9 @@ void
 win_clear(ProfWin* window)
 {
     if (!prefs_get_boolean(PREF_CLEAR_PERSIST_HISTORY)) {
+        if (window->type == WIN_XML) {
+            xmlwin_clear((ProfXMLWin*)window);
+        }
         werase(window->layout->win);
         buffer_free(window->layout->buffer);
         window->layout->buffer = buffer_create();
@@ -1970,6 +1986,11 @@ win_print_trackbar(ProfWin* window)
 void
 win_redraw(ProfWin* window)
 {
+    if (window->type == WIN_XML) {
+        xmlwin_redraw((ProfXMLWin*)window);
+        return;
+    }
+
     int size = buffer_size(window->layout->buffer);
     werase(window->layout->win);
 
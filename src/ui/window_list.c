@@ -51,6 +51,7 @@
 #include "xmpp/xmpp.h"
 #include "xmpp/roster_list.h"
 #include "tools/http_upload.h"
+#include "tools/http_download.h"
 
 #ifdef HAVE_OMEMO
 #include "omemo/omemo.h"
@@ -98,6 +99,10 @@ wins_chat_exists(const char* const barejid)
 ProfChatWin*
 wins_get_chat(const char* const barejid)
 {
+    // each chat window holds the Jid of its barejid, so this finds the
+    // same instance and windows compare by pointer
+    auto_jid Jid* jid = jid_create(barejid);
+
     GList* values = g_hash_table_get_values(windows);
     GList* curr = values;
 
@@ -105,7 +110,7 @@ wins_get_chat(const char* const barejid)
         ProfWin* window = curr->data;
         if (window->type == WIN_CHAT) {
             ProfChatWin* chatwin = (ProfChatWin*)window;
-            if (g_strcmp0(chatwin->barejid, barejid) == 0) {
+            if (jid ? chatwin->jid == jid : g_strcmp0(chatwin->barejid, barejid) == 0) {
                 g_list_free(values);
                 return chatwin;
             }
@@ -528,8 +533,9 @@ wins_close_by_num(int i)
 
         ProfWin* window = wins_get_by_num(i);
         if (window) {
-            // cancel upload processes of this window
+            // cancel transfers of this window
             http_upload_cancel_processes(window);
+            http_download_cancel_processes(window);
 
             switch (window->type) {
             case WIN_CHAT:
@@ -1210,18 +1216,6 @@ win_close_autocomplete(const char* const search_str, gboolean previous, void* co
     return autocomplete_complete(wins_close_ac, search_str, TRUE, previous);
 }
 
-void
-win_reset_search_attempts(void)
-{
-    autocomplete_reset(wins_ac);
-}
-
-void
-win_close_reset_search_attempts(void)
-{
-    autocomplete_reset(wins_close_ac);
-}
-
 void
 wins_destroy(void)
 {
@@ -38,26 +38,260 @@
 #include <assert.h>
 #include <string.h>
 
+#ifdef HAVE_NCURSESW_NCURSES_H
+#include <ncursesw/ncurses.h>
+#elif HAVE_NCURSES_H
+#include <ncurses.h>
+#elif HAVE_CURSES_H
+#include <curses.h>
+#endif
+
+#include "common.h"
+#include "config/preferences.h"
+#include "config/theme.h"
+#include "tools/xml_pretty.h"
 #include "ui/win_types.h"
 #include "ui/window_list.h"
 
+// Stanzas are kept raw and only turned into screen lines when they are
+// visible: printed as they arrive while the console is the current window,
+// otherwise rendered from the newest ones that fit the pad when it is shown.
+#define XMLWIN_MAX_STANZAS     1000
+#define XMLWIN_MAX_SIZE        (4 * 1024 * 1024)
+#define XMLWIN_MAX_STANZA_SIZE (64 * 1024)
+
+typedef struct xml_stanza_t
+{
+    GDateTime* time;
+    gboolean sent;
+    char* name; // element name without namespace prefix
+    char* text;
+    gsize len;
+} XmlStanza;
+
+static void
+_xmlwin_stanza_free(XmlStanza* stanza)
+{
+    if (stanza == NULL) {
+        return;
+    }
+    g_date_time_unref(stanza->time);
+    free(stanza->name);
+    g_free(stanza->text);
+    free(stanza);
+}
+
+static XmlStanza*
+_xmlwin_stanza_new(const char* const text, gboolean sent)
+{
+    XmlStanza* stanza = malloc(sizeof(XmlStanza));
+    stanza->time = g_date_time_new_now_local();
+    stanza->sent = sent;
+
+    stanza->text = xml_pretty_truncate(text, XMLWIN_MAX_STANZA_SIZE);
+    stanza->len = strlen(stanza->text);
+
+    const char* name = strchr(text, '<');
+    if (name) {
+        name++;
+        size_t name_len = strcspn(name, " \t\r\n/>");
+        const char* colon = memchr(name, ':', name_len);
+        if (colon) {
+            name_len -= colon + 1 - name;
+            name = colon + 1;
+        }
+        stanza->name = strndup(name, name_len);
+    } else {
+        stanza->name = strdup("");
+    }
+
+    return stanza;
+}
+
+static gboolean
+_xmlwin_matches(ProfXMLWin* xmlwin, XmlStanza* stanza)
+{
+    if (xmlwin->filter_type && g_strcmp0(stanza->name, xmlwin->filter_type) != 0) {
+        return FALSE;
+    }
+    if (xmlwin->filter_jid && strstr(stanza->text, xmlwin->filter_jid) == NULL) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+_xmlwin_print_stanza(ProfXMLWin* xmlwin, XmlStanza* stanza, const char* const time_pref)
+{
+    WINDOW* win = ((ProfWin*)xmlwin)->layout->win;
+
+    wbkgdset(win, theme_attrs(THEME_TEXT));
+    if (g_strcmp0(time_pref, "off") != 0) {
+        auto_gchar gchar* date_fmt = g_date_time_format(stanza->time, time_pref);
+        wattron(win, theme_attrs(THEME_TIME));
+        wprintw(win, "%s - ", date_fmt ? date_fmt : "");
+        wattroff(win, theme_attrs(THEME_TIME));
+    }
+    waddstr(win, stanza->sent ? "SENT:\n" : "RECV:\n");
+
+    theme_item_t theme_item = stanza->sent ? THEME_ONLINE : THEME_AWAY;
+    wattron(win, theme_attrs(theme_item));
+    if (xmlwin->pretty) {
+        auto_gchar gchar* pretty = xml_pretty_print(stanza->text);
+        waddstr(win, pretty);
+    } else {
+        waddnstr(win, stanza->text, stanza->len);
+    }
+    wattroff(win, theme_attrs(theme_item));
+
+    waddstr(win, getcurx(win) == 0 ? "\n" : "\n\n");
+}
+
+// Screen lines a stanza takes, over rather than under estimated
+static int
+_xmlwin_stanza_rows(ProfXMLWin* xmlwin, XmlStanza* stanza, int cols)
+{
+    int rows = 2 + (int)(stanza->len / cols) + 1;
+    if (xmlwin->pretty) {
+        for (const char* p = stanza->text; (p = strchr(p, '<')); p++) {
+            rows++;
+        }
+    }
+
+    return rows;
+}
+
 void
 xmlwin_show(ProfXMLWin* xmlwin, const char* const msg)
 {
     assert(xmlwin != NULL);
 
-    ProfWin* window = (ProfWin*)xmlwin;
+    gboolean sent;
     if (g_str_has_prefix(msg, "SENT:")) {
-        win_println(window, THEME_DEFAULT, "-", "SENT:");
-        win_println(window, THEME_ONLINE, "-", "%s", &msg[6]);
-        win_println(window, THEME_ONLINE, "-", "");
+        sent = TRUE;
     } else if (g_str_has_prefix(msg, "RECV:")) {
-        win_println(window, THEME_DEFAULT, "-", "RECV:");
-        win_println(window, THEME_AWAY, "-", "%s", &msg[6]);
-        win_println(window, THEME_AWAY, "-", "");
+        sent = FALSE;
+    } else {
+        return;
+    }
+
+    XmlStanza* stanza = _xmlwin_stanza_new(msg[5] ? &msg[6] : "", sent);
+    g_queue_push_tail(xmlwin->stanzas, stanza);
+    xmlwin->stanzas_size += stanza->len;
+
+    while (g_queue_get_length(xmlwin->stanzas) > XMLWIN_MAX_STANZAS || xmlwin->stanzas_size > XMLWIN_MAX_SIZE) {
+        XmlStanza* oldest = g_queue_pop_head(xmlwin->stanzas);
+        xmlwin->stanzas_size -= oldest->len;
+        _xmlwin_stanza_free(oldest);
+    }
+
+    if (!wins_is_current((ProfWin*)xmlwin)) {
+        xmlwin->stale = TRUE;
+        return;
+    }
+
+    if (_xmlwin_matches(xmlwin, stanza)) {
+        auto_gchar gchar* time_pref = prefs_get_string(PREF_TIME_XMLCONSOLE);
+        _xmlwin_print_stanza(xmlwin, stanza, time_pref);
+    }
+}
+
+void
+xmlwin_redraw(ProfXMLWin* xmlwin)
+{
+    assert(xmlwin != NULL);
+
+    WINDOW* win = ((ProfWin*)xmlwin)->layout->win;
+    werase(win);
+    xmlwin->stale = FALSE;
+
+    // older stanzas would scroll off the pad anyway
+    int pad_rows = getmaxy(win);
+    int cols = getmaxx(win) > 0 ? getmaxx(win) : 1;
+    int rows = 0;
+    GList* first = NULL;
+    for (GList* curr = g_queue_peek_tail_link(xmlwin->stanzas); curr && rows < pad_rows; curr = curr->prev) {
+        if (_xmlwin_matches(xmlwin, curr->data)) {
+            rows += _xmlwin_stanza_rows(xmlwin, curr->data, cols);
+            first = curr;
+        }
+    }
+
+    auto_gchar gchar* time_pref = prefs_get_string(PREF_TIME_XMLCONSOLE);
+    for (GList* curr = first; curr; curr = curr->next) {
+        if (_xmlwin_matches(xmlwin, curr->data)) {
+            _xmlwin_print_stanza(xmlwin, curr->data, time_pref);
+        }
+    }
+}
+
+void
+xmlwin_focus(ProfXMLWin* xmlwin)
+{
+    assert(xmlwin != NULL);
+
+    if (xmlwin->stale) {
+        xmlwin_redraw(xmlwin);
+    }
+}
+
+void
+xmlwin_clear(ProfXMLWin* xmlwin)
+{
+    assert(xmlwin != NULL);
+
+    g_queue_clear_full(xmlwin->stanzas, (GDestroyNotify)_xmlwin_stanza_free);
+    xmlwin->stanzas_size = 0;
+}
+
+void
+xmlwin_free(ProfXMLWin* xmlwin)
+{
+    assert(xmlwin != NULL);
+
+    g_queue_free_full(xmlwin->stanzas, (GDestroyNotify)_xmlwin_stanza_free);
+    free(xmlwin->filter_type);
+    free(xmlwin->filter_jid);
+}
+
+static void
+_xmlwin_changed(ProfXMLWin* xmlwin)
+{
+    if (wins_is_current((ProfWin*)xmlwin)) {
+        xmlwin_redraw(xmlwin);
+        ((ProfWin*)xmlwin)->layout->paged = 0;
+    } else {
+        xmlwin->stale = TRUE;
     }
 }
 
+void
+xmlwin_set_filter(ProfXMLWin* xmlwin, const char* const type, const char* const jid)
+{
+    assert(xmlwin != NULL);
+
+    // either may be the current filter
+    char* new_type = type ? strdup(type) : NULL;
+    char* new_jid = jid ? strdup(jid) : NULL;
+    free(xmlwin->filter_type);
+    free(xmlwin->filter_jid);
+    xmlwin->filter_type = new_type;
+    xmlwin->filter_jid = new_jid;
+
+    _xmlwin_changed(xmlwin);
+}
+
+void
+xmlwin_set_pretty(ProfXMLWin* xmlwin, gboolean pretty)
+{
+    assert(xmlwin != NULL);
+
+    xmlwin->pretty = pretty;
+
+    _xmlwin_changed(xmlwin);
+}
+
 gchar*
 xmlwin_get_string(ProfXMLWin* xmlwin)
 {
@@ -54,29 +54,151 @@
 #include "config/files.h"
 #include "config/preferences.h"
 
+#include "common.h"
+
 typedef struct avatar_metadata
 {
     char* type;
     char* id;
 } avatar_metadata;
 
+// decoded and written to disk off the main thread, see _avatar_save_worker()
+typedef struct avatar_save_job
+{
+    char* from;
+    char* id;
+    char* b64;
+    char* filename;
+    gboolean saved;
+    char* error;
+
+    // vCard photos are cached by the SHA-1 of their data, computed by the worker into id
+    gboolean vcard;
+    gboolean open;
+    char* cached_id;
+} avatar_save_job;
+
+// saving and scaling run on a few shared threads, like vCard requests only a few at a time
+#define AVATAR_MAX_WORKERS 4
+
+typedef struct avatar_work
+{
+    void (*run)(gpointer job); // on a worker thread, must not touch the UI or the connection
+    gpointer job;
+} avatar_work;
+
 static GHashTable* looking_for = NULL; // contains nicks/barejids from who we want to get the avatar
 static GHashTable* shall_open = NULL;  // contains a list of nicks that shall not just downloaded but also opened
+static prof_keyfile_t avatar_cache;    // barejid -> avatar id and file of the last downloaded avatar
 const int MAX_PIXEL = 192;             // max pixel width/height for an avatar
+static GThreadPool* avatar_workers = NULL;
 
 static void _avatar_request_item_by_id(const char* jid, avatar_metadata* data);
 static int _avatar_metadata_handler(xmpp_stanza_t* const stanza, void* const userdata);
 static int _avatar_request_item_result_handler(xmpp_stanza_t* const stanza, void* const userdata);
+static void _avatar_open(const char* const from, const char* const filename);
 
 static void
 _free_avatar_data(avatar_metadata* data)
 {
     if (data) {
         free(data->type);
+        free(data->id);
         free(data);
     }
 }
 
+static void
+_free_avatar_save_job(avatar_save_job* job)
+{
+    if (job) {
+        free(job->from);
+        g_free(job->id);
+        g_free(job->b64);
+        g_free(job->filename);
+        g_free(job->error);
+        g_free(job->cached_id);
+        free(job);
+    }
+}
+
+static void
+_avatar_worker_run(gpointer data, gpointer unused)
+{
+    avatar_work* work = data;
+
+    work->run(work->job);
+    free(work);
+}
+
+static void
+_avatar_work_push(void (*run)(gpointer job), gpointer job)
+{
+    if (avatar_workers == NULL) {
+        avatar_workers = g_thread_pool_new(_avatar_worker_run, NULL, AVATAR_MAX_WORKERS, FALSE, NULL);
+    }
+
+    avatar_work* work = malloc(sizeof(avatar_work));
+    work->run = run;
+    work->job = job;
+    g_thread_pool_push(avatar_workers, work, NULL);
+}
+
+static void
+_avatar_cache_load(void)
+{
+    free_keyfile(&avatar_cache);
+
+    gchar* cacheloc = files_file_in_account_data_path(DIR_AVATARS, connection_get_barejid(), "cache");
+    if (!cacheloc) {
+        log_error("Avatar: could not create cache directory for account %s.", connection_get_barejid());
+        return;
+    }
+    load_custom_keyfile(&avatar_cache, cacheloc);
+}
+
+// Returns the cached file for jid if it still holds the avatar with the given id
+static gchar*
+_avatar_cache_lookup(const char* const jid, const char* const id)
+{
+    if (!avatar_cache.keyfile) {
+        return NULL;
+    }
+
+    auto_gchar gchar* cached_id = g_key_file_get_string(avatar_cache.keyfile, jid, "id", NULL);
+    if (g_strcmp0(cached_id, id) != 0) {
+        return NULL;
+    }
+
+    gchar* filename = g_key_file_get_string(avatar_cache.keyfile, jid, "file", NULL);
+    if (filename && !g_file_test(filename, G_FILE_TEST_EXISTS)) {
+        g_free(filename);
+        return NULL;
+    }
+
+    return filename;
+}
+
+static void
+_avatar_cache_store(const char* const jid, const char* const id, const char* const filename)
+{
+    if (!avatar_cache.keyfile) {
+        return;
+    }
+
+    g_key_file_set_string(avatar_cache.keyfile, jid, "id", id);
+    g_key_file_set_string(avatar_cache.keyfile, jid, "file", filename);
+    save_keyfile(&avatar_cache);
+}
+
+// vCard photos share the cache with PEP avatars, in their own group so they
+// don't make us follow the PEP avatar of that contact
+static gchar*
+_avatar_cache_vcard_group(const char* const jid)
+{
+    return g_strdup_printf("vcard:%s", jid);
+}
+
 void
 avatar_pep_subscribe(void)
 {
@@ -94,20 +216,74 @@ avatar_pep_subscribe(void)
         g_hash_table_destroy(shall_open);
     }
     shall_open = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    _avatar_cache_load();
 }
 
 #ifdef HAVE_PIXBUF
-gboolean
-avatar_set(const char* path)
+typedef struct avatar_scale_job
+{
+    gchar* path;
+    gchar* img_data;
+    gsize len;
+    int width;
+    int height;
+    char* error;
+} avatar_scale_job;
+
+static void
+_free_avatar_scale_job(avatar_scale_job* job)
+{
+    if (job) {
+        g_free(job->path);
+        g_free(job->img_data);
+        g_free(job->error);
+        free(job);
+    }
+}
+
+static gboolean
+_avatar_scale_done(gpointer userdata)
+{
+    avatar_scale_job* job = userdata;
+
+    if (job->error) {
+        cons_show_error("%s", job->error);
+    } else if (connection_get_status() != JABBER_CONNECTED) {
+        cons_show_error("Unable to publish avatar: not connected.");
+    } else {
+        xmpp_ctx_t* const ctx = connection_get_ctx();
+        xmpp_stanza_t* iq = stanza_create_avatar_data_publish_iq(ctx, job->img_data, job->len);
+        iq_send_stanza(iq);
+        xmpp_stanza_release(iq);
+
+        iq = stanza_create_avatar_metadata_publish_iq(ctx, job->img_data, job->len, job->height, job->width);
+        iq_send_stanza(iq);
+        xmpp_stanza_release(iq);
+
+        cons_show("Avatar updated successfully");
+    }
+
+    _free_avatar_scale_job(job);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+_avatar_scale_worker(gpointer userdata)
 {
-    auto_char char* expanded_path = get_expanded_path(path);
+    avatar_scale_job* job = userdata;
 
     GError* err = NULL;
-    GdkPixbuf* pixbuf = gdk_pixbuf_new_from_file(expanded_path, &err);
+    GdkPixbuf* pixbuf = gdk_pixbuf_new_from_file(job->path, &err);
 
     if (pixbuf == NULL) {
-        cons_show_error("An error occurred while opening %s: %s.", expanded_path, err ? err->message : "No error message given");
-        return FALSE;
+        job->error = g_strdup_printf("An error occurred while opening %s: %s.", job->path, err ? err->message : "No error message given");
+        if (err) {
+            g_error_free(err);
+        }
+        g_idle_add(_avatar_scale_done, job);
+        return;
     }
 
     // Scale img
@@ -126,23 +302,31 @@ avatar_set(const char* path)
         pixbuf = new_pixbuf;
     }
 
-    auto_gchar gchar* img_data = NULL;
-    gsize len = -1;
+    if (!gdk_pixbuf_save_to_buffer(pixbuf, &job->img_data, &job->len, "png", &err, NULL)) {
+        job->error = g_strdup("Unable to scale and convert avatar.");
+        if (err) {
+            g_error_free(err);
+        }
+    } else {
+        job->width = gdk_pixbuf_get_width(pixbuf);
+        job->height = gdk_pixbuf_get_height(pixbuf);
+    }
+    g_object_unref(pixbuf);
+
+    g_idle_add(_avatar_scale_done, job);
+}
 
-    if (!gdk_pixbuf_save_to_buffer(pixbuf, &img_data, &len, "png", &err, NULL)) {
-        cons_show_error("Unable to scale and convert avatar.");
+gboolean
+avatar_set(const char* path)
+{
+    avatar_scale_job* job = calloc(1, sizeof(avatar_scale_job));
+    if (!job) {
         return FALSE;
     }
+    job->path = get_expanded_path(path);
 
-    xmpp_ctx_t* const ctx = connection_get_ctx();
-    xmpp_stanza_t* iq = stanza_create_avatar_data_publish_iq(ctx, img_data, len);
-    iq_send_stanza(iq);
-    xmpp_stanza_release(iq);
-
-    iq = stanza_create_avatar_metadata_publish_iq(ctx, img_data, len, gdk_pixbuf_get_height(pixbuf), gdk_pixbuf_get_width(pixbuf));
-    g_object_unref(pixbuf);
-    iq_send_stanza(iq);
-    xmpp_stanza_release(iq);
+    // loading and scaling big images can take a while, keep the UI responsive
+    _avatar_work_push(_avatar_scale_worker, job);
 
     return TRUE;
 }
@@ -186,7 +370,9 @@ _avatar_metadata_handler(xmpp_stanza_t* const stanza, void* const userdata)
         return 1;
     }
 
-    if (!g_hash_table_contains(looking_for, from)) {
+    // besides the avatars we asked for, keep the ones we already have up to date
+    gboolean requested = g_hash_table_contains(looking_for, from);
+    if (!requested && !(avatar_cache.keyfile && g_key_file_has_group(avatar_cache.keyfile, from))) {
         return 1;
     }
 
@@ -224,6 +410,23 @@ _avatar_metadata_handler(xmpp_stanza_t* const stanza, void* const userdata)
                 if (id && type) {
                     log_debug("Avatar ID for %s is: %s", from, id);
 
+                    // the id is the SHA-1 of the image, only fetch it again when it changed
+                    auto_gchar gchar* cached = _avatar_cache_lookup(from, id);
+                    if (cached) {
+                        log_debug("Avatar for %s unchanged, using %s", from, cached);
+                        if (requested) {
+                            caps_remove_feature(XMPP_FEATURE_USER_AVATAR_METADATA_NOTIFY);
+                            g_hash_table_remove(looking_for, from);
+                            cons_show("Avatar saved as %s", cached);
+                            _avatar_open(from, cached);
+                        }
+                        return 1;
+                    }
+
+                    if (!requested) {
+                        g_hash_table_insert(looking_for, strdup(from), NULL);
+                    }
+
                     avatar_metadata* data = malloc(sizeof(avatar_metadata));
                     if (data) {
                         data->type = strdup(type);
@@ -233,7 +436,7 @@ _avatar_metadata_handler(xmpp_stanza_t* const stanza, void* const userdata)
                         _avatar_request_item_by_id(from, data);
                     }
                 }
-            } else {
+            } else if (requested) {
                 cons_show("We couldn't get the user's avatar, possibly because they haven't set one or have disabled avatar publishing. "
                           "During this Profanity session, you will receive future changes to this user's avatar.");
             }
@@ -259,6 +462,113 @@ _avatar_request_item_by_id(const char* jid, avatar_metadata* data)
     xmpp_stanza_release(iq);
 }
 
+static void
+_avatar_open(const char* const from, const char* const filename)
+{
+    if (!g_hash_table_contains(shall_open, from)) {
+        return;
+    }
+
+    auto_gchar gchar* cmdtemplate = prefs_get_string(PREF_AVATAR_CMD);
+
+    if (cmdtemplate == NULL) {
+        cons_show_error("No default `avatar open` command found in executables preferences.");
+    } else {
+        auto_gcharv gchar** argv = format_call_external_argv(cmdtemplate, NULL, filename);
+
+        if (!call_external(argv)) {
+            cons_show_error("Unable to display avatar: check the logs for more information.");
+        }
+    }
+
+    g_hash_table_remove(shall_open, from);
+}
+
+static void
+_avatar_vcard_photo_open(const char* const filename)
+{
+    auto_gcharv gchar** argv = NULL;
+    gint argc;
+    GError* err = NULL;
+
+    auto_gchar gchar* cmdtemplate = prefs_get_string(PREF_VCARD_PHOTO_CMD);
+
+    // this makes it work with filenames that contain spaces
+    auto_gchar gchar* quoted = g_strdup_printf("\"%s\"", filename);
+    auto_char char* cmd = str_replace(cmdtemplate, "%p", quoted);
+
+    if (g_shell_parse_argv(cmd, &argc, &argv, &err) == FALSE) {
+        cons_show_error("Failed to parse command template");
+        g_error_free(err);
+    } else {
+        if (!call_external(argv)) {
+            cons_show_error("Unable to execute command");
+        }
+    }
+}
+
+static gboolean
+_avatar_save_done(gpointer userdata)
+{
+    avatar_save_job* job = userdata;
+
+    if (job->vcard) {
+        if (!job->saved) {
+            cons_show_error("Unable to save photo: %s", job->error);
+        } else {
+            auto_gchar gchar* group = _avatar_cache_vcard_group(job->from);
+            _avatar_cache_store(group, job->id, job->filename);
+            cons_show("Photo saved as %s", job->filename);
+            if (job->open) {
+                _avatar_vcard_photo_open(job->filename);
+            }
+        }
+    } else if (!job->saved) {
+        log_error("Unable to save picture: %s", job->error);
+        cons_show("Unable to save picture %s", job->error);
+    } else {
+        _avatar_cache_store(job->from, job->id, job->filename);
+        cons_show("Avatar saved as %s", job->filename);
+        if (shall_open) {
+            _avatar_open(job->from, job->filename);
+        }
+    }
+
+    _free_avatar_save_job(job);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+_avatar_save_worker(gpointer userdata)
+{
+    avatar_save_job* job = userdata;
+
+    gsize size;
+    auto_gchar gchar* de = (gchar*)g_base64_decode(job->b64, &size);
+
+    if (job->vcard) {
+        job->id = g_compute_checksum_for_data(G_CHECKSUM_SHA1, (guchar*)de, size);
+
+        // same photo as the one we saved there last time
+        if (g_strcmp0(job->id, job->cached_id) == 0 && g_file_test(job->filename, G_FILE_TEST_EXISTS)) {
+            job->saved = TRUE;
+            g_idle_add(_avatar_save_done, job);
+            return;
+        }
+    }
+
+    GError* err = NULL;
+    if (g_file_set_contents(job->filename, de, size, &err) == FALSE) {
+        job->error = g_strdup(err->message);
+        g_error_free(err);
+    } else {
+        job->saved = TRUE;
+    }
+
+    g_idle_add(_avatar_save_done, job);
+}
+
 static int
 _avatar_request_item_result_handler(xmpp_stanza_t* const stanza, void* const userdata)
 {
@@ -298,27 +608,15 @@ _avatar_request_item_result_handler(xmpp_stanza_t* const stanza, void* const use
         return 1;
     }
 
-    gsize size;
-    auto_gchar gchar* de = (gchar*)g_base64_decode(buf, &size);
-
-    auto_gchar gchar* path = files_get_data_path("");
-    GString* filename = g_string_new(path);
-
-    g_string_append(filename, "avatars/");
-
-    errno = 0;
-    int res = g_mkdir_with_parents(filename->str, S_IRWXU);
-    if (res == -1) {
-        const char* errmsg = strerror(errno);
-        if (errmsg) {
-            log_error("Avatar: error creating directory: %s, %s", filename->str, errmsg);
-        } else {
-            log_error("Avatar: creating directory: %s", filename->str);
-        }
-    }
-
     auto_char char* from = str_replace(from_attr, "@", "_at_");
-    g_string_append(filename, from);
+    GString* filename = g_string_new(NULL);
+    auto_gchar gchar* path = files_file_in_account_data_path(DIR_AVATARS, connection_get_barejid(), from);
+    if (!path) {
+        log_error("Avatar: could not create directory for account %s", connection_get_barejid());
+        g_string_free(filename, TRUE);
+        return 1;
+    }
+    g_string_append(filename, path);
 
     avatar_metadata* data = (avatar_metadata*)userdata;
 
@@ -334,33 +632,42 @@ _avatar_request_item_result_handler(xmpp_stanza_t* const stanza, void* const use
         g_string_append(filename, ".webp");
     }
 
-    GError* err = NULL;
-    if (g_file_set_contents(filename->str, de, size, &err) == FALSE) {
-        log_error("Unable to save picture: %s", err->message);
-        cons_show("Unable to save picture %s", err->message);
-        g_error_free(err);
-    } else {
-        cons_show("Avatar saved as %s", filename->str);
+    avatar_save_job* job = calloc(1, sizeof(avatar_save_job));
+    if (!job) {
+        g_string_free(filename, TRUE);
+        return 1;
     }
+    job->from = strdup(from_attr);
+    job->id = g_strdup(data->id);
+    job->b64 = g_strdup(buf);
+    job->filename = g_string_free(filename, FALSE);
 
-    // if we shall open it
-    if (g_hash_table_contains(shall_open, from_attr)) {
-        auto_gchar gchar* cmdtemplate = prefs_get_string(PREF_AVATAR_CMD);
+    // decoding and writing the image can take a while, keep the UI responsive
+    _avatar_work_push(_avatar_save_worker, job);
 
-        if (cmdtemplate == NULL) {
-            cons_show_error("No default `avatar open` command found in executables preferences.");
-        } else {
-            auto_gcharv gchar** argv = format_call_external_argv(cmdtemplate, NULL, filename->str);
+    return 1;
+}
 
-            if (!call_external(argv)) {
-                cons_show_error("Unable to display avatar: check the logs for more information.");
-            }
+void
+avatar_save_vcard_photo(const char* const from, const char* const b64, const char* const filename, gboolean open)
+{
+    avatar_save_job* job = calloc(1, sizeof(avatar_save_job));
+    if (!job) {
+        return;
+    }
+    job->from = strdup(from);
+    job->b64 = g_strdup(b64);
+    job->filename = g_strdup(filename);
+    job->vcard = TRUE;
+    job->open = open;
+
+    if (avatar_cache.keyfile) {
+        auto_gchar gchar* group = _avatar_cache_vcard_group(from);
+        auto_gchar gchar* cached_file = g_key_file_get_string(avatar_cache.keyfile, group, "file", NULL);
+        if (g_strcmp0(cached_file, filename) == 0) {
+            job->cached_id = g_key_file_get_string(avatar_cache.keyfile, group, "id", NULL);
         }
-
-        g_hash_table_remove(shall_open, from_attr);
     }
 
-    g_string_free(filename, TRUE);
-
-    return 1;
+    _avatar_work_push(_avatar_save_worker, job);
 }
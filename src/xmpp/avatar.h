@@ -40,6 +40,7 @@
 
 void avatar_pep_subscribe(void);
 gboolean avatar_get_by_nick(const char* nick, gboolean open);
+void avatar_save_vcard_photo(const char* const from, const char* const b64, const char* const filename, gboolean open);
 #ifdef HAVE_PIXBUF
 gboolean avatar_set(const char* path);
 #endif
@@ -93,14 +93,6 @@ blocked_ac_find(const char* const search_str, gboolean previous, void* context)
     return autocomplete_complete(blocked_ac, search_str, TRUE, previous);
 }
 
-void
-blocked_ac_reset(void)
-{
-    if (blocked_ac) {
-        autocomplete_reset(blocked_ac);
-    }
-}
-
 gboolean
 blocked_add(char* jid, blocked_report reportkind, const char* const message)
 {
@@ -179,7 +179,7 @@ bookmark_join(const char* jid)
         return FALSE;
     }
 
-    ProfAccount* account = accounts_get_account(session_get_account_name());
+    ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
     if (!muc_active(bookmark->barejid)) {
         char* nick = bookmark->nick;
         if (!nick) {
@@ -236,14 +236,6 @@ bookmark_find(const char* const search_str, gboolean previous, void* context)
     return autocomplete_complete(bookmark_ac, search_str, TRUE, previous);
 }
 
-void
-bookmark_autocomplete_reset(void)
-{
-    if (bookmark_ac) {
-        autocomplete_reset(bookmark_ac);
-    }
-}
-
 gboolean
 bookmark_exists(const char* const room)
 {
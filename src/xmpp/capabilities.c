@@ -54,20 +54,47 @@
 #include "xmpp/form.h"
 #include "xmpp/capabilities.h"
 
+// seconds to wait before writing newly discovered capabilities to disk
+#define CAPS_SAVE_DELAY 10
+
 static gchar* cache_loc;
 static prof_keyfile_t caps_prof_keyfile;
 static GKeyFile* cache;
+static guint save_timer;
 
 static GHashTable* jid_to_ver;
 static GHashTable* jid_to_caps;
+static GHashTable* ver_to_caps;
+
+// feature namespaces that are checked often get a bit in EntityCapabilities.known_features
+static const char* const known_features[] = {
+    XMPP_FEATURE_PING,
+    XMPP_FEATURE_BLOCKING,
+    XMPP_FEATURE_RECEIPTS,
+    XMPP_FEATURE_LASTACTIVITY,
+    XMPP_FEATURE_MUC,
+    XMPP_FEATURE_COMMANDS,
+    XMPP_FEATURE_LAST_MESSAGE_CORRECTION,
+    XMPP_FEATURE_MAM2,
+    XMPP_FEATURE_MAM2_EXTENDED,
+    XMPP_FEATURE_SPAM_REPORTING,
+    STANZA_NS_CHATSTATES,
+    STANZA_NS_CONFERENCE,
+    STANZA_NS_VERSION,
+    STANZA_NS_STABLE_ID,
+};
+G_STATIC_ASSERT(G_N_ELEMENTS(known_features) <= 64);
+static GHashTable* known_feature_bits;
 
 static GHashTable* prof_features;
 static gchar* my_sha1;
 
 static void _save_cache(void);
+static void _schedule_save_cache(void);
 static EntityCapabilities* _caps_by_ver(const char* const ver);
 static EntityCapabilities* _caps_by_jid(const char* const jid);
-static EntityCapabilities* _caps_copy(EntityCapabilities* caps);
+static EntityCapabilities* _caps_ref(EntityCapabilities* caps);
+static guint64 _caps_feature_bit(const char* const feature);
 
 void
 caps_init(void)
@@ -78,6 +105,8 @@ caps_init(void)
 
     jid_to_ver = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
     jid_to_caps = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)caps_destroy);
+    ver_to_caps = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)caps_destroy);
+    save_timer = 0;
 
     prof_features = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
     g_hash_table_add(prof_features, strdup(STANZA_NS_CAPS));
@@ -196,11 +225,15 @@ caps_create(const char* const category, const char* const type, const char* cons
     }
 
     result->features = NULL;
+    result->known_features = 0;
     GSList* curr = features;
     while (curr) {
-        result->features = g_slist_append(result->features, strdup(curr->data));
+        result->features = g_slist_prepend(result->features, strdup(curr->data));
+        result->known_features |= _caps_feature_bit(curr->data);
         curr = g_slist_next(curr);
     }
+    result->features = g_slist_reverse(result->features);
+    result->refcnt = 1;
 
     return result;
 }
@@ -258,7 +291,9 @@ caps_add_by_ver(const char* const ver, EntityCapabilities* caps)
         g_key_file_set_string_list(cache, ver, "features", features_list, num);
     }
 
-    _save_cache();
+    g_hash_table_insert(ver_to_caps, strdup(ver), _caps_ref(caps));
+
+    _schedule_save_cache();
 }
 
 void
@@ -287,13 +322,13 @@ caps_lookup(const char* const jid)
         EntityCapabilities* caps = _caps_by_ver(ver);
         if (caps) {
             log_debug("Capabilities lookup %s, found by verification string %s.", jid, ver);
-            return caps;
+            return _caps_ref(caps);
         }
     } else {
         EntityCapabilities* caps = _caps_by_jid(jid);
         if (caps) {
             log_debug("Capabilities lookup %s, found by JID.", jid);
-            return _caps_copy(caps);
+            return _caps_ref(caps);
         }
     }
 
@@ -304,18 +339,19 @@ caps_lookup(const char* const jid)
 gboolean
 caps_jid_has_feature(const char* const jid, const char* const feature)
 {
-    EntityCapabilities* caps = caps_lookup(jid);
+    char* ver = g_hash_table_lookup(jid_to_ver, jid);
+    EntityCapabilities* caps = ver ? _caps_by_ver(ver) : _caps_by_jid(jid);
 
     if (caps == NULL) {
         return FALSE;
     }
 
-    GSList* found = g_slist_find_custom(caps->features, feature, (GCompareFunc)g_strcmp0);
-    gboolean result = found != NULL;
-
-    caps_destroy(caps);
+    guint64 bit = _caps_feature_bit(feature);
+    if (bit) {
+        return (caps->known_features & bit) != 0;
+    }
 
-    return result;
+    return g_slist_find_custom(caps->features, feature, (GCompareFunc)g_strcmp0) != NULL;
 }
 
 char*
@@ -342,10 +378,21 @@ caps_reset_ver(void)
 void
 caps_close(void)
 {
+    if (save_timer) {
+        g_source_remove(save_timer);
+        save_timer = 0;
+        _save_cache();
+    }
     free_keyfile(&caps_prof_keyfile);
     cache = NULL;
     g_hash_table_destroy(jid_to_ver);
     g_hash_table_destroy(jid_to_caps);
+    g_hash_table_destroy(ver_to_caps);
+    ver_to_caps = NULL;
+    if (known_feature_bits) {
+        g_hash_table_destroy(known_feature_bits);
+        known_feature_bits = NULL;
+    }
     g_free(cache_loc);
     cache_loc = NULL;
     g_hash_table_destroy(prof_features);
@@ -355,6 +402,11 @@ caps_close(void)
 static EntityCapabilities*
 _caps_by_ver(const char* const ver)
 {
+    EntityCapabilities* cached = g_hash_table_lookup(ver_to_caps, ver);
+    if (cached) {
+        return cached;
+    }
+
     if (!g_key_file_has_group(cache, ver)) {
         return NULL;
     }
@@ -384,6 +436,9 @@ _caps_by_ver(const char* const ver)
 
     g_slist_free(features);
 
+    // the table owns the parsed entry, callers take their own reference
+    g_hash_table_insert(ver_to_caps, strdup(ver), result);
+
     return result;
 }
 
@@ -394,22 +449,31 @@ _caps_by_jid(const char* const jid)
 }
 
 static EntityCapabilities*
-_caps_copy(EntityCapabilities* caps)
+_caps_ref(EntityCapabilities* caps)
 {
-    if (!caps) {
-        return NULL;
+    if (caps) {
+        caps->refcnt++;
     }
 
-    const char* const categoty = caps->identity ? caps->identity->category : NULL;
-    const char* const type = caps->identity ? caps->identity->type : NULL;
-    const char* const name = caps->identity ? caps->identity->name : NULL;
+    return caps;
+}
+
+static guint64
+_caps_feature_bit(const char* const feature)
+{
+    if (known_feature_bits == NULL) {
+        known_feature_bits = g_hash_table_new(g_str_hash, g_str_equal);
+        for (guint i = 0; i < G_N_ELEMENTS(known_features); i++) {
+            g_hash_table_insert(known_feature_bits, (gpointer)known_features[i], GUINT_TO_POINTER(i + 1));
+        }
+    }
 
-    const char* const software = caps->software_version ? caps->software_version->software : NULL;
-    const char* const software_version = caps->software_version ? caps->software_version->software_version : NULL;
-    const char* const os = caps->software_version ? caps->software_version->os : NULL;
-    const char* const os_version = caps->software_version ? caps->software_version->os_version : NULL;
+    guint index = GPOINTER_TO_UINT(g_hash_table_lookup(known_feature_bits, feature));
+    if (index == 0) {
+        return 0;
+    }
 
-    return caps_create(categoty, type, name, software, software_version, os, os_version, caps->features);
+    return G_GUINT64_CONSTANT(1) << (index - 1);
 }
 
 static void
@@ -438,7 +502,7 @@ _software_version_destroy(SoftwareVersion* software_version)
 void
 caps_destroy(EntityCapabilities* caps)
 {
-    if (caps) {
+    if (caps && --caps->refcnt <= 0) {
         _disco_identity_destroy(caps->identity);
         _software_version_destroy(caps->software_version);
         if (caps->features) {
@@ -453,3 +517,21 @@ _save_cache(void)
 {
     save_keyfile(&caps_prof_keyfile);
 }
+
+static gboolean
+_save_cache_timeout(gpointer data)
+{
+    save_timer = 0;
+    _save_cache();
+
+    return G_SOURCE_REMOVE;
+}
+
+// batch discoveries arriving in bursts (e.g. after joining a room) into a single write
+static void
+_schedule_save_cache(void)
+{
+    if (save_timer == 0) {
+        save_timer = g_timeout_add_seconds(CAPS_SAVE_DELAY, _save_cache_timeout, NULL);
+    }
+}
@@ -0,0 +1,231 @@
+/*
+ * caps_requests.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2024 Michael Vetter <jubalh@iodoru.org>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "log.h"
+#include "xmpp/caps_requests.h"
+
+struct caps_requests_t
+{
+    GHashTable* by_ver; // ver -> CapsRequest, queued or in flight
+    GQueue* queued;
+    guint active;       // in flight
+    GHashTable* failed; // ver -> expiry time
+};
+
+static void
+_caps_request_free(CapsRequest* request)
+{
+    if (request == NULL) {
+        return;
+    }
+    free(request->ver);
+    free(request->node);
+    free(request->id);
+    g_slist_free_full(request->jids, free);
+    free(request);
+}
+
+CapsRequests*
+caps_requests_new(void)
+{
+    CapsRequests* requests = g_new0(CapsRequests, 1);
+    requests->by_ver = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)_caps_request_free);
+    requests->queued = g_queue_new();
+    requests->failed = g_hash_table_new_full(g_str_hash, g_str_equal, free, g_free);
+
+    return requests;
+}
+
+void
+caps_requests_free(CapsRequests* requests)
+{
+    if (requests) {
+        g_queue_free(requests->queued);
+        g_hash_table_destroy(requests->by_ver);
+        g_hash_table_destroy(requests->failed);
+        g_free(requests);
+    }
+}
+
+static gboolean
+_caps_requests_failed(CapsRequests* requests, const char* const ver, gint64 now)
+{
+    gint64* expiry = g_hash_table_lookup(requests->failed, ver);
+    if (expiry == NULL) {
+        return FALSE;
+    }
+
+    if (*expiry < now) {
+        g_hash_table_remove(requests->failed, ver);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+caps_request_add_t
+caps_requests_add(CapsRequests* requests, const char* const jid, const char* const id,
+                  const char* const node, const char* const ver, gint64 now)
+{
+    if (_caps_requests_failed(requests, ver, now)) {
+        return CAPS_REQUEST_FAILED;
+    }
+
+    CapsRequest* request = g_hash_table_lookup(requests->by_ver, ver);
+    if (request) {
+        if (!g_slist_find_custom(request->jids, jid, (GCompareFunc)g_strcmp0)) {
+            request->jids = g_slist_append(request->jids, strdup(jid));
+        }
+        return CAPS_REQUEST_PENDING;
+    }
+
+    request = malloc(sizeof(CapsRequest));
+    request->ver = strdup(ver);
+    request->node = strdup(node);
+    request->id = strdup(id);
+    request->jids = g_slist_append(NULL, strdup(jid));
+    request->sent = 0;
+    g_hash_table_insert(requests->by_ver, request->ver, request);
+    g_queue_push_tail(requests->queued, request);
+
+    return CAPS_REQUEST_QUEUED;
+}
+
+CapsRequest*
+caps_requests_get(CapsRequests* requests, const char* const ver)
+{
+    return g_hash_table_lookup(requests->by_ver, ver);
+}
+
+static gboolean
+_caps_request_expired(gpointer key, CapsRequest* request, gint64* limits)
+{
+    gint64 timeout = limits[0];
+    gint64 now = limits[1];
+
+    if (request->sent && now - request->sent > timeout) {
+        log_debug("Capabilities request for %s timed out", request->ver);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+// The next queued request to send if less than max are in flight, it counts as
+// sent at now. Requests in flight for longer than timeout are dropped to make room.
+CapsRequest*
+caps_requests_next(CapsRequests* requests, guint max, gint64 timeout, gint64 now)
+{
+    max = MAX(max, 1);
+
+    if (requests->active >= max) {
+        gint64 limits[] = { timeout, now };
+        requests->active -= g_hash_table_foreach_remove(requests->by_ver, (GHRFunc)_caps_request_expired, limits);
+    }
+
+    if (requests->active >= max || g_queue_is_empty(requests->queued)) {
+        return NULL;
+    }
+
+    CapsRequest* request = g_queue_pop_head(requests->queued);
+    request->sent = now;
+    requests->active++;
+
+    return request;
+}
+
+// The queried JID could not answer, returns the request to send again to the
+// next JID waiting, or NULL when none is left and the request is done
+CapsRequest*
+caps_requests_retry(CapsRequests* requests, const char* const ver, gint64 now)
+{
+    CapsRequest* request = g_hash_table_lookup(requests->by_ver, ver);
+    if (request == NULL || request->jids->next == NULL) {
+        caps_requests_done(requests, ver);
+        return NULL;
+    }
+
+    GSList* first = request->jids;
+    request->jids = g_slist_remove_link(request->jids, first);
+    g_slist_free_full(first, free);
+
+    if (!request->sent) {
+        g_queue_remove(requests->queued, request);
+        requests->active++;
+    }
+    request->sent = now;
+
+    return request;
+}
+
+void
+caps_requests_done(CapsRequests* requests, const char* const ver)
+{
+    CapsRequest* request = g_hash_table_lookup(requests->by_ver, ver);
+    if (request == NULL) {
+        return;
+    }
+
+    if (request->sent) {
+        requests->active--;
+    } else {
+        g_queue_remove(requests->queued, request);
+    }
+    g_hash_table_remove(requests->by_ver, ver);
+}
+
+// The answer for ver failed verification, it isn't asked for again before until
+void
+caps_requests_fail(CapsRequests* requests, const char* const ver, gint64 until)
+{
+    gint64* expiry = g_new(gint64, 1);
+    *expiry = until;
+    g_hash_table_replace(requests->failed, strdup(ver), expiry);
+
+    caps_requests_done(requests, ver);
+}
+
+guint
+caps_requests_active(CapsRequests* requests)
+{
+    return requests->active;
+}
@@ -0,0 +1,81 @@
+/*
+ * caps_requests.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2024 Michael Vetter <jubalh@iodoru.org>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+
+#ifndef XMPP_CAPS_REQUESTS_H
+#define XMPP_CAPS_REQUESTS_H
+
+#include <glib.h>
+
+/*
+ * Pending disco#info queries for entity capabilities, one per ver.
+ *
+ * JIDs advertising a ver that is already being asked for wait on that
+ * query instead of sending their own. Only a limited number of queries
+ * are in flight, the others wait in a queue. A ver whose answer failed
+ * verification is not asked for again until its entry expires.
+ *
+ * Times are monotonic, in microseconds.
+ */
+
+typedef struct caps_request_t
+{
+    char* ver;
+    char* node;
+    char* id;
+    GSList* jids; // waiting for the result, the first one is queried
+    gint64 sent;  // time the query was sent, 0 while queued
+} CapsRequest;
+
+typedef enum {
+    CAPS_REQUEST_QUEUED,  // a new query was queued
+    CAPS_REQUEST_PENDING, // the JID waits on the query for the same ver
+    CAPS_REQUEST_FAILED   // the ver failed verification recently
+} caps_request_add_t;
+
+typedef struct caps_requests_t CapsRequests;
+
+CapsRequests* caps_requests_new(void);
+void caps_requests_free(CapsRequests* requests);
+caps_request_add_t caps_requests_add(CapsRequests* requests, const char* const jid, const char* const id,
+                                     const char* const node, const char* const ver, gint64 now);
+CapsRequest* caps_requests_get(CapsRequests* requests, const char* const ver);
+CapsRequest* caps_requests_next(CapsRequests* requests, guint max, gint64 timeout, gint64 now);
+CapsRequest* caps_requests_retry(CapsRequests* requests, const char* const ver, gint64 now);
+void caps_requests_done(CapsRequests* requests, const char* const ver);
+void caps_requests_fail(CapsRequests* requests, const char* const ver, gint64 until);
+guint caps_requests_active(CapsRequests* requests);
+
+#endif
@@ -72,6 +72,7 @@ typedef struct prof_conn_t
     GHashTable* available_resources;
     GHashTable* features_by_jid;
     GHashTable* requested_features;
+    GHashTable* stream_features; // namespaces of the last <stream:features> children
 } ProfConnection;
 
 typedef struct
@@ -85,6 +86,7 @@ static gchar* profanity_instance_id = NULL;
 static gchar* prof_identifier = NULL;
 
 static void _xmpp_file_logger(void* const userdata, const xmpp_log_level_t level, const char* const area, const char* const msg);
+static void _connection_stream_features_update(const char* const xml);
 
 static void _connection_handler(xmpp_conn_t* const xmpp_conn, const xmpp_conn_event_t status, const int error,
                                 xmpp_stream_error_t* const stream_error, void* const userdata);
@@ -138,6 +140,7 @@ connection_init(void)
     conn.domain = NULL;
     conn.jid = NULL;
     conn.features_by_jid = NULL;
+    conn.stream_features = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
     conn.available_resources = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)resource_destroy);
     conn.requested_features = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
 
@@ -168,6 +171,7 @@ connection_shutdown(void)
 {
     connection_clear_data();
     g_hash_table_destroy(conn.requested_features);
+    g_hash_table_destroy(conn.stream_features);
     g_hash_table_destroy(conn.available_resources);
     if (conn.xmpp_conn) {
         xmpp_conn_release(conn.xmpp_conn);
@@ -246,6 +250,7 @@ _conn_apply_settings(const char* const jid, const char* const passwd, const char
     }
 
     xmpp_conn_set_certfail_handler(conn.xmpp_conn, _connection_certfail_cb);
+    g_hash_table_remove_all(conn.stream_features);
     if (conn.sm_state) {
         if (xmpp_conn_set_sm_state(conn.xmpp_conn, conn.sm_state)) {
             log_warning("Had Stream Management state, but libstrophe didn't accept it");
@@ -650,6 +655,14 @@ connection_supports(const char* const feature)
     return ret;
 }
 
+// Whether the server announced a feature with the given namespace in its
+// last <stream:features>, like XEP-0237 roster versioning
+gboolean
+connection_has_stream_feature(const char* const ns)
+{
+    return g_hash_table_contains(conn.stream_features, ns);
+}
+
 const char*
 connection_jid_for_feature(const char* const feature)
 {
@@ -1117,9 +1130,44 @@ _xmpp_file_logger(void* const userdata, const xmpp_log_level_t xmpp_level, const
 
     if ((g_strcmp0(area, "xmpp") == 0) || (g_strcmp0(area, "conn")) == 0) {
         sv_ev_xmpp_stanza(msg);
+
+        // libstrophe negotiates the stream itself and calls no user handler
+        // before the resource is bound, the logged stanza is the only place
+        // the features after authentication show up
+        if (g_str_has_prefix(msg, "RECV: <stream:features") || g_str_has_prefix(msg, "RECV: <features")) {
+            _connection_stream_features_update(msg + strlen("RECV: "));
+        }
     }
 }
 
+static void
+_connection_stream_features_update(const char* const xml)
+{
+    // bind the prefix, the element may be rendered as <stream:features>
+    // or as <features xmlns='http://etherx.jabber.org/streams'>
+    auto_gchar gchar* wrapped = g_strdup_printf("<wrapper xmlns:stream='%s'>%s</wrapper>", XMPP_NS_STREAMS, xml);
+    xmpp_stanza_t* wrapper = xmpp_stanza_new_from_string(conn.xmpp_ctx, wrapped);
+    if (!wrapper) {
+        return;
+    }
+
+    xmpp_stanza_t* features = wrapper;
+    if (!g_str_has_suffix(xmpp_stanza_get_name(wrapper), "features")) {
+        features = xmpp_stanza_get_children(wrapper);
+    }
+
+    g_hash_table_remove_all(conn.stream_features);
+    xmpp_stanza_t* child = features ? xmpp_stanza_get_children(features) : NULL;
+    for (; child; child = xmpp_stanza_get_next(child)) {
+        const char* ns = xmpp_stanza_get_ns(child);
+        if (ns) {
+            g_hash_table_add(conn.stream_features, strdup(ns));
+        }
+    }
+
+    xmpp_stanza_release(wrapper);
+}
+
 static void
 _random_bytes_init(void)
 {
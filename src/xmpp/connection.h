@@ -60,6 +60,7 @@ const char* connection_get_domain(void);
 void connection_request_features(void);
 void connection_features_received(const char* const jid);
 GHashTable* connection_get_features(const char* const jid);
+gboolean connection_has_stream_feature(const char* const ns);
 
 void connection_clear_data(void);
 
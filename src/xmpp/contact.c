@@ -45,10 +45,12 @@
 #include "tools/autocomplete.h"
 #include "xmpp/resource.h"
 #include "xmpp/contact.h"
+#include "xmpp/jid.h"
 
 struct p_contact_t
 {
     char* barejid;
+    Jid* jid;
     gchar* barejid_collate_key;
     char* name;
     gchar* name_collate_key;
@@ -59,8 +61,12 @@ struct p_contact_t
     GDateTime* last_activity;
     GHashTable* available_resources;
     Autocomplete resource_ac;
+    guint version;
 };
 
+// shared by all contacts so a recreated contact never repeats a version
+static guint contact_version = 0;
+
 PContact
 p_contact_new(const char* const barejid, const char* const name,
               GSList* groups, const char* const subscription,
@@ -68,6 +74,7 @@ p_contact_new(const char* const barejid, const char* const name,
 {
     PContact contact = malloc(sizeof(struct p_contact_t));
     contact->barejid = strdup(barejid);
+    contact->jid = jid_create(barejid);
     contact->barejid_collate_key = g_utf8_collate_key(contact->barejid, -1);
 
     if (name) {
@@ -97,6 +104,7 @@ p_contact_new(const char* const barejid, const char* const name,
                                                          (GDestroyNotify)resource_destroy);
 
     contact->resource_ac = autocomplete_new();
+    contact->version = ++contact_version;
 
     return contact;
 }
@@ -110,6 +118,7 @@ p_contact_set_name(const PContact contact, const char* const name)
         contact->name = strdup(name);
         contact->name_collate_key = g_utf8_collate_key(contact->name, -1);
     }
+    contact->version = ++contact_version;
 }
 
 void
@@ -148,6 +157,7 @@ p_contact_remove_resource(PContact contact, const char* const resource)
 {
     gboolean result = g_hash_table_remove(contact->available_resources, resource);
     autocomplete_remove(contact->resource_ac, resource);
+    contact->version = ++contact_version;
 
     return result;
 }
@@ -157,6 +167,7 @@ p_contact_free(PContact contact)
 {
     if (contact) {
         free(contact->barejid);
+        jid_destroy(contact->jid);
         free(contact->barejid_collate_key);
         free(contact->name);
         free(contact->name_collate_key);
@@ -183,6 +194,13 @@ p_contact_barejid(const PContact contact)
     return contact->barejid;
 }
 
+// Held for the lifetime of the contact, NULL if barejid isn't a valid JID
+Jid*
+p_contact_jid(const PContact contact)
+{
+    return contact->jid;
+}
+
 const char*
 p_contact_barejid_collate_key(const PContact contact)
 {
@@ -399,11 +417,20 @@ p_contact_has_available_resource(const PContact contact)
     return (g_hash_table_size(contact->available_resources) > 0);
 }
 
+// Changes whenever anything shown for the contact in the roster panel does:
+// name, resources, their presence and status
+guint
+p_contact_version(const PContact contact)
+{
+    return contact->version;
+}
+
 void
 p_contact_set_presence(const PContact contact, Resource* resource)
 {
     g_hash_table_replace(contact->available_resources, strdup(resource->name), resource);
     autocomplete_add(contact->resource_ac, resource->name);
+    contact->version = ++contact_version;
 }
 
 void
@@ -439,9 +466,3 @@ p_contact_resource_ac(const PContact contact)
 {
     return contact->resource_ac;
 }
-
-void
-p_contact_resource_ac_reset(const PContact contact)
-{
-    autocomplete_reset(contact->resource_ac);
-}
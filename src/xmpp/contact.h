@@ -38,6 +38,7 @@
 
 #include "tools/autocomplete.h"
 #include "xmpp/resource.h"
+#include "xmpp/jid.h"
 
 typedef struct p_contact_t* PContact;
 
@@ -47,6 +48,7 @@ void p_contact_add_resource(PContact contact, Resource* resource);
 gboolean p_contact_remove_resource(PContact contact, const char* const resource);
 void p_contact_free(PContact contact);
 const char* p_contact_barejid(PContact contact);
+Jid* p_contact_jid(PContact contact);
 const char* p_contact_barejid_collate_key(PContact contact);
 const char* p_contact_name(PContact contact);
 const char* p_contact_name_collate_key(PContact contact);
@@ -57,6 +59,7 @@ const char* p_contact_subscription(const PContact contact);
 GList* p_contact_get_available_resources(const PContact contact);
 GDateTime* p_contact_last_activity(const PContact contact);
 gboolean p_contact_pending_out(const PContact contact);
+guint p_contact_version(const PContact contact);
 void p_contact_set_presence(const PContact contact, Resource* resource);
 void p_contact_set_status(const PContact contact, const char* const status);
 void p_contact_set_name(const PContact contact, const char* const name);
@@ -72,6 +75,5 @@ gboolean p_contact_in_group(const PContact contact, const char* const group);
 gboolean p_contact_subscribed(const PContact contact);
 char* p_contact_create_display_string(const PContact contact, const char* const resource);
 Autocomplete p_contact_resource_ac(const PContact contact);
-void p_contact_resource_ac_reset(const PContact contact);
 
 #endif
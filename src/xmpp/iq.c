@@ -39,6 +39,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 
 #include <strophe.h>
 
@@ -48,6 +49,7 @@
 #include "event/server_events.h"
 #include "plugins/plugins.h"
 #include "tools/http_upload.h"
+#include "tools/perf.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/xmpp.h"
@@ -55,6 +57,7 @@
 #include "xmpp/session.h"
 #include "xmpp/iq.h"
 #include "xmpp/capabilities.h"
+#include "xmpp/caps_requests.h"
 #include "xmpp/blocking.h"
 #include "xmpp/session.h"
 #include "xmpp/stanza.h"
@@ -63,6 +66,7 @@
 #include "xmpp/roster.h"
 #include "xmpp/muc.h"
 #include "src/database.h"
+#include "config/files.h"
 #include "ui/window.h"
 
 #ifdef HAVE_OMEMO
@@ -116,6 +120,54 @@ typedef struct late_delivery_userdata
     GDateTime* startdate;
 } LateDeliveryUserdata;
 
+typedef struct mam_sync_slice_t
+{
+    char* start;
+    char* end;               // NULL for the newest slice, open ended
+    char* after;             // RSM <last> of the previous page
+    gboolean after_from_db;  // resume point from the database, may be gone on the server
+    char* queryid;           // query in flight, NULL while queued
+    guint timeout_id;        // fails the query in flight if it gets no answer
+    GSList* results;         // messages of the page in flight, newest first
+} MamSyncSlice;
+
+typedef struct room_list_t
+{
+    GPtrArray* jids;     // rooms without a localpart are not listed
+    GPtrArray* names;    // NULL where the service gave no name
+    GString* index;      // lowercased "<localpart>\n<name>\n" of every room
+    GArray* index_start; // offset into index where each room starts
+    gint64 fetched;      // real time in seconds of the last complete fetch
+} RoomList;
+
+typedef struct room_list_fetch_t
+{
+    char* service;
+    RoomList* list;     // pages received so far
+    GPtrArray* filters; // filters of /rooms calls waiting for the result, may contain NULL
+    char* after;        // RSM <last> of the previous page
+    guint pages;        // pages requested so far
+} RoomListFetch;
+
+#define ROOM_LIST_PAGE_SIZE 500
+#define ROOM_LIST_MAX_PAGES 100
+
+// background archive sync: the range since the last synced message is split
+// into time slices, each paged on its own, MAM_SYNC_INFLIGHT at a time
+#define MAM_SYNC_INFLIGHT   4
+#define MAM_SYNC_PAGE_SIZE  100
+#define MAM_SYNC_SLICE      (6 * G_TIME_SPAN_HOUR)
+#define MAM_SYNC_MAX_SLICES 32
+// how far back the first sync into an empty database reaches
+#define MAM_SYNC_INITIAL (7 * G_TIME_SPAN_DAY)
+// seconds to wait for the answer to a page before giving up on its slice
+#define MAM_SYNC_TIMEOUT 60
+
+// in flight queries that got no answer in time stop counting against the limit
+#define CAPS_REQUEST_TIMEOUT (30 * G_USEC_PER_SEC)
+// ver strings that failed verification are not queried again for this long
+#define CAPS_FAILED_TTL (10 * 60 * G_USEC_PER_SEC)
+
 static int _iq_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata);
 
 static void _error_handler(xmpp_stanza_t* const stanza);
@@ -151,6 +203,7 @@ static int _room_list_id_handler(xmpp_stanza_t* const stanza, void* const userda
 static int _command_list_result_handler(xmpp_stanza_t* const stanza, void* const userdata);
 static int _command_exec_response_handler(xmpp_stanza_t* const stanza, void* const userdata);
 static int _mam_rsm_id_handler(xmpp_stanza_t* const stanza, void* const userdata);
+static int _mam_sync_id_handler(xmpp_stanza_t* const stanza, void* const userdata);
 static int _register_change_password_result_id_handler(xmpp_stanza_t* const stanza, void* const userdata);
 
 static void _iq_mam_request(ProfChatWin* win, GDateTime* startdate, GDateTime* enddate);
@@ -158,6 +211,18 @@ static void _iq_free_room_data(ProfRoomInfoData* roominfo);
 static void _iq_free_affiliation_set(ProfPrivilegeSet* affiliation_set);
 static void _iq_free_affiliation_list(ProfAffiliationList* affiliation_list);
 static void _iq_id_handler_free(ProfIqHandler* handler);
+static void _caps_request_send(CapsRequest* request);
+static void _caps_request_done(const char* const ver);
+static void _caps_requests_dispatch(void);
+static void _mam_sync_slice_free(MamSyncSlice* slice);
+static void _mam_sync_send(MamSyncSlice* slice);
+static void _mam_sync_dispatch(void);
+static void _mam_sync_stop(void);
+static gboolean _mam_sync_timeout(gpointer data);
+static void _room_list_free(RoomList* list);
+static void _room_list_fetch_free(RoomListFetch* fetch);
+static void _room_list_fetch_send(RoomListFetch* fetch, const char* const after);
+static void _room_list_show(const char* const service, RoomList* list, const char* const filter);
 
 // scheduled
 static int _autoping_timed_send(xmpp_conn_t* const conn, void* const userdata);
@@ -168,13 +233,21 @@ static void _item_destroy(DiscoItem* item);
 static gboolean autoping_wait = FALSE;
 static GTimer* autoping_time = NULL;
 static GHashTable* id_handlers;
-static GHashTable* rooms_cache = NULL;
+static GHashTable* rooms_cache = NULL;        // service -> RoomList, loaded from disk on first use
+static GHashTable* room_list_fetches = NULL;  // service -> RoomListFetch in progress
 static GSList* late_delivery_windows = NULL;
 static gboolean received_disco_items = FALSE;
+static CapsRequests* caps_requests = NULL;
+static GQueue* mam_sync_queued = NULL;
+static GHashTable* mam_sync_active = NULL;
+static GHashTable* mam_sync_expired = NULL; // ids of timed out queries, their late results are dropped
+static guint mam_sync_total = 0;
+static guint mam_sync_done = 0;
 
 static int
 _iq_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata)
 {
+    auto_perf ProfPerfTimer timer = perf_timer_start("xmpp.iq", NULL);
     log_debug("iq stanza handler fired");
     autoping_timer_extend();
 
@@ -225,7 +298,8 @@ _iq_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const us
     if (roster && (g_strcmp0(type, STANZA_TYPE_SET) == 0)) {
         roster_set_handler(stanza);
     }
-    if (roster && (g_strcmp0(type, STANZA_TYPE_RESULT) == 0)) {
+    // an empty roster result means our cached roster is current (XEP-0237)
+    if ((roster || g_strcmp0(xmpp_stanza_get_id(stanza), "roster") == 0) && (g_strcmp0(type, STANZA_TYPE_RESULT) == 0)) {
         roster_result_handler(stanza);
     }
 
@@ -261,11 +335,15 @@ iq_handlers_init(void)
     }
     received_disco_items = FALSE;
 
-    iq_rooms_cache_clear();
     iq_handlers_clear();
 
     id_handlers = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_iq_id_handler_free);
-    rooms_cache = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)xmpp_stanza_release);
+    rooms_cache = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_room_list_free);
+    room_list_fetches = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)_room_list_fetch_free);
+    caps_requests = caps_requests_new();
+    mam_sync_queued = g_queue_new();
+    mam_sync_active = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)_mam_sync_slice_free);
+    mam_sync_expired = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
 }
 
 struct iq_win_finder
@@ -324,6 +402,17 @@ iq_handlers_clear(void)
         g_hash_table_destroy(id_handlers);
         id_handlers = NULL;
     }
+    caps_requests_free(caps_requests);
+    caps_requests = NULL;
+    _mam_sync_stop();
+    if (room_list_fetches) {
+        g_hash_table_destroy(room_list_fetches);
+        room_list_fetches = NULL;
+    }
+    if (rooms_cache) {
+        g_hash_table_destroy(rooms_cache);
+        rooms_cache = NULL;
+    }
 }
 
 static void
@@ -338,6 +427,52 @@ _iq_id_handler_free(ProfIqHandler* handler)
     free(handler);
 }
 
+static void
+_caps_request_send(CapsRequest* request)
+{
+    xmpp_ctx_t* const ctx = connection_get_ctx();
+    const char* to = request->jids->data;
+
+    auto_gchar gchar* node_str = g_strdup_printf("%s#%s", request->node, request->ver);
+    xmpp_stanza_t* iq = stanza_create_disco_info_iq(ctx, request->id, to, node_str);
+
+    iq_id_handler_add(request->id, _caps_response_id_handler, free, strdup(request->ver));
+
+    iq_send_stanza(iq);
+    xmpp_stanza_release(iq);
+}
+
+// the queried entity could not answer, ask the next one waiting for the same ver
+static void
+_caps_request_retry(const char* const ver)
+{
+    CapsRequest* request = caps_requests_retry(caps_requests, ver, g_get_monotonic_time());
+    if (request == NULL) {
+        _caps_requests_dispatch();
+        return;
+    }
+
+    free(request->id);
+    request->id = connection_create_stanza_id();
+    _caps_request_send(request);
+}
+
+static void
+_caps_request_done(const char* const ver)
+{
+    caps_requests_done(caps_requests, ver);
+    _caps_requests_dispatch();
+}
+
+static void
+_caps_requests_dispatch(void)
+{
+    CapsRequest* request;
+    while ((request = caps_requests_next(caps_requests, prefs_get_caps_requests_max(), CAPS_REQUEST_TIMEOUT, g_get_monotonic_time()))) {
+        _caps_request_send(request);
+    }
+}
+
 void
 iq_id_handler_add(const char* const id, ProfIqCallback func, ProfIqFreeCallback free_func, void* userdata)
 {
@@ -406,35 +541,221 @@ iq_set_autoping(const int seconds)
     xmpp_timed_handler_add(conn, _autoping_timed_send, millis, ctx);
 }
 
+static RoomList*
+_room_list_new(void)
+{
+    RoomList* list = malloc(sizeof(RoomList));
+    list->jids = g_ptr_array_new_with_free_func(g_free);
+    list->names = g_ptr_array_new_with_free_func(g_free);
+    list->index = g_string_new(NULL);
+    list->index_start = g_array_new(FALSE, FALSE, sizeof(gsize));
+    list->fetched = 0;
+
+    return list;
+}
+
+static void
+_room_list_free(RoomList* list)
+{
+    if (list == NULL) {
+        return;
+    }
+    g_ptr_array_free(list->jids, TRUE);
+    g_ptr_array_free(list->names, TRUE);
+    g_string_free(list->index, TRUE);
+    g_array_free(list->index_start, TRUE);
+    free(list);
+}
+
+static void
+_room_list_add(RoomList* list, const char* const jid, const char* const name)
+{
+    const char* at = strchr(jid, '@');
+    if (at == NULL || at == jid) {
+        return;
+    }
+
+    g_ptr_array_add(list->jids, g_strdup(jid));
+    g_ptr_array_add(list->names, g_strdup(name));
+
+    auto_gchar gchar* localpart_lower = g_utf8_strdown(jid, at - jid);
+    g_array_append_val(list->index_start, list->index->len);
+    g_string_append(list->index, localpart_lower);
+    g_string_append_c(list->index, '\n');
+    if (name) {
+        auto_gchar gchar* name_lower = g_utf8_strdown(name, -1);
+        // newlines separate the index entries
+        g_strdelimit(name_lower, "\n", ' ');
+        g_string_append(list->index, name_lower);
+    }
+    g_string_append_c(list->index, '\n');
+}
+
+// index of the room whose index entry contains offset
+static guint
+_room_list_index_lookup(RoomList* list, gsize offset)
+{
+    guint lo = 0;
+    guint hi = list->index_start->len;
+    while (hi - lo > 1) {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index(list->index_start, gsize, mid) <= offset) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static gchar*
+_room_list_cache_file(const char* const service)
+{
+    auto_char char* filename = str_replace(service, "/", "_slash_");
+    return files_file_in_account_data_path(DIR_ROOMS, connection_get_barejid(), filename);
+}
+
+// One room per line, "<jid>\t<name>", after a first line holding the fetch time
+static void
+_room_list_save(const char* const service, RoomList* list)
+{
+    auto_gchar gchar* filename = _room_list_cache_file(service);
+    if (!filename) {
+        return;
+    }
+
+    GString* contents = g_string_sized_new(list->index->len * 2);
+    g_string_append_printf(contents, "%" G_GINT64_FORMAT "\n", list->fetched);
+    for (guint i = 0; i < list->jids->len; i++) {
+        g_string_append(contents, g_ptr_array_index(list->jids, i));
+        const char* name = g_ptr_array_index(list->names, i);
+        if (name) {
+            auto_gchar gchar* name_flat = g_strdup(name);
+            g_strdelimit(name_flat, "\t\n", ' ');
+            g_string_append_c(contents, '\t');
+            g_string_append(contents, name_flat);
+        }
+        g_string_append_c(contents, '\n');
+    }
+
+    GError* err = NULL;
+    if (!g_file_set_contents(filename, contents->str, contents->len, &err)) {
+        log_error("Unable to save room list cache %s: %s", filename, err->message);
+        g_error_free(err);
+    }
+    g_string_free(contents, TRUE);
+}
+
+static RoomList*
+_room_list_load(const char* const service)
+{
+    auto_gchar gchar* filename = _room_list_cache_file(service);
+    auto_gchar gchar* contents = NULL;
+    if (!filename || !g_file_get_contents(filename, &contents, NULL, NULL)) {
+        return NULL;
+    }
+
+    char* line = contents;
+    char* end = strchr(line, '\n');
+    if (end == NULL) {
+        return NULL;
+    }
+    *end = '\0';
+
+    RoomList* list = _room_list_new();
+    list->fetched = g_ascii_strtoll(line, NULL, 10);
+
+    for (line = end + 1; *line != '\0'; line = end + 1) {
+        end = strchr(line, '\n');
+        if (end == NULL) {
+            break;
+        }
+        *end = '\0';
+
+        char* name = strchr(line, '\t');
+        if (name) {
+            *name++ = '\0';
+        }
+        _room_list_add(list, line, name);
+    }
+
+    log_debug("Room list for %s loaded from cache, %u rooms", service, list->jids->len);
+
+    return list;
+}
+
+static gboolean
+_room_list_expired(RoomList* list)
+{
+    return g_get_real_time() / G_USEC_PER_SEC - list->fetched >= prefs_get_rooms_cache_ttl();
+}
+
 void
 iq_rooms_cache_clear(void)
 {
     if (rooms_cache) {
         g_hash_table_remove_all(rooms_cache);
-        g_hash_table_destroy(rooms_cache);
-        rooms_cache = NULL;
+    }
+
+    auto_gchar gchar* dirname = files_file_in_account_data_path(DIR_ROOMS, connection_get_barejid(), NULL);
+    GDir* dir = dirname ? g_dir_open(dirname, 0, NULL) : NULL;
+    if (dir) {
+        const gchar* name;
+        while ((name = g_dir_read_name(dir))) {
+            auto_gchar gchar* filename = g_build_filename(dirname, name, NULL);
+            g_remove(filename);
+        }
+        g_dir_close(dir);
     }
 }
 
 void
 iq_room_list_request(const char* conferencejid, char* filter)
 {
-    if (g_hash_table_contains(rooms_cache, conferencejid)) {
+    gboolean use_cache = prefs_get_boolean(PREF_ROOM_LIST_CACHE);
+    RoomList* list = NULL;
+
+    if (use_cache) {
+        list = g_hash_table_lookup(rooms_cache, conferencejid);
+        if (!list) {
+            list = _room_list_load(conferencejid);
+            if (list) {
+                g_hash_table_insert(rooms_cache, strdup(conferencejid), list);
+            }
+        }
+    }
+
+    RoomListFetch* fetch = g_hash_table_lookup(room_list_fetches, conferencejid);
+
+    if (list) {
         log_debug("Rooms request cached for: %s", conferencejid);
-        _room_list_id_handler(g_hash_table_lookup(rooms_cache, conferencejid), filter);
+        _room_list_show(conferencejid, list, filter);
+
+        // show what we have and refresh a stale list in the background
+        if (!_room_list_expired(list) || fetch) {
+            return;
+        }
+    } else if (fetch) {
+        // the same service is already being fetched, wait for it
+        g_ptr_array_add(fetch->filters, g_strdup(filter));
         return;
     }
 
     log_debug("Rooms request not cached for: %s", conferencejid);
 
-    xmpp_ctx_t* const ctx = connection_get_ctx();
-    char* id = connection_create_stanza_id();
-    xmpp_stanza_t* iq = stanza_create_disco_items_iq(ctx, id, conferencejid, NULL);
-
-    iq_id_handler_add(id, _room_list_id_handler, NULL, filter);
+    fetch = malloc(sizeof(RoomListFetch));
+    fetch->service = strdup(conferencejid);
+    fetch->list = _room_list_new();
+    fetch->filters = g_ptr_array_new_with_free_func(g_free);
+    fetch->after = NULL;
+    fetch->pages = 1;
+    if (!list) {
+        g_ptr_array_add(fetch->filters, g_strdup(filter));
+    }
+    g_hash_table_insert(room_list_fetches, fetch->service, fetch);
 
-    iq_send_stanza(iq);
-    xmpp_stanza_release(iq);
+    _room_list_fetch_send(fetch, NULL);
 }
 
 void
@@ -571,8 +892,6 @@ void
 iq_send_caps_request(const char* const to, const char* const id,
                      const char* const node, const char* const ver)
 {
-    xmpp_ctx_t* const ctx = connection_get_ctx();
-
     if (!node) {
         log_error("Could not create caps request, no node");
         return;
@@ -582,15 +901,18 @@ iq_send_caps_request(const char* const to, const char* const id,
         return;
     }
 
-    GString* node_str = g_string_new("");
-    g_string_printf(node_str, "%s#%s", node, ver);
-    xmpp_stanza_t* iq = stanza_create_disco_info_iq(ctx, id, to, node_str->str);
-    g_string_free(node_str, TRUE);
-
-    iq_id_handler_add(id, _caps_response_id_handler, NULL, NULL);
-
-    iq_send_stanza(iq);
-    xmpp_stanza_release(iq);
+    // many occupants of a room usually share a few client versions, ask only once per ver
+    switch (caps_requests_add(caps_requests, to, id, node, ver, g_get_monotonic_time())) {
+    case CAPS_REQUEST_FAILED:
+        log_debug("Capabilities %s failed verification recently, not querying %s", ver, to);
+        break;
+    case CAPS_REQUEST_PENDING:
+        log_debug("Capabilities request for %s already pending, adding %s", ver, to);
+        break;
+    case CAPS_REQUEST_QUEUED:
+        _caps_requests_dispatch();
+        break;
+    }
 }
 
 void
@@ -881,6 +1203,7 @@ _error_handler(xmpp_stanza_t* const stanza)
 static int
 _caps_response_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
 {
+    const char* ver = (char*)userdata;
     const char* id = xmpp_stanza_get_id(stanza);
     xmpp_stanza_t* query = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_QUERY);
 
@@ -899,24 +1222,28 @@ _caps_response_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
     const char* from = xmpp_stanza_get_from(stanza);
     if (!from) {
         log_info("_caps_response_id_handler(): No from attribute");
+        _caps_request_retry(ver);
         return 0;
     }
 
-    // handle error responses
+    // handle error responses, the entity may just have gone offline, ask the next one
     if (g_strcmp0(type, STANZA_TYPE_ERROR) == 0) {
         auto_char char* error_message = stanza_get_error_message(stanza);
-        log_warning("Error received for capabilities response from %s: ", from, error_message);
+        log_warning("Error received for capabilities response from %s: %s", from, error_message);
+        _caps_request_retry(ver);
         return 0;
     }
 
     if (query == NULL) {
         log_info("_caps_response_id_handler(): No query element found.");
+        _caps_request_retry(ver);
         return 0;
     }
 
     const char* node = xmpp_stanza_get_attribute(query, STANZA_ATTR_NODE);
     if (node == NULL) {
         log_info("_caps_response_id_handler(): No node attribute found");
+        _caps_request_retry(ver);
         return 0;
     }
 
@@ -925,25 +1252,36 @@ _caps_response_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
     char* given_sha1 = split[1];
     auto_gchar gchar* generated_sha1 = stanza_create_caps_sha1_from_query(query);
 
-    if (g_strcmp0(given_sha1, generated_sha1) != 0) {
+    if (g_strcmp0(given_sha1, generated_sha1) != 0 || g_strcmp0(given_sha1, ver) != 0) {
         log_warning("Generated sha-1 does not match given:");
         log_warning("Generated : %s", generated_sha1);
         log_warning("Given     : %s", given_sha1);
+        caps_requests_fail(caps_requests, ver, g_get_monotonic_time() + CAPS_FAILED_TTL);
+        _caps_requests_dispatch();
+        return 0;
+    }
+
+    log_debug("Valid SHA-1 hash found: %s", given_sha1);
+
+    if (caps_cache_contains(given_sha1)) {
+        log_debug("Capabilities already cached: %s", given_sha1);
     } else {
-        log_debug("Valid SHA-1 hash found: %s", given_sha1);
+        log_debug("Capabilities not cached: %s, storing", given_sha1);
+        EntityCapabilities* capabilities = stanza_create_caps_from_query_element(query);
 
-        if (caps_cache_contains(given_sha1)) {
-            log_debug("Capabilities already cached: %s", given_sha1);
-        } else {
-            log_debug("Capabilities not cached: %s, storing", given_sha1);
-            EntityCapabilities* capabilities = stanza_create_caps_from_query_element(query);
+        caps_add_by_ver(given_sha1, capabilities);
+        caps_destroy(capabilities);
+    }
 
-            caps_add_by_ver(given_sha1, capabilities);
-            caps_destroy(capabilities);
-        }
+    caps_map_jid_to_ver(from, given_sha1);
 
-        caps_map_jid_to_ver(from, given_sha1);
+    CapsRequest* request = caps_requests_get(caps_requests, ver);
+    if (request) {
+        for (GSList* curr = request->jids; curr; curr = g_slist_next(curr)) {
+            caps_map_jid_to_ver(curr->data, given_sha1);
+        }
     }
+    _caps_request_done(ver);
 
     return 0;
 }
@@ -1075,89 +1413,146 @@ _caps_response_legacy_id_handler(xmpp_stanza_t* const stanza, void* const userda
     return 0;
 }
 
-static int
-_room_list_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
+static void
+_room_list_fetch_free(RoomListFetch* fetch)
 {
-    const char* filter = userdata;
-    const char* id = xmpp_stanza_get_id(stanza);
-    const char* from = xmpp_stanza_get_from(stanza);
-
-    if (prefs_get_boolean(PREF_ROOM_LIST_CACHE) && !g_hash_table_contains(rooms_cache, from)) {
-        g_hash_table_insert(rooms_cache, strdup(from), xmpp_stanza_copy(stanza));
+    if (fetch == NULL) {
+        return;
     }
+    free(fetch->service);
+    _room_list_free(fetch->list);
+    g_ptr_array_free(fetch->filters, TRUE);
+    free(fetch->after);
+    free(fetch);
+}
 
-    log_debug("Response to query: %s", id);
+static void
+_room_list_fetch_send(RoomListFetch* fetch, const char* const after)
+{
+    xmpp_ctx_t* const ctx = connection_get_ctx();
+    auto_char char* id = connection_create_stanza_id();
+    xmpp_stanza_t* iq = stanza_create_disco_items_page_iq(ctx, id, fetch->service, after, ROOM_LIST_PAGE_SIZE);
 
-    xmpp_stanza_t* query = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_QUERY);
-    if (query == NULL) {
-        return 0;
-    }
+    iq_id_handler_add(id, _room_list_id_handler, NULL, fetch);
 
+    iq_send_stanza(iq);
+    xmpp_stanza_release(iq);
+}
+
+static void
+_room_list_show(const char* const service, RoomList* list, const char* const filter)
+{
     cons_show("");
     if (filter) {
-        cons_show("Rooms list response received: %s, filter: %s", from, filter);
+        cons_show("Rooms list response received: %s, filter: %s", service, filter);
     } else {
-        cons_show("Rooms list response received: %s", from);
+        cons_show("Rooms list response received: %s", service);
     }
-    xmpp_stanza_t* child = xmpp_stanza_get_children(query);
-    if (child == NULL) {
+    if (list->jids->len == 0) {
         cons_show("  No rooms found.");
+        return;
+    }
+
+    auto_gchar gchar* filter_lower = filter ? g_utf8_strdown(filter, -1) : NULL;
+    gboolean matched = FALSE;
+    guint i = 0;
+
+    while (i < list->jids->len) {
+        if (filter_lower) {
+            // one pass over the index instead of one match per room
+            const char* hit = strstr(list->index->str + g_array_index(list->index_start, gsize, i), filter_lower);
+            if (hit == NULL) {
+                break;
+            }
+            i = _room_list_index_lookup(list, hit - list->index->str);
+            matched = TRUE;
+        }
+
+        const char* name = g_ptr_array_index(list->names, i);
+        if (name) {
+            cons_show("  %s (%s)", (char*)g_ptr_array_index(list->jids, i), name);
+        } else {
+            cons_show("  %s", (char*)g_ptr_array_index(list->jids, i));
+        }
+        i++;
+    }
+
+    if (filter && matched == FALSE) {
+        cons_show("  No rooms found matching filter: %s", filter);
+    }
+}
+
+static int
+_room_list_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
+{
+    RoomListFetch* fetch = userdata;
+    const char* id = xmpp_stanza_get_id(stanza);
+
+    log_debug("Response to query: %s", id);
+
+    // a failed page fails the whole fetch, any older cached list is kept
+    gboolean is_error = g_strcmp0(xmpp_stanza_get_type(stanza), STANZA_TYPE_ERROR) == 0;
+    xmpp_stanza_t* query = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_QUERY);
+    if (is_error || query == NULL) {
+        auto_char char* error_message = is_error ? stanza_get_error_message(stanza) : strdup("no query in response");
+        log_debug("Rooms list request failed for %s: %s", fetch->service, error_message);
+        if (fetch->filters->len > 0) {
+            cons_show_error("Rooms list request failed for %s: %s", fetch->service, error_message);
+        }
+        g_hash_table_remove(room_list_fetches, fetch->service);
         return 0;
     }
 
-    GPatternSpec* glob = NULL;
-    if (filter != NULL) {
-        gchar* filter_lower = g_utf8_strdown(filter, -1);
-        GString* glob_str = g_string_new("*");
-        g_string_append(glob_str, filter_lower);
-        g_string_append(glob_str, "*");
-        glob = g_pattern_spec_new(glob_str->str);
-        g_string_free(glob_str, TRUE);
+    // services without RSM support answer with the whole list at once
+    xmpp_stanza_t* set = xmpp_stanza_get_child_by_name_and_ns(query, "set", STANZA_NS_RSM);
+    xmpp_stanza_t* last_st = set ? xmpp_stanza_get_child_by_name(set, STANZA_NAME_LAST) : NULL;
+    auto_char char* last = last_st ? xmpp_stanza_get_text(last_st) : NULL;
+
+    // a service that ignores <after> sends the same page again
+    gboolean repeated = last && g_strcmp0(last, fetch->after) == 0;
+    if (repeated) {
+        log_warning("Rooms list of %s repeats the page after %s, stopping", fetch->service, last);
     }
 
-    gboolean matched = FALSE;
-    while (child) {
-        const char* stanza_name = xmpp_stanza_get_name(child);
-        if (stanza_name && (g_strcmp0(stanza_name, STANZA_NAME_ITEM) == 0)) {
+    guint received = 0;
+    for (xmpp_stanza_t* child = xmpp_stanza_get_children(query); child && !repeated; child = xmpp_stanza_get_next(child)) {
+        if (g_strcmp0(xmpp_stanza_get_name(child), STANZA_NAME_ITEM) == 0) {
             const char* item_jid = xmpp_stanza_get_attribute(child, STANZA_ATTR_JID);
-            auto_gchar gchar* item_jid_lower = NULL;
             if (item_jid) {
-                auto_jid Jid* jidp = jid_create(item_jid);
-                if (jidp && jidp->localpart) {
-                    item_jid_lower = g_utf8_strdown(jidp->localpart, -1);
-                }
-            }
-            const char* item_name = xmpp_stanza_get_attribute(child, STANZA_ATTR_NAME);
-            auto_gchar gchar* item_name_lower = NULL;
-            if (item_name) {
-                item_name_lower = g_utf8_strdown(item_name, -1);
+                _room_list_add(fetch->list, item_jid, xmpp_stanza_get_attribute(child, STANZA_ATTR_NAME));
+                received++;
             }
-            if ((item_jid_lower) && ((glob == NULL) || ((g_pattern_match(glob, strlen(item_jid_lower), item_jid_lower, NULL)) || (item_name_lower && g_pattern_match(glob, strlen(item_name_lower), item_name_lower, NULL))))) {
+        }
+    }
 
-                if (glob) {
-                    matched = TRUE;
-                }
-                GString* item = g_string_new(item_jid);
-                if (item_name) {
-                    g_string_append(item, " (");
-                    g_string_append(item, item_name);
-                    g_string_append(item, ")");
-                }
-                cons_show("  %s", item->str);
-                g_string_free(item, TRUE);
-            }
+    if (last && received > 0) {
+        if (fetch->pages < ROOM_LIST_MAX_PAGES) {
+            free(fetch->after);
+            fetch->after = strdup(last);
+            fetch->pages++;
+            _room_list_fetch_send(fetch, last);
+            return 0;
         }
-        child = xmpp_stanza_get_next(child);
+        log_warning("Rooms list of %s has more than %d pages, keeping the first ones", fetch->service, ROOM_LIST_MAX_PAGES);
     }
 
-    if (glob && matched == FALSE) {
-        cons_show("  No rooms found matching filter: %s", filter);
+    RoomList* list = fetch->list;
+    fetch->list = NULL;
+    list->fetched = g_get_real_time() / G_USEC_PER_SEC;
+
+    for (guint i = 0; i < fetch->filters->len; i++) {
+        _room_list_show(fetch->service, list, g_ptr_array_index(fetch->filters, i));
     }
 
-    if (glob) {
-        g_pattern_spec_free(glob);
+    if (prefs_get_boolean(PREF_ROOM_LIST_CACHE)) {
+        _room_list_save(fetch->service, list);
+        g_hash_table_replace(rooms_cache, strdup(fetch->service), list);
+    } else {
+        _room_list_free(list);
     }
 
+    g_hash_table_remove(room_list_fetches, fetch->service);
+
     return 0;
 }
 
@@ -1633,7 +2028,7 @@ _version_get_handler(xmpp_stanza_t* const stanza)
     xmpp_ctx_t* const ctx = connection_get_ctx();
     const char* id = xmpp_stanza_get_id(stanza);
     const char* from = xmpp_stanza_get_from(stanza);
-    ProfAccount* account = accounts_get_account(session_get_account_name());
+    ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
     auto_char char* client = account->client != NULL ? strdup(account->client) : NULL;
     account_free(account);
     bool is_custom_client = client != NULL;
@@ -2479,8 +2874,7 @@ _http_upload_response_id_handler(xmpp_stanza_t* const stanza, void* const userda
                 }
             }
 
-            pthread_create(&(upload->worker), NULL, &http_file_put, upload);
-            http_upload_add_upload(upload);
+            http_file_put(upload);
         } else {
             log_error("Invalid XML in HTTP Upload slot");
             return 1;
@@ -2638,7 +3032,7 @@ iq_mam_request_older(ProfChatWin* win)
     }
 
     xmpp_ctx_t* const ctx = connection_get_ctx();
-    xmpp_stanza_t* iq = stanza_create_mam_iq(ctx, win->barejid, NULL, enddate, firstid, NULL);
+    xmpp_stanza_t* iq = stanza_create_mam_iq(ctx, win->barejid, NULL, enddate, firstid, NULL, MESSAGES_TO_RETRIEVE);
     iq_id_handler_add(xmpp_stanza_get_id(iq), _mam_buffer_commit_handler, NULL, win);
 
     message_free(first_msg);
@@ -2694,7 +3088,7 @@ _iq_mam_request(ProfChatWin* win, GDateTime* startdate, GDateTime* enddate)
 
     xmpp_ctx_t* const ctx = connection_get_ctx();
 
-    xmpp_stanza_t* iq = stanza_create_mam_iq(ctx, win->barejid, startdate_str, enddate_str, firstid, NULL);
+    xmpp_stanza_t* iq = stanza_create_mam_iq(ctx, win->barejid, startdate_str, enddate_str, firstid, NULL, MESSAGES_TO_RETRIEVE);
 
     MamRsmUserdata* data = malloc(sizeof(MamRsmUserdata));
     if (data) {
@@ -2793,7 +3187,7 @@ _mam_rsm_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
                         free(data->end_datestr);
                         data->end_datestr = NULL;
                     }
-                    xmpp_stanza_t* iq = stanza_create_mam_iq(ctx, data->barejid, data->start_datestr, NULL, firstid, NULL);
+                    xmpp_stanza_t* iq = stanza_create_mam_iq(ctx, data->barejid, data->start_datestr, NULL, firstid, NULL, MESSAGES_TO_RETRIEVE);
 
                     MamRsmUserdata* ndata = malloc(sizeof(*ndata));
                     *ndata = *data;
@@ -2815,6 +3209,252 @@ _mam_rsm_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
     return 0;
 }
 
+void
+iq_mam_sync_start(void)
+{
+    if (!mam_sync_active || mam_sync_total > 0) {
+        return;
+    }
+    if (connection_supports(XMPP_FEATURE_MAM2) == FALSE) {
+        log_debug("Server doesn't advertise %s, skipping archive sync.", XMPP_FEATURE_MAM2);
+        return;
+    }
+    auto_gchar gchar* pref_dblog = prefs_get_string(PREF_DBLOG);
+    if (g_strcmp0(pref_dblog, "off") == 0) {
+        return;
+    }
+
+    ProfMessage* last = log_database_get_last_archived();
+    if (!last) {
+        // no database to sync into
+        return;
+    }
+
+    GDateTime* now = g_date_time_new_now_utc();
+    GDateTime* start = last->timestamp ? g_date_time_to_utc(last->timestamp) : g_date_time_add(now, -MAM_SYNC_INITIAL);
+    GTimeSpan range = MAX(g_date_time_difference(now, start), 0);
+    guint count = CLAMP(range / MAM_SYNC_SLICE + 1, 1, MAM_SYNC_MAX_SLICES);
+    GTimeSpan width = range / count;
+
+    for (guint i = 0; i < count; i++) {
+        MamSyncSlice* slice = calloc(1, sizeof(MamSyncSlice));
+        GDateTime* slice_start = g_date_time_add(start, width * i);
+        slice->start = g_date_time_format(slice_start, mam_timestamp_format_string);
+        g_date_time_unref(slice_start);
+        if (i + 1 < count) {
+            GDateTime* slice_end = g_date_time_add(start, width * (i + 1));
+            slice->end = g_date_time_format(slice_end, mam_timestamp_format_string);
+            g_date_time_unref(slice_end);
+        }
+        g_queue_push_tail(mam_sync_queued, slice);
+    }
+
+    // the first slice resumes right after the last message we synced
+    if (last->stanzaid) {
+        MamSyncSlice* first = g_queue_peek_head(mam_sync_queued);
+        first->after = strdup(last->stanzaid);
+        first->after_from_db = TRUE;
+    }
+
+    g_date_time_unref(start);
+    g_date_time_unref(now);
+    message_free(last);
+
+    mam_sync_total = count;
+    mam_sync_done = 0;
+    log_debug("Archive sync started, %u slices", count);
+
+    _mam_sync_dispatch();
+}
+
+gboolean
+iq_mam_sync_has_query(const char* const queryid)
+{
+    if (!mam_sync_active || !queryid) {
+        return FALSE;
+    }
+    return g_hash_table_contains(mam_sync_active, queryid) || g_hash_table_contains(mam_sync_expired, queryid);
+}
+
+// Hold a message of a sync page until the page is complete, it is then
+// stored with the rest of the page in one transaction
+void
+iq_mam_sync_add_result(const char* const queryid, ProfMessage* message)
+{
+    MamSyncSlice* slice = queryid && mam_sync_active ? g_hash_table_lookup(mam_sync_active, queryid) : NULL;
+    if (!slice) {
+        message_free(message);
+        return;
+    }
+    slice->results = g_slist_prepend(slice->results, message);
+}
+
+static void
+_mam_sync_slice_free(MamSyncSlice* slice)
+{
+    if (slice) {
+        free(slice->start);
+        free(slice->end);
+        free(slice->after);
+        free(slice->queryid);
+        if (slice->timeout_id) {
+            g_source_remove(slice->timeout_id);
+        }
+        g_slist_free_full(slice->results, (GDestroyNotify)message_free);
+        free(slice);
+    }
+}
+
+static void
+_mam_sync_store(MamSyncSlice* slice)
+{
+    if (!slice->results) {
+        return;
+    }
+
+    slice->results = g_slist_reverse(slice->results);
+    log_database_batch_begin();
+    for (GSList* curr = slice->results; curr; curr = g_slist_next(curr)) {
+        sv_ev_archived_message(curr->data);
+    }
+    log_database_batch_end();
+
+    g_slist_free_full(slice->results, (GDestroyNotify)message_free);
+    slice->results = NULL;
+}
+
+static void
+_mam_sync_send(MamSyncSlice* slice)
+{
+    xmpp_ctx_t* const ctx = connection_get_ctx();
+    xmpp_stanza_t* iq = stanza_create_mam_iq(ctx, NULL, slice->start, slice->end, NULL, slice->after, MAM_SYNC_PAGE_SIZE);
+    const char* id = xmpp_stanza_get_id(iq);
+
+    // the query id equals the iq id, see stanza_create_mam_iq()
+    slice->queryid = strdup(id);
+    g_hash_table_insert(mam_sync_active, slice->queryid, slice);
+    iq_id_handler_add(id, _mam_sync_id_handler, NULL, slice);
+    slice->timeout_id = g_timeout_add_seconds(MAM_SYNC_TIMEOUT, _mam_sync_timeout, slice);
+
+    iq_send_stanza(iq);
+    xmpp_stanza_release(iq);
+}
+
+// Keep MAM_SYNC_INFLIGHT queries going and update the progress
+static void
+_mam_sync_dispatch(void)
+{
+    while (g_hash_table_size(mam_sync_active) < MAM_SYNC_INFLIGHT && !g_queue_is_empty(mam_sync_queued)) {
+        _mam_sync_send(g_queue_pop_head(mam_sync_queued));
+    }
+
+    if (g_hash_table_size(mam_sync_active) == 0) {
+        log_debug("Archive sync finished, %u slices", mam_sync_total);
+        mam_sync_total = 0;
+        status_bar_clear_progress();
+        return;
+    }
+
+    auto_gchar gchar* progress = g_strdup_printf("MAM %u/%u", mam_sync_done, mam_sync_total);
+    status_bar_set_progress(progress);
+}
+
+static void
+_mam_sync_stop(void)
+{
+    if (mam_sync_total > 0) {
+        status_bar_clear_progress();
+        mam_sync_total = 0;
+    }
+    if (mam_sync_queued) {
+        g_queue_free_full(mam_sync_queued, (GDestroyNotify)_mam_sync_slice_free);
+        mam_sync_queued = NULL;
+    }
+    if (mam_sync_active) {
+        g_hash_table_destroy(mam_sync_active);
+        mam_sync_active = NULL;
+    }
+    if (mam_sync_expired) {
+        g_hash_table_destroy(mam_sync_expired);
+        mam_sync_expired = NULL;
+    }
+}
+
+// The server never answered the page, give up on the rest of its slice
+static gboolean
+_mam_sync_timeout(gpointer data)
+{
+    MamSyncSlice* slice = data;
+    slice->timeout_id = 0;
+
+    log_warning("Archive sync query %s timed out", slice->queryid);
+    g_hash_table_remove(id_handlers, slice->queryid);
+    g_hash_table_steal(mam_sync_active, slice->queryid);
+    g_hash_table_add(mam_sync_expired, slice->queryid);
+    slice->queryid = NULL;
+    _mam_sync_slice_free(slice);
+    mam_sync_done++;
+
+    _mam_sync_dispatch();
+    return G_SOURCE_REMOVE;
+}
+
+static int
+_mam_sync_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
+{
+    MamSyncSlice* slice = (MamSyncSlice*)userdata;
+
+    // the result messages of this page have all been received by now
+    g_hash_table_steal(mam_sync_active, slice->queryid);
+    free(slice->queryid);
+    slice->queryid = NULL;
+    g_source_remove(slice->timeout_id);
+    slice->timeout_id = 0;
+    _mam_sync_store(slice);
+
+    const char* type = xmpp_stanza_get_type(stanza);
+    if (g_strcmp0(type, "error") == 0) {
+        auto_char char* error_message = stanza_get_error_message(stanza);
+        if (slice->after_from_db) {
+            // the server may have expired the message we resume from
+            log_debug("Archive sync couldn't resume after %s: %s", slice->after, error_message);
+            free(slice->after);
+            slice->after = NULL;
+            slice->after_from_db = FALSE;
+            _mam_sync_send(slice);
+        } else {
+            log_warning("Archive sync error: %s", error_message);
+            _mam_sync_slice_free(slice);
+            mam_sync_done++;
+        }
+        _mam_sync_dispatch();
+        return 0;
+    }
+
+    char* last = NULL;
+    xmpp_stanza_t* fin = xmpp_stanza_get_child_by_name_and_ns(stanza, STANZA_NAME_FIN, STANZA_NS_MAM2);
+    if (fin && g_strcmp0(xmpp_stanza_get_attribute(fin, "complete"), "true") != 0) {
+        xmpp_stanza_t* set = xmpp_stanza_get_child_by_name_and_ns(fin, "set", STANZA_NS_RSM);
+        xmpp_stanza_t* last_st = set ? xmpp_stanza_get_child_by_name(set, STANZA_NAME_LAST) : NULL;
+        if (last_st) {
+            last = xmpp_stanza_get_text(last_st);
+        }
+    }
+
+    if (last) {
+        free(slice->after);
+        slice->after = last;
+        slice->after_from_db = FALSE;
+        _mam_sync_send(slice);
+    } else {
+        _mam_sync_slice_free(slice);
+        mam_sync_done++;
+    }
+
+    _mam_sync_dispatch();
+    return 0;
+}
+
 void
 iq_register_change_password(const char* const user, const char* const password)
 {
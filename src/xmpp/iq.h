@@ -41,6 +41,9 @@ typedef void (*ProfIqFreeCallback)(void* userdata);
 
 void iq_handlers_init(void);
 void iq_feature_retrieval_complete_handler(void);
+void iq_mam_sync_start(void);
+gboolean iq_mam_sync_has_query(const char* const queryid);
+void iq_mam_sync_add_result(const char* const queryid, ProfMessage* message);
 void iq_send_stanza(xmpp_stanza_t* const stanza);
 void iq_id_handler_add(const char* const id, ProfIqCallback func, ProfIqFreeCallback free_func, void* userdata);
 void iq_disco_info_request_onconnect(const char* jid);
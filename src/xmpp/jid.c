@@ -43,17 +43,73 @@
 #include "common.h"
 #include "xmpp/jid.h"
 
+// Every live Jid by the string it was parsed from. Equal strings share one
+// instance, and Jids with the same bare part share its barejid string.
+G_LOCK_DEFINE_STATIC(jids);
+static GHashTable* jids = NULL;
+
+static Jid* _jid_parse(const gchar* const str);
+static void _jid_free(Jid* jid);
+
 Jid*
 jid_create(const gchar* const str)
 {
-    Jid* result = NULL;
+    if (str == NULL) {
+        return NULL;
+    }
 
-    /* if str is NULL g_strdup returns NULL */
-    gchar* trimmed = g_strdup(str);
-    if (trimmed == NULL) {
+    G_LOCK(jids);
+    Jid* result = jids ? g_hash_table_lookup(jids, str) : NULL;
+    if (result) {
+        result->refcnt++;
+    }
+    G_UNLOCK(jids);
+
+    if (result) {
+        return result;
+    }
+
+    result = _jid_parse(str);
+    if (result == NULL) {
         return NULL;
     }
 
+    if (g_strcmp0(result->str, result->barejid) != 0) {
+        result->bare = jid_create(result->barejid);
+        if (result->bare) {
+            g_free(result->barejid);
+            result->barejid = result->bare->barejid;
+        }
+    }
+
+    G_LOCK(jids);
+    if (jids == NULL) {
+        jids = g_hash_table_new(g_str_hash, g_str_equal);
+    }
+    // another thread may have got there first
+    Jid* existing = g_hash_table_lookup(jids, str);
+    if (existing) {
+        existing->refcnt++;
+    } else {
+        g_hash_table_insert(jids, result->str, result);
+    }
+    G_UNLOCK(jids);
+
+    if (existing) {
+        _jid_free(result);
+        return existing;
+    }
+
+    return result;
+}
+
+static Jid*
+_jid_parse(const gchar* const str)
+{
+    Jid* result = NULL;
+
+    gchar* trimmed = g_strdup(str);
+
     if (strlen(trimmed) == 0) {
         g_free(trimmed);
         return NULL;
@@ -76,6 +132,7 @@ jid_create(const gchar* const str)
     result->resourcepart = NULL;
     result->barejid = NULL;
     result->fulljid = NULL;
+    result->bare = NULL;
     result->refcnt = 1;
 
     gchar* atp = g_utf8_strchr(trimmed, -1, '@');
@@ -99,7 +156,8 @@ jid_create(const gchar* const str)
     }
 
     if (result->domainpart == NULL) {
-        jid_destroy(result);
+        g_free(trimmed);
+        _jid_free(result);
         return NULL;
     }
 
@@ -123,10 +181,20 @@ jid_auto_destroy(Jid** jid)
     jid_destroy(*jid);
 }
 
+// The shared Jid of the lowercased bare part, the same instance for every Jid
+// of that contact as long as one of them is alive. No reference is taken.
+Jid*
+jid_bare(Jid* jid)
+{
+    return jid->bare ? jid->bare : jid;
+}
+
 void
 jid_ref(Jid* jid)
 {
+    G_LOCK(jids);
     jid->refcnt++;
+    G_UNLOCK(jids);
 }
 
 void
@@ -135,16 +203,33 @@ jid_destroy(Jid* jid)
     if (jid == NULL) {
         return;
     }
+
+    G_LOCK(jids);
     if (jid->refcnt > 1) {
         jid->refcnt--;
+        G_UNLOCK(jids);
         return;
     }
+    if (jids && g_hash_table_lookup(jids, jid->str) == jid) {
+        g_hash_table_remove(jids, jid->str);
+    }
+    G_UNLOCK(jids);
 
+    _jid_free(jid);
+}
+
+static void
+_jid_free(Jid* jid)
+{
     g_free(jid->str);
     g_free(jid->localpart);
     g_free(jid->domainpart);
     g_free(jid->resourcepart);
-    g_free(jid->barejid);
+    if (jid->bare) {
+        jid_destroy(jid->bare);
+    } else {
+        g_free(jid->barejid);
+    }
     g_free(jid->fulljid);
     free(jid);
 }
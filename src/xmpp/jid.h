@@ -47,14 +47,18 @@ struct jid_t
     char* resourcepart;
     char* barejid;
     char* fulljid;
+    struct jid_t* bare; // owns barejid when it isn't this one
 };
 
 typedef struct jid_t Jid;
 
+// Jids are shared: creating one from a string already in use returns the
+// existing instance with another reference. Treat them as read only.
 Jid* jid_create(const gchar* const str);
 Jid* jid_create_from_bare_and_resource(const char* const barejid, const char* const resource);
 void jid_destroy(Jid* jid);
 void jid_ref(Jid* jid);
+Jid* jid_bare(Jid* jid);
 
 void jid_auto_destroy(Jid** str);
 #define auto_jid __attribute__((__cleanup__(jid_auto_destroy)))
@@ -61,6 +61,7 @@
 #include "xmpp/xmpp.h"
 #include "xmpp/form.h"
 #include "xmpp/iq.h"
+#include "tools/perf.h"
 
 #ifdef HAVE_OMEMO
 #include "xmpp/omemo.h"
@@ -82,7 +83,7 @@ static void _handle_muc_private_message(xmpp_stanza_t* const stanza);
 static void _handle_conference(xmpp_stanza_t* const stanza);
 static void _handle_captcha(xmpp_stanza_t* const stanza);
 static void _handle_receipt_received(xmpp_stanza_t* const stanza);
-static void _handle_chat(xmpp_stanza_t* const stanza, gboolean is_mam, gboolean is_carbon, const char* result_id, GDateTime* timestamp);
+static void _handle_chat(xmpp_stanza_t* const stanza, gboolean is_mam, const char* sync_queryid, gboolean is_carbon, const char* result_id, GDateTime* timestamp);
 static void _handle_ox_chat(xmpp_stanza_t* const stanza, ProfMessage* message, gboolean is_mam);
 static xmpp_stanza_t* _handle_carbons(xmpp_stanza_t* const stanza);
 static void _send_message_stanza(xmpp_stanza_t* const stanza);
@@ -164,6 +165,7 @@ _handle_chat_states(xmpp_stanza_t* const stanza, Jid* const jid)
 static int
 _message_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata)
 {
+    auto_perf ProfPerfTimer timer = perf_timer_start("xmpp.message", NULL);
     log_debug("Message stanza handler fired");
     autoping_timer_extend();
 
@@ -274,7 +276,7 @@ _message_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* con
         }
 
         if (msg_stanza) {
-            _handle_chat(msg_stanza, FALSE, is_carbon, NULL, NULL);
+            _handle_chat(msg_stanza, FALSE, NULL, is_carbon, NULL, NULL);
         }
     } else {
         // none of the allowed types
@@ -366,6 +368,20 @@ message_init(void)
     return message;
 }
 
+// Moves the contents of message into a new one for who needs it after the
+// handler returned, message is left empty for the handler to free
+ProfMessage*
+message_move(ProfMessage* message)
+{
+    ProfMessage* moved = message_init();
+    ProfMessage empty = *moved;
+
+    *moved = *message;
+    *message = empty;
+
+    return moved;
+}
+
 void
 message_free(ProfMessage* message)
 {
@@ -477,7 +493,7 @@ message_send_chat_pgp(const char* const barejid, const char* const msg, gboolean
 
     xmpp_stanza_t* message = NULL;
 #ifdef HAVE_LIBGPGME
-    ProfAccount* account = accounts_get_account(session_get_account_name());
+    ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
     if (account->pgp_keyid) {
         auto_jid Jid* jidp = jid_create(jid);
         auto_char char* encrypted = p_gpg_encrypt(jidp->barejid, msg, account->pgp_keyid);
@@ -539,7 +555,7 @@ message_send_chat_ox(const char* const barejid, const char* const msg, gboolean
 
     xmpp_stanza_t* message = NULL;
 
-    ProfAccount* account = accounts_get_account(session_get_account_name());
+    ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
 
     message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
     xmpp_message_set_body(message, "This message is encrypted (XEP-0373: OpenPGP for XMPP).");
@@ -1344,7 +1360,7 @@ _handle_carbons(xmpp_stanza_t* const stanza)
 }
 
 static void
-_handle_chat(xmpp_stanza_t* const stanza, gboolean is_mam, gboolean is_carbon, const char* result_id, GDateTime* timestamp)
+_handle_chat(xmpp_stanza_t* const stanza, gboolean is_mam, const char* sync_queryid, gboolean is_carbon, const char* result_id, GDateTime* timestamp)
 {
     // some clients send the mucuser namespace with private messages
     // if the namespace exists, and the stanza contains a body element, assume its a private message
@@ -1457,6 +1473,12 @@ _handle_chat(xmpp_stanza_t* const stanza, gboolean is_mam, gboolean is_carbon, c
         _handle_ox_chat(stanza, message, FALSE);
     }
 
+    if (sync_queryid) {
+        // background archive sync, stored only once its page is complete
+        iq_mam_sync_add_result(sync_queryid, message);
+        return;
+    }
+
     if (message->plain || message->body || message->encrypted) {
         if (is_carbon) {
             // if we are the recipient, treat as standard incoming message
@@ -1544,7 +1566,10 @@ _handle_mam(xmpp_stanza_t* const stanza)
 
     xmpp_stanza_t* message_stanza = xmpp_stanza_get_child_by_ns(forwarded, "jabber:client");
 
-    _handle_chat(message_stanza, TRUE, FALSE, result_id, timestamp);
+    const char* queryid = xmpp_stanza_get_attribute(result, "queryid");
+    const char* sync_queryid = iq_mam_sync_has_query(queryid) ? queryid : NULL;
+
+    _handle_chat(message_stanza, TRUE, sync_queryid, FALSE, result_id, timestamp);
 
     return TRUE;
 }
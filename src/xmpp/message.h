@@ -42,6 +42,7 @@ typedef int (*ProfMessageCallback)(xmpp_stanza_t* const stanza, void* const user
 typedef void (*ProfMessageFreeCallback)(void* userdata);
 
 ProfMessage* message_init(void);
+ProfMessage* message_move(ProfMessage* message);
 void message_free(ProfMessage* message);
 void message_handlers_init(void);
 void message_handlers_clear(void);
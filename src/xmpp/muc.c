@@ -62,6 +62,7 @@ typedef struct _muc_room_t
     char* password;
     char* subject;
     char* autocomplete_prefix;
+    guint autocomplete_generation;
     gboolean pending_config;
     GList* pending_broadcasts;
     gboolean autojoin;
@@ -171,18 +172,6 @@ muc_invites_contain(const char* const room)
     return FALSE;
 }
 
-void
-muc_invites_reset_ac(void)
-{
-    autocomplete_reset(invite_ac);
-}
-
-void
-muc_confserver_reset_ac(void)
-{
-    autocomplete_reset(confservers_ac);
-}
-
 char*
 muc_invites_find(const char* const search_str, gboolean previous, void* context)
 {
@@ -219,6 +208,7 @@ muc_join(const char* const room, const char* const nick, const char* const passw
     new_room->role = MUC_ROLE_NONE;
     new_room->affiliation = MUC_AFFILIATION_NONE;
     new_room->autocomplete_prefix = NULL;
+    new_room->autocomplete_generation = autocomplete_generation();
     if (password) {
         new_room->password = strdup(password);
     } else {
@@ -721,6 +711,12 @@ muc_autocomplete(ProfWin* window, const char* const input, gboolean previous)
         return NULL;
     }
 
+    // the prefix belongs to the previous completion session
+    if (chat_room->autocomplete_generation != autocomplete_generation()) {
+        FREE_SET_NULL(chat_room->autocomplete_prefix);
+        chat_room->autocomplete_generation = autocomplete_generation();
+    }
+
     const char* search_str = NULL;
 
     gchar* last_space = g_strrstr(input, " ");
@@ -750,17 +746,6 @@ muc_autocomplete(ProfWin* window, const char* const input, gboolean previous)
     return g_string_free(replace_with, FALSE);
 }
 
-void
-muc_jid_autocomplete_reset(const char* const room)
-{
-    ChatRoom* chat_room = g_hash_table_lookup(rooms, room);
-    if (chat_room) {
-        if (chat_room->jid_ac) {
-            autocomplete_reset(chat_room->jid_ac);
-        }
-    }
-}
-
 void
 muc_jid_autocomplete_add_all(const char* const room, GSList* jids)
 {
@@ -782,22 +767,6 @@ muc_jid_autocomplete_add_all(const char* const room, GSList* jids)
     }
 }
 
-void
-muc_autocomplete_reset(const char* const room)
-{
-    ChatRoom* chat_room = g_hash_table_lookup(rooms, room);
-    if (chat_room) {
-        if (chat_room->nick_ac) {
-            autocomplete_reset(chat_room->nick_ac);
-        }
-
-        if (chat_room->autocomplete_prefix) {
-            free(chat_room->autocomplete_prefix);
-            chat_room->autocomplete_prefix = NULL;
-        }
-    }
-}
-
 char*
 muc_role_str(const char* const room)
 {
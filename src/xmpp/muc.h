@@ -111,7 +111,6 @@ void muc_roster_set_complete(const char* const room);
 GList* muc_roster(const char* const room);
 Autocomplete muc_roster_ac(const char* const room);
 Autocomplete muc_roster_jid_ac(const char* const room);
-void muc_jid_autocomplete_reset(const char* const room);
 void muc_jid_autocomplete_add_all(const char* const room, GSList* jids);
 
 Occupant* muc_roster_item(const char* const room, const char* const nick);
@@ -126,7 +125,6 @@ void muc_occupant_nick_change_start(const char* const room, const char* const ne
 char* muc_roster_nick_change_complete(const char* const room, const char* const nick);
 
 void muc_confserver_add(const char* const server);
-void muc_confserver_reset_ac(void);
 char* muc_confserver_find(const char* const search_str, gboolean previous, void* context);
 void muc_confserver_clear(void);
 
@@ -135,7 +133,6 @@ void muc_invites_remove(const char* const room);
 gint muc_invites_count(void);
 GList* muc_invites(void);
 gboolean muc_invites_contain(const char* const room);
-void muc_invites_reset_ac(void);
 char* muc_invites_find(const char* const search_str, gboolean previous, void* context);
 void muc_invites_clear(void);
 char* muc_invite_password(const char* const room);
@@ -147,7 +144,6 @@ void muc_pending_broadcasts_add(const char* const room, const char* const messag
 GList* muc_pending_broadcasts(const char* const room);
 
 char* muc_autocomplete(ProfWin* window, const char* const input, gboolean previous);
-void muc_autocomplete_reset(const char* const room);
 
 gboolean muc_requires_config(const char* const room);
 void muc_set_requires_config(const char* const room, gboolean val);
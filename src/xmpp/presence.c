@@ -47,9 +47,11 @@
 #include "profanity.h"
 #include "log.h"
 #include "common.h"
+#include "database.h"
 #include "config/preferences.h"
 #include "event/server_events.h"
 #include "plugins/plugins.h"
+#include "tools/perf.h"
 #include "ui/ui.h"
 #include "ui/window.h"
 #include "ui/window_list.h"
@@ -60,6 +62,10 @@
 #include "xmpp/iq.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/muc.h"
+#include "xmpp/message.h"
+
+// upper bound on the discussion history requested when joining a room
+#define MUC_HISTORY_MAX_STANZAS 50
 
 static Autocomplete sub_requests_ac;
 
@@ -72,6 +78,7 @@ static void _subscribed_handler(xmpp_stanza_t* const stanza);
 static void _unsubscribed_handler(xmpp_stanza_t* const stanza);
 static void _muc_user_handler(xmpp_stanza_t* const stanza);
 static void _available_handler(xmpp_stanza_t* const stanza);
+static gchar* _room_history_since(const char* const room);
 
 void _send_caps_request(char* node, char* caps_key, char* id, char* from);
 static void _send_room_presence(xmpp_stanza_t* presence);
@@ -184,12 +191,6 @@ presence_sub_request_exists(const char* const bare_jid)
     return result;
 }
 
-void
-presence_reset_sub_request_search(void)
-{
-    autocomplete_reset(sub_requests_ac);
-}
-
 void
 presence_send(const resource_presence_t presence_type, const int idle, char* signed_status)
 {
@@ -291,8 +292,10 @@ presence_join_room(const char* const room, const char* const nick, const char* c
     const char* status = connection_get_presence_msg();
     int pri = accounts_get_priority_for_presence_type(session_get_account_name(), presence_type);
 
+    auto_gchar gchar* since = _room_history_since(room);
+
     xmpp_ctx_t* ctx = connection_get_ctx();
-    xmpp_stanza_t* presence = stanza_create_room_join_presence(ctx, jid->fulljid, passwd);
+    xmpp_stanza_t* presence = stanza_create_room_join_presence(ctx, jid->fulljid, passwd, since, MUC_HISTORY_MAX_STANZAS);
     stanza_attach_show(ctx, presence, show);
     stanza_attach_status(ctx, presence, status);
     stanza_attach_priority(ctx, presence, pri);
@@ -352,6 +355,7 @@ presence_leave_chat_room(const char* const room_jid)
 static int
 _presence_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata)
 {
+    auto_perf ProfPerfTimer timer = perf_timer_start("xmpp.presence", NULL);
     log_debug("Presence stanza handler fired");
     autoping_timer_extend();
 
@@ -940,3 +944,29 @@ _send_presence_stanza(xmpp_stanza_t* const stanza)
     }
     xmpp_free(connection_get_ctx(), text);
 }
+
+// Only ask the room for what we have not stored yet: everything after the
+// newest message we logged for it, still capped by MUC_HISTORY_MAX_STANZAS.
+// Returns NULL if nothing is stored for the room, in which case only the cap
+// applies.
+static gchar*
+_room_history_since(const char* const room)
+{
+    ProfMessage* last = log_database_get_limits_info(room, TRUE);
+    if (!last) {
+        return NULL;
+    }
+
+    gchar* since = NULL;
+    if (last->timestamp) {
+        // "since" is inclusive, step past the stored message so it isn't replayed
+        GDateTime* after = g_date_time_add(last->timestamp, 1);
+        GDateTime* utc = g_date_time_to_utc(after);
+        since = g_date_time_format(utc, "%FT%T.%fZ");
+        g_date_time_unref(utc);
+        g_date_time_unref(after);
+    }
+    message_free(last);
+
+    return since;
+}
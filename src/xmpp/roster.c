@@ -45,6 +45,8 @@
 
 #include "profanity.h"
 #include "log.h"
+#include "common.h"
+#include "config/files.h"
 #include "config/preferences.h"
 #include "plugins/plugins.h"
 #include "event/server_events.h"
@@ -66,16 +68,43 @@ typedef struct _group_data
     char* group;
 } GroupData;
 
+// group holding the roster version, not a valid jid so it can't clash with a contact
+#define ROSTER_CACHE_META "@roster"
+// seconds to wait before writing roster pushes to disk
+#define ROSTER_CACHE_SAVE_DELAY 10
+
+static prof_keyfile_t roster_cache;
+static guint roster_cache_timer;
+
 // id handlers
 static int _group_add_id_handler(xmpp_stanza_t* const stanza, void* const userdata);
 static int _group_remove_id_handler(xmpp_stanza_t* const stanza, void* const userdata);
 static void _free_group_data(GroupData* data);
 
+static gchar* _roster_cache_load(void);
+static void _roster_cache_set_item(const char* const barejid, const char* const name, GSList* groups,
+                                   const char* const subscription, gboolean pending_out);
+static void _roster_cache_set_ver(xmpp_stanza_t* const query);
+static void _roster_cache_schedule_save(void);
+
 void
 roster_request(void)
 {
+    // populate the roster from the cache right away, the server only sends changes
+    auto_gchar gchar* ver = _roster_cache_load();
+    if (ver && prefs_get_boolean(PREF_ROSTER)) {
+        ui_show_roster();
+    }
+
+    // XEP-0237: the cached version may only be sent if the server announced roster versioning
+    if (ver && !connection_has_stream_feature(STANZA_NS_ROSTERVER)) {
+        log_debug("Server doesn't support roster versioning, requesting the full roster");
+        g_free(ver);
+        ver = NULL;
+    }
+
     xmpp_ctx_t* const ctx = connection_get_ctx();
-    xmpp_stanza_t* iq = stanza_create_roster_iq(ctx);
+    xmpp_stanza_t* iq = stanza_create_roster_iq(ctx, ver);
     iq_send_stanza(iq);
     xmpp_stanza_release(iq);
 }
@@ -226,6 +255,10 @@ roster_set_handler(xmpp_stanza_t* const stanza)
         roster_remove(name, barejid_lower);
         ui_roster_remove(barejid_lower);
 
+        if (roster_cache.keyfile) {
+            g_key_file_remove_group(roster_cache.keyfile, barejid_lower, NULL);
+        }
+
         // otherwise update local roster
     } else {
 
@@ -236,6 +269,7 @@ roster_set_handler(xmpp_stanza_t* const stanza)
         }
 
         GSList* groups = roster_get_groups_from_item(item);
+        _roster_cache_set_item(barejid_lower, name, groups, sub, pending_out);
 
         // update the local roster
         PContact contact = roster_get_contact(barejid_lower);
@@ -249,6 +283,9 @@ roster_set_handler(xmpp_stanza_t* const stanza)
         }
     }
 
+    _roster_cache_set_ver(query);
+    _roster_cache_schedule_save();
+
     return;
 }
 
@@ -263,6 +300,21 @@ roster_result_handler(xmpp_stanza_t* const stanza)
 
     // handle initial roster response
     xmpp_stanza_t* query = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_QUERY);
+
+    // roster unchanged since the cached version, pushes for any changes follow
+    if (query == NULL) {
+        log_debug("Roster cache is up to date");
+        sv_ev_roster_received();
+        return;
+    }
+
+    // full roster, replaces anything loaded from the cache
+    roster_clear();
+    if (roster_cache.keyfile) {
+        g_key_file_free(roster_cache.keyfile);
+        roster_cache.keyfile = g_key_file_new();
+    }
+
     xmpp_stanza_t* item = xmpp_stanza_get_children(query);
 
     while (item) {
@@ -282,6 +334,7 @@ roster_result_handler(xmpp_stanza_t* const stanza)
         }
 
         GSList* groups = roster_get_groups_from_item(item);
+        _roster_cache_set_item(barejid_lower, name, groups, sub, pending_out);
 
         gboolean added = roster_add(barejid_lower, name, groups, sub, pending_out);
         if (!added) {
@@ -291,6 +344,11 @@ roster_result_handler(xmpp_stanza_t* const stanza)
         item = xmpp_stanza_get_next(item);
     }
 
+    _roster_cache_set_ver(query);
+    if (roster_cache.keyfile) {
+        save_keyfile(&roster_cache);
+    }
+
     sv_ev_roster_received();
 
     return;
@@ -315,6 +373,132 @@ roster_get_groups_from_item(xmpp_stanza_t* item)
     return groups;
 }
 
+void
+roster_cache_close(void)
+{
+    if (roster_cache_timer) {
+        g_source_remove(roster_cache_timer);
+        roster_cache_timer = 0;
+        if (roster_cache.keyfile) {
+            save_keyfile(&roster_cache);
+        }
+    }
+    free_keyfile(&roster_cache);
+}
+
+// returns the cached version if the cached contacts were added to the roster
+static gchar*
+_roster_cache_load(void)
+{
+    roster_cache_close();
+
+    gchar* filename = files_file_in_account_data_path(DIR_ROSTER, connection_get_barejid(), "roster");
+    if (filename == NULL) {
+        return NULL;
+    }
+    load_custom_keyfile(&roster_cache, filename);
+
+    gchar* ver = g_key_file_get_string(roster_cache.keyfile, ROSTER_CACHE_META, "ver", NULL);
+    if (ver == NULL) {
+        return NULL;
+    }
+
+    gsize num_contacts = 0;
+    auto_gcharv gchar** jids = g_key_file_get_groups(roster_cache.keyfile, &num_contacts);
+    for (gsize i = 0; i < num_contacts; i++) {
+        if (g_strcmp0(jids[i], ROSTER_CACHE_META) == 0) {
+            continue;
+        }
+
+        auto_gchar gchar* name = g_key_file_get_string(roster_cache.keyfile, jids[i], "name", NULL);
+        auto_gchar gchar* sub = g_key_file_get_string(roster_cache.keyfile, jids[i], "subscription", NULL);
+        gboolean pending_out = g_key_file_get_boolean(roster_cache.keyfile, jids[i], "pending_out", NULL);
+
+        gsize groups_len = 0;
+        auto_gcharv gchar** groups_list = g_key_file_get_string_list(roster_cache.keyfile, jids[i], "groups", &groups_len, NULL);
+        GSList* groups = NULL;
+        for (gsize j = 0; j < groups_len; j++) {
+            groups = g_slist_append(groups, strdup(groups_list[j]));
+        }
+
+        roster_add(jids[i], name, groups, sub, pending_out);
+    }
+
+    log_info("Loaded roster version %s from cache", ver);
+
+    return ver;
+}
+
+static void
+_roster_cache_set_item(const char* const barejid, const char* const name, GSList* groups,
+                       const char* const subscription, gboolean pending_out)
+{
+    if (roster_cache.keyfile == NULL) {
+        return;
+    }
+
+    // can't be stored as a group name, fetch the full roster next time instead
+    if (strpbrk(barejid, "[]\n") != NULL) {
+        g_key_file_remove_group(roster_cache.keyfile, ROSTER_CACHE_META, NULL);
+        return;
+    }
+
+    g_key_file_remove_group(roster_cache.keyfile, barejid, NULL);
+
+    if (name) {
+        g_key_file_set_string(roster_cache.keyfile, barejid, "name", name);
+    }
+    if (subscription) {
+        g_key_file_set_string(roster_cache.keyfile, barejid, "subscription", subscription);
+    }
+    g_key_file_set_boolean(roster_cache.keyfile, barejid, "pending_out", pending_out);
+
+    if (groups) {
+        guint num = g_slist_length(groups);
+        const gchar* groups_list[num];
+        guint curr = 0;
+        for (GSList* group = groups; group; group = g_slist_next(group)) {
+            groups_list[curr++] = group->data;
+        }
+        g_key_file_set_string_list(roster_cache.keyfile, barejid, "groups", groups_list, num);
+    }
+}
+
+static void
+_roster_cache_set_ver(xmpp_stanza_t* const query)
+{
+    if (roster_cache.keyfile == NULL) {
+        return;
+    }
+
+    // servers without roster versioning don't send one, keep requesting the full roster
+    const char* ver = xmpp_stanza_get_attribute(query, STANZA_ATTR_VER);
+    if (ver) {
+        g_key_file_set_string(roster_cache.keyfile, ROSTER_CACHE_META, "ver", ver);
+    } else {
+        g_key_file_remove_group(roster_cache.keyfile, ROSTER_CACHE_META, NULL);
+    }
+}
+
+static gboolean
+_roster_cache_save_timeout(gpointer data)
+{
+    roster_cache_timer = 0;
+    if (roster_cache.keyfile) {
+        save_keyfile(&roster_cache);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+_roster_cache_schedule_save(void)
+{
+    if (roster_cache.keyfile && roster_cache_timer == 0) {
+        roster_cache_timer = g_timeout_add_seconds(ROSTER_CACHE_SAVE_DELAY, _roster_cache_save_timeout, NULL);
+    }
+}
+
 static void
 _free_group_data(GroupData* data)
 {
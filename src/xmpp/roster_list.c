@@ -50,7 +50,7 @@
 
 typedef struct prof_roster_t
 {
-    // contacts, indexed on barejid
+    // contacts, indexed on the shared Jid of their lowercased barejid, see jid_bare()
     GHashTable* contacts;
 
     // nicknames
@@ -81,7 +81,6 @@ static ProfRoster* roster = NULL;
 static gboolean roster_received = FALSE;
 static GSList* roster_pending_presence = NULL;
 
-static gboolean _key_equals(void* key1, void* key2);
 static gboolean _datetimes_equal(GDateTime* dt1, GDateTime* dt2);
 static void _replace_name(const char* const current_name, const char* const new_name, const char* const barejid);
 static void _add_name_and_barejid(const char* const name, const char* const barejid);
@@ -92,7 +91,7 @@ roster_create(void)
     assert(roster == NULL);
 
     roster = malloc(sizeof(ProfRoster));
-    roster->contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, g_free, (GDestroyNotify)p_contact_free);
+    roster->contacts = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)p_contact_free);
     roster->name_ac = autocomplete_new();
     roster->barejid_ac = autocomplete_new();
     roster->fulljid_ac = autocomplete_new();
@@ -104,6 +103,20 @@ roster_create(void)
     roster_pending_presence = NULL;
 }
 
+void
+roster_clear(void)
+{
+    assert(roster != NULL);
+
+    g_hash_table_remove_all(roster->contacts);
+    autocomplete_clear(roster->name_ac);
+    autocomplete_clear(roster->barejid_ac);
+    autocomplete_clear(roster->fulljid_ac);
+    g_hash_table_remove_all(roster->name_to_barejid);
+    autocomplete_clear(roster->groups_ac);
+    g_hash_table_remove_all(roster->group_count);
+}
+
 static void
 _pendingPresence_free(ProfPendingPresence* presence)
 {
@@ -177,10 +190,14 @@ roster_get_contact(const char* const barejid)
 {
     assert(roster != NULL);
 
-    auto_gchar gchar* barejidlower = g_utf8_strdown(barejid, -1);
-    PContact contact = g_hash_table_lookup(roster->contacts, barejidlower);
+    // while the contact exists it keeps its Jid alive, so this is a lookup
+    // in the JID table rather than a parse
+    auto_jid Jid* jid = jid_create(barejid);
+    if (!jid || jid->resourcepart) {
+        return NULL;
+    }
 
-    return contact;
+    return g_hash_table_lookup(roster->contacts, jid_bare(jid));
 }
 
 const char*
@@ -233,6 +250,8 @@ roster_contact_offline(const char* const barejid, const char* const resource, co
     }
 }
 
+// Completion resets through autocomplete_reset_all(), this is kept for the
+// unit tests which start a new search on the roster completers directly
 void
 roster_reset_search_attempts(void)
 {
@@ -300,10 +319,10 @@ roster_remove(const char* const name, const char* const barejid)
             }
             curr = g_slist_next(curr);
         }
-    }
 
-    // remove the contact
-    g_hash_table_remove(roster->contacts, barejid);
+        // remove the contact
+        g_hash_table_remove(roster->contacts, jid_bare(p_contact_jid(contact)));
+    }
 }
 
 void
@@ -377,6 +396,10 @@ roster_add(const char* const barejid, const char* const name, GSList* groups, co
     }
 
     contact = p_contact_new(barejid, name, groups, subscription, NULL, pending_out);
+    if (!p_contact_jid(contact)) {
+        p_contact_free(contact);
+        return FALSE;
+    }
 
     // add groups
     GSList* curr_new_group = groups;
@@ -393,7 +416,7 @@ roster_add(const char* const barejid, const char* const name, GSList* groups, co
         curr_new_group = g_slist_next(curr_new_group);
     }
 
-    g_hash_table_insert(roster->contacts, strdup(barejid), contact);
+    g_hash_table_insert(roster->contacts, jid_bare(p_contact_jid(contact)), contact);
     autocomplete_add(roster->barejid_ac, barejid);
     _add_name_and_barejid(name, barejid);
 
@@ -588,15 +611,6 @@ roster_barejid_autocomplete(const char* const search_str, gboolean previous, voi
     return autocomplete_complete(roster->barejid_ac, search_str, TRUE, previous);
 }
 
-static gboolean
-_key_equals(void* key1, void* key2)
-{
-    gchar* str1 = (gchar*)key1;
-    gchar* str2 = (gchar*)key2;
-
-    return (g_strcmp0(str1, str2) == 0);
-}
-
 static gboolean
 _datetimes_equal(GDateTime* dt1, GDateTime* dt2)
 {
@@ -95,6 +95,7 @@ static GTimer* reconnect_timer;
 static activity_state_t activity_state;
 static resource_presence_t saved_presence;
 static char* saved_status;
+static gboolean csi_inactive;
 
 static void _session_free_internals(void);
 static void _session_free_saved_details(void);
@@ -213,7 +214,6 @@ session_disconnect(void)
 
         accounts_set_last_activity(session_get_account_name());
 
-        iq_rooms_cache_clear();
         iq_handlers_clear();
 
         connection_disconnect();
@@ -315,6 +315,9 @@ _receive_mood(xmpp_stanza_t* const stanza, void* const userdata)
 void
 session_login_success(gboolean secured)
 {
+    // every new stream starts out active
+    csi_inactive = FALSE;
+
     chat_sessions_init();
 
     message_handlers_init();
@@ -402,6 +405,28 @@ session_init_activity(void)
     saved_status = NULL;
 }
 
+// XEP-0352, let the server hold back non urgent traffic while nobody is looking
+static void
+_session_check_csi(unsigned long idle_ms, int away_time_ms)
+{
+    gboolean inactive = prefs_get_boolean(PREF_CSI) && (idle_ms >= away_time_ms || !ui_has_terminal_focus());
+    if (inactive == csi_inactive) {
+        return;
+    }
+
+    // XEP-0352 is announced as a stream feature, not in disco#info
+    if (!connection_has_stream_feature(XMPP_FEATURE_CSI)) {
+        return;
+    }
+
+    log_debug("Client state indication: %s", inactive ? "inactive" : "active");
+    csi_inactive = inactive;
+
+    xmpp_stanza_t* csi = stanza_create_csi(connection_get_ctx(), !inactive);
+    xmpp_send(connection_get_conn(), csi);
+    xmpp_stanza_release(csi);
+}
+
 void
 session_check_autoaway(void)
 {
@@ -423,6 +448,8 @@ session_check_autoaway(void)
 
     unsigned long idle_ms = ui_get_idle_time();
 
+    _session_check_csi(idle_ms, away_time_ms);
+
     switch (activity_state) {
     case ACTIVITY_ST_ACTIVE:
         if (idle_ms >= away_time_ms) {
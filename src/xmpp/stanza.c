@@ -54,7 +54,6 @@
 #include "xmpp/connection.h"
 #include "xmpp/form.h"
 #include "xmpp/muc.h"
-#include "database.h"
 
 static void _stanza_add_unique_id(xmpp_stanza_t* stanza);
 static gchar* _stanza_create_sha1_hash(char* str);
@@ -529,7 +528,8 @@ stanza_create_mediated_invite(xmpp_ctx_t* ctx, const char* const room,
 
 xmpp_stanza_t*
 stanza_create_room_join_presence(xmpp_ctx_t* const ctx,
-                                 const char* const full_room_jid, const char* const passwd)
+                                 const char* const full_room_jid, const char* const passwd,
+                                 const char* const since, int maxstanzas)
 {
     xmpp_stanza_t* presence = xmpp_presence_new(ctx);
     xmpp_stanza_set_to(presence, full_room_jid);
@@ -550,6 +550,20 @@ stanza_create_room_join_presence(xmpp_ctx_t* const ctx,
         xmpp_stanza_release(pass);
     }
 
+    if (since || maxstanzas >= 0) {
+        xmpp_stanza_t* history = xmpp_stanza_new(ctx);
+        xmpp_stanza_set_name(history, "history");
+        if (maxstanzas >= 0) {
+            auto_gchar gchar* max = g_strdup_printf("%d", maxstanzas);
+            xmpp_stanza_set_attribute(history, "maxstanzas", max);
+        }
+        if (since) {
+            xmpp_stanza_set_attribute(history, "since", since);
+        }
+        xmpp_stanza_add_child(x, history);
+        xmpp_stanza_release(history);
+    }
+
     xmpp_stanza_add_child(presence, x);
     xmpp_stanza_release(x);
 
@@ -850,13 +864,16 @@ stanza_create_software_version_iq(xmpp_ctx_t* ctx, const char* const fulljid)
 }
 
 xmpp_stanza_t*
-stanza_create_roster_iq(xmpp_ctx_t* ctx)
+stanza_create_roster_iq(xmpp_ctx_t* ctx, const char* const ver)
 {
     xmpp_stanza_t* iq = xmpp_iq_new(ctx, STANZA_TYPE_GET, "roster");
 
     xmpp_stanza_t* query = xmpp_stanza_new(ctx);
     xmpp_stanza_set_name(query, STANZA_NAME_QUERY);
     xmpp_stanza_set_ns(query, XMPP_NS_ROSTER);
+    if (ver) {
+        xmpp_stanza_set_attribute(query, STANZA_ATTR_VER, ver);
+    }
 
     xmpp_stanza_add_child(iq, query);
     xmpp_stanza_release(query);
@@ -864,6 +881,16 @@ stanza_create_roster_iq(xmpp_ctx_t* ctx)
     return iq;
 }
 
+xmpp_stanza_t*
+stanza_create_csi(xmpp_ctx_t* ctx, gboolean active)
+{
+    xmpp_stanza_t* csi = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_name(csi, active ? STANZA_NAME_ACTIVE : STANZA_NAME_INACTIVE);
+    xmpp_stanza_set_ns(csi, XMPP_FEATURE_CSI);
+
+    return csi;
+}
+
 xmpp_stanza_t*
 stanza_create_disco_info_iq(xmpp_ctx_t* ctx, const char* const id, const char* const to,
                             const char* const node)
@@ -952,7 +979,7 @@ stanza_create_caps_query_element(xmpp_ctx_t* ctx)
     xmpp_stanza_set_name(identity, "identity");
     xmpp_stanza_set_attribute(identity, "category", "client");
 
-    ProfAccount* account = accounts_get_account(session_get_account_name());
+    ProfAccount* account = accounts_get_account_snapshot(session_get_account_name());
     gchar* client = account->client;
     bool is_custom_client = client != NULL;
 
@@ -2716,7 +2743,7 @@ _text_stanza(xmpp_ctx_t* ctx, const char* name, const char* text)
 }
 
 xmpp_stanza_t*
-stanza_create_mam_iq(xmpp_ctx_t* ctx, const char* const jid, const char* const startdate, const char* const enddate, const char* const firstid, const char* const lastid)
+stanza_create_mam_iq(xmpp_ctx_t* ctx, const char* const jid, const char* const startdate, const char* const enddate, const char* const firstid, const char* const lastid, int max)
 {
     auto_char char* id = connection_create_stanza_id();
     xmpp_stanza_t* iq = xmpp_iq_new(ctx, STANZA_TYPE_SET, id);
@@ -2725,6 +2752,8 @@ stanza_create_mam_iq(xmpp_ctx_t* ctx, const char* const jid, const char* const s
     xmpp_stanza_t* query = xmpp_stanza_new(ctx);
     xmpp_stanza_set_name(query, STANZA_NAME_QUERY);
     xmpp_stanza_set_ns(query, STANZA_NS_MAM2);
+    // results are tagged with it, so they can be told apart from other queries
+    xmpp_stanza_set_attribute(query, "queryid", id);
 
     xmpp_stanza_t* x = xmpp_stanza_new(ctx);
     xmpp_stanza_set_name(x, STANZA_NAME_X);
@@ -2741,22 +2770,14 @@ stanza_create_mam_iq(xmpp_ctx_t* ctx, const char* const jid, const char* const s
 
     xmpp_stanza_add_child_ex(field_form_type, value_mam, 0);
 
-    // field 'with'
-    xmpp_stanza_t* field_with = xmpp_stanza_new(ctx);
-    xmpp_stanza_set_name(field_with, STANZA_NAME_FIELD);
-    xmpp_stanza_set_attribute(field_with, STANZA_ATTR_VAR, "with");
-
-    xmpp_stanza_t* value_with = _text_stanza(ctx, STANZA_NAME_VALUE, jid);
-
-    xmpp_stanza_add_child_ex(field_with, value_with, 0);
-
     // 4.3.2 set/rsm
     xmpp_stanza_t* set = xmpp_stanza_new(ctx);
     xmpp_stanza_set_name(set, STANZA_TYPE_SET);
     xmpp_stanza_set_ns(set, STANZA_NS_RSM);
 
-    xmpp_stanza_t* max = _text_stanza(ctx, STANZA_NAME_MAX, PROF_STRINGIFY(MESSAGES_TO_RETRIEVE));
-    xmpp_stanza_add_child_ex(set, max, 0);
+    auto_gchar gchar* max_str = g_strdup_printf("%d", max);
+    xmpp_stanza_t* max_st = _text_stanza(ctx, STANZA_NAME_MAX, max_str);
+    xmpp_stanza_add_child_ex(set, max_st, 0);
 
     if (lastid) {
         xmpp_stanza_t* after = _text_stanza(ctx, STANZA_NAME_AFTER, lastid);
@@ -2772,7 +2793,18 @@ stanza_create_mam_iq(xmpp_ctx_t* ctx, const char* const jid, const char* const s
     xmpp_stanza_add_child_ex(iq, query, 0);
     xmpp_stanza_add_child_ex(query, x, 0);
     xmpp_stanza_add_child_ex(x, field_form_type, 0);
-    xmpp_stanza_add_child_ex(x, field_with, 0);
+
+    // field 'with', the whole archive is queried without it
+    if (jid) {
+        xmpp_stanza_t* field_with = xmpp_stanza_new(ctx);
+        xmpp_stanza_set_name(field_with, STANZA_NAME_FIELD);
+        xmpp_stanza_set_attribute(field_with, STANZA_ATTR_VAR, "with");
+
+        xmpp_stanza_t* value_with = _text_stanza(ctx, STANZA_NAME_VALUE, jid);
+
+        xmpp_stanza_add_child_ex(field_with, value_with, 0);
+        xmpp_stanza_add_child_ex(x, field_with, 0);
+    }
 
     // field 'start'
     if (startdate) {
@@ -2802,6 +2834,31 @@ stanza_create_mam_iq(xmpp_ctx_t* ctx, const char* const jid, const char* const s
     return iq;
 }
 
+xmpp_stanza_t*
+stanza_create_disco_items_page_iq(xmpp_ctx_t* ctx, const char* const id, const char* const jid, const char* const after, int max)
+{
+    xmpp_stanza_t* iq = stanza_create_disco_items_iq(ctx, id, jid, NULL);
+    xmpp_stanza_t* query = xmpp_stanza_get_child_by_name(iq, STANZA_NAME_QUERY);
+
+    // XEP-0059 result set management
+    xmpp_stanza_t* set = xmpp_stanza_new(ctx);
+    xmpp_stanza_set_name(set, STANZA_TYPE_SET);
+    xmpp_stanza_set_ns(set, STANZA_NS_RSM);
+
+    auto_gchar gchar* max_str = g_strdup_printf("%d", max);
+    xmpp_stanza_t* max_st = _text_stanza(ctx, STANZA_NAME_MAX, max_str);
+    xmpp_stanza_add_child_ex(set, max_st, 0);
+
+    if (after) {
+        xmpp_stanza_t* after_st = _text_stanza(ctx, STANZA_NAME_AFTER, after);
+        xmpp_stanza_add_child_ex(set, after_st, 0);
+    }
+
+    xmpp_stanza_add_child_ex(query, set, 0);
+
+    return iq;
+}
+
 xmpp_stanza_t*
 stanza_change_password(xmpp_ctx_t* ctx, const char* const user, const char* const password)
 {
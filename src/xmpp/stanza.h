@@ -254,6 +254,7 @@
 #define STANZA_NS_STREAMS                 "http://etherx.jabber.org/streams"
 #define STANZA_NS_XMPP_STREAMS            "urn:ietf:params:xml:ns:xmpp-streams"
 #define STANZA_NS_VCARD                   "vcard-temp"
+#define STANZA_NS_ROSTERVER               "urn:xmpp:features:rosterver"
 
 #define STANZA_DATAFORM_SOFTWARE "urn:xmpp:dataforms:softwareinfo"
 
@@ -305,7 +306,8 @@ xmpp_stanza_t* stanza_attach_origin_id(xmpp_ctx_t* ctx, xmpp_stanza_t* stanza, c
 xmpp_stanza_t* stanza_attach_correction(xmpp_ctx_t* ctx, xmpp_stanza_t* stanza, const char* const replace_id);
 
 xmpp_stanza_t* stanza_create_room_join_presence(xmpp_ctx_t* const ctx,
-                                                const char* const full_room_jid, const char* const passwd);
+                                                const char* const full_room_jid, const char* const passwd,
+                                                const char* const since, int maxstanzas);
 
 xmpp_stanza_t* stanza_create_room_newnick_presence(xmpp_ctx_t* ctx,
                                                    const char* const full_room_jid);
@@ -313,7 +315,8 @@ xmpp_stanza_t* stanza_create_room_newnick_presence(xmpp_ctx_t* ctx,
 xmpp_stanza_t* stanza_create_room_leave_presence(xmpp_ctx_t* ctx,
                                                  const char* const room, const char* const nick);
 
-xmpp_stanza_t* stanza_create_roster_iq(xmpp_ctx_t* ctx);
+xmpp_stanza_t* stanza_create_roster_iq(xmpp_ctx_t* ctx, const char* const ver);
+xmpp_stanza_t* stanza_create_csi(xmpp_ctx_t* ctx, gboolean active);
 xmpp_stanza_t* stanza_create_ping_iq(xmpp_ctx_t* ctx, const char* const target);
 xmpp_stanza_t* stanza_create_disco_info_iq(xmpp_ctx_t* ctx, const char* const id,
                                            const char* const to, const char* const node);
@@ -420,7 +423,8 @@ xmpp_stanza_t* stanza_create_avatar_data_publish_iq(xmpp_ctx_t* ctx, const char*
 xmpp_stanza_t* stanza_create_avatar_metadata_publish_iq(xmpp_ctx_t* ctx, const char* img_data, gsize len, int height, int width);
 xmpp_stanza_t* stanza_disable_avatar_publish_iq(xmpp_ctx_t* ctx);
 xmpp_stanza_t* stanza_create_vcard_request_iq(xmpp_ctx_t* ctx, const char* const jid, const char* const stanza_id);
-xmpp_stanza_t* stanza_create_mam_iq(xmpp_ctx_t* ctx, const char* const jid, const char* const startdate, const char* const enddate, const char* const firstid, const char* const lastid);
+xmpp_stanza_t* stanza_create_mam_iq(xmpp_ctx_t* ctx, const char* const jid, const char* const startdate, const char* const enddate, const char* const firstid, const char* const lastid, int max);
+xmpp_stanza_t* stanza_create_disco_items_page_iq(xmpp_ctx_t* ctx, const char* const id, const char* const jid, const char* const after, int max);
 xmpp_stanza_t* stanza_change_password(xmpp_ctx_t* ctx, const char* const user, const char* const password);
 xmpp_stanza_t* stanza_register_new_account(xmpp_ctx_t* ctx, const char* const user, const char* const password);
 xmpp_stanza_t* stanza_request_voice(xmpp_ctx_t* ctx, const char* const room);
@@ -44,6 +44,7 @@
 #include "config/preferences.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
+#include "xmpp/avatar.h"
 #include "xmpp/connection.h"
 #include "xmpp/iq.h"
 #include "xmpp/stanza.h"
@@ -51,6 +52,9 @@
 // Connected account's vCard
 vCard* vcard_user = NULL;
 
+// Limit for vCard requests waiting for a reply, further ones are queued
+#define VCARD_MAX_INFLIGHT 4
+
 typedef struct
 {
     vCard* vcard;
@@ -60,8 +64,16 @@ typedef struct
     int photo_index;
     gboolean open;
     char* filename;
+
+    // for queued requests
+    char* jid;
+    ProfIqCallback func;
 } _userdata;
 
+static GQueue* vcard_queued = NULL;
+static int vcard_inflight = 0;
+static guint vcard_dispatch_source = 0;
+
 static void
 _free_vcard_element(void* velement)
 {
@@ -82,8 +94,8 @@ _free_vcard_element(void* velement)
                 free(element->photo.extval);
             }
         } else {
-            if (element->photo.data) {
-                g_free(element->photo.data);
+            if (element->photo.b64) {
+                free(element->photo.b64);
             }
             if (element->photo.type) {
                 free(element->photo.type);
@@ -241,9 +253,83 @@ _free_userdata(_userdata* data)
         free(data->filename);
     }
 
+    free(data->jid);
     free(data);
 }
 
+static void
+_vcard_request_send(_userdata* data);
+
+static gboolean
+_vcard_requests_dispatch(gpointer unused)
+{
+    vcard_dispatch_source = 0;
+
+    if (!vcard_queued) {
+        return G_SOURCE_REMOVE;
+    }
+
+    if (connection_get_status() != JABBER_CONNECTED) {
+        g_queue_free_full(vcard_queued, (GDestroyNotify)_free_userdata);
+        vcard_queued = NULL;
+        return G_SOURCE_REMOVE;
+    }
+
+    while (vcard_inflight < VCARD_MAX_INFLIGHT && !g_queue_is_empty(vcard_queued)) {
+        _vcard_request_send(g_queue_pop_head(vcard_queued));
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+// Called when the iq handler of a request is removed, either because the
+// reply arrived or because the connection went away
+static void
+_vcard_request_free(_userdata* data)
+{
+    vcard_inflight--;
+    _free_userdata(data);
+
+    if (vcard_queued && !g_queue_is_empty(vcard_queued) && vcard_dispatch_source == 0) {
+        vcard_dispatch_source = g_idle_add(_vcard_requests_dispatch, NULL);
+    }
+}
+
+static void
+_vcard_request_send(_userdata* data)
+{
+    if (vcard_inflight >= VCARD_MAX_INFLIGHT) {
+        if (!vcard_queued) {
+            vcard_queued = g_queue_new();
+        }
+        g_queue_push_tail(vcard_queued, data);
+        return;
+    }
+
+    auto_char char* id = connection_create_stanza_id();
+    xmpp_stanza_t* iq = stanza_create_vcard_request_iq(connection_get_ctx(), data->jid, id);
+
+    iq_id_handler_add(id, data->func, (ProfIqFreeCallback)_vcard_request_free, data);
+    vcard_inflight++;
+
+    iq_send_stanza(iq);
+    xmpp_stanza_release(iq);
+}
+
+// Size of the data a base64 string decodes to, without decoding it
+static gsize
+_vcard_b64_decoded_length(const char* const b64)
+{
+    gsize chars = 0;
+    for (const char* c = b64; *c; c++) {
+        if (g_ascii_isalnum(*c) || *c == '+' || *c == '/') {
+            chars++;
+        }
+    }
+
+    return chars * 3 / 4;
+}
+
 // Function must be called with <vCard> root element
 gboolean
 vcard_parse(xmpp_stanza_t* vcard_xml, vCard* vcard)
@@ -324,20 +410,18 @@ vcard_parse(xmpp_stanza_t* vcard_xml, vCard* vcard)
                     free(element);
                     continue;
                 }
-                char* photo_base64 = xmpp_stanza_get_text(child_pointer2);
-                if (!photo_base64) {
+                // keep the base64 text, decoding big photos here would block the UI
+                element->photo.b64 = stanza_text_strdup(child_pointer2);
+                if (!element->photo.b64) {
                     free(element);
                     continue;
                 }
-                element->photo.data = g_base64_decode(photo_base64, &element->photo.length);
-                xmpp_free(ctx, photo_base64);
+                element->photo.length = _vcard_b64_decoded_length(element->photo.b64);
 
                 child_pointer2 = xmpp_stanza_get_child_by_name(child_pointer, "TYPE");
                 if (!child_pointer2) {
                     // No TYPE, invalid photo, skipping
-                    if (element->photo.data) {
-                        g_free(element->photo.data);
-                    }
+                    free(element->photo.b64);
                     free(element);
                     continue;
                 }
@@ -757,9 +841,8 @@ vcard_to_xml(xmpp_ctx_t* const ctx, vCard* vcard)
                 xmpp_stanza_t* binval = xmpp_stanza_new(ctx);
                 xmpp_stanza_set_name(binval, "BINVAL");
 
-                auto_gchar gchar* base64 = g_base64_encode(element->photo.data, element->photo.length);
                 xmpp_stanza_t* binval_text = xmpp_stanza_new(ctx);
-                xmpp_stanza_set_text(binval_text, base64);
+                xmpp_stanza_set_text(binval_text, element->photo.b64);
                 xmpp_stanza_add_child(binval, binval_text);
                 xmpp_stanza_release(binval_text);
 
@@ -1210,12 +1293,12 @@ _vcard_print_result(xmpp_stanza_t* const stanza, void* userdata)
 
     xmpp_stanza_t* vcard_xml = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_VCARD);
     if (!vcard_parse(vcard_xml, data->vcard)) {
-        return 1;
+        return 0;
     }
 
     win_show_vcard(data->window, data->vcard);
 
-    return 1;
+    return 0;
 }
 
 void
@@ -1239,14 +1322,10 @@ vcard_print(xmpp_ctx_t* ctx, ProfWin* window, char* jid)
     }
 
     data->window = window;
+    data->jid = jid ? strdup(jid) : NULL;
+    data->func = _vcard_print_result;
 
-    auto_char char* id = connection_create_stanza_id();
-    xmpp_stanza_t* iq = stanza_create_vcard_request_iq(ctx, jid, id);
-
-    iq_id_handler_add(id, _vcard_print_result, (ProfIqFreeCallback)_free_userdata, data);
-
-    iq_send_stanza(iq);
-    xmpp_stanza_release(iq);
+    _vcard_request_send(data);
 }
 
 static int
@@ -1262,7 +1341,7 @@ _vcard_photo_result(xmpp_stanza_t* const stanza, void* userdata)
 
     xmpp_stanza_t* vcard_xml = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_VCARD);
     if (!vcard_parse(vcard_xml, data->vcard)) {
-        return 1;
+        return 0;
     }
 
     if (data->photo_index < 0) {
@@ -1279,17 +1358,17 @@ _vcard_photo_result(xmpp_stanza_t* const stanza, void* userdata)
 
         if (photo == NULL) {
             cons_show_error("No photo was found in vCard");
-            return 1;
+            return 0;
         }
     } else {
         vcard_element_t* element = (vcard_element_t*)g_queue_peek_nth(data->vcard->elements, data->photo_index);
 
         if (element == NULL) {
             cons_show_error("No element was found at index %d", data->photo_index);
-            return 1;
+            return 0;
         } else if (element->type != VCARD_PHOTO) {
             cons_show_error("Element is not a photo");
-            return 1;
+            return 0;
         }
 
         photo = &element->photo;
@@ -1297,7 +1376,7 @@ _vcard_photo_result(xmpp_stanza_t* const stanza, void* userdata)
 
     if (photo->external) {
         cons_show_error("Cannot handle external value: %s", photo->extval);
-        return 1;
+        return 0;
     }
 
     GString* filename;
@@ -1314,7 +1393,7 @@ _vcard_photo_result(xmpp_stanza_t* const stanza, void* userdata)
             if (errmsg) {
                 cons_show_error("Error creating directory %s: %s", filename->str, errmsg);
                 g_string_free(filename, TRUE);
-                return 1;
+                return 0;
             } else {
                 cons_show_error("Unknown error creating directory %s", filename->str);
                 g_string_free(filename, TRUE);
@@ -1338,40 +1417,12 @@ _vcard_photo_result(xmpp_stanza_t* const stanza, void* userdata)
         g_string_append(filename, ".webp");
     }
 
-    GError* err = NULL;
-
-    if (g_file_set_contents(filename->str, (gchar*)photo->data, photo->length, &err) == FALSE) {
-        cons_show_error("Unable to save photo: %s", err->message);
-        g_error_free(err);
-        g_string_free(filename, TRUE);
-        return 1;
-    } else {
-        cons_show("Photo saved as %s", filename->str);
-    }
-
-    if (data->open) {
-        auto_gcharv gchar** argv = NULL;
-        gint argc;
-
-        auto_gchar gchar* cmdtemplate = prefs_get_string(PREF_VCARD_PHOTO_CMD);
-
-        // this makes it work with filenames that contain spaces
-        g_string_prepend(filename, "\"");
-        g_string_append(filename, "\"");
-        auto_char char* cmd = str_replace(cmdtemplate, "%p", filename->str);
-
-        if (g_shell_parse_argv(cmd, &argc, &argv, &err) == FALSE) {
-            cons_show_error("Failed to parse command template");
-        } else {
-            if (!call_external(argv)) {
-                cons_show_error("Unable to execute command");
-            }
-        }
-    }
+    // decoding and writing the photo can take a while, the avatar worker does it off the UI thread
+    avatar_save_vcard_photo(from, photo->b64, filename->str, data->open);
 
     g_string_free(filename, TRUE);
 
-    return 1;
+    return 0;
 }
 
 void
@@ -1396,13 +1447,10 @@ vcard_photo(xmpp_ctx_t* ctx, char* jid, char* filename, int index, gboolean open
         data->filename = strdup(filename);
     }
 
-    auto_char char* id = connection_create_stanza_id();
-    xmpp_stanza_t* iq = stanza_create_vcard_request_iq(ctx, jid, id);
-
-    iq_id_handler_add(id, _vcard_photo_result, (ProfIqFreeCallback)_free_userdata, data);
+    data->jid = jid ? strdup(jid) : NULL;
+    data->func = _vcard_photo_result;
 
-    iq_send_stanza(iq);
-    xmpp_stanza_release(iq);
+    _vcard_request_send(data);
 }
 
 static int
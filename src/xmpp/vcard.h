@@ -71,7 +71,7 @@ typedef struct _vcard_element_photo
     union {
         struct
         {
-            guchar* data;
+            char* b64; // BINVAL as received, decoded only when saved, see avatar_save_vcard_photo()
             char* type;
             gsize length;
         };
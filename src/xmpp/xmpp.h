@@ -66,6 +66,7 @@
 #define XMPP_FEATURE_MAM2                        "urn:xmpp:mam:2"
 #define XMPP_FEATURE_MAM2_EXTENDED               "urn:xmpp:mam:2#extended"
 #define XMPP_FEATURE_SPAM_REPORTING              "urn:xmpp:reporting:1"
+#define XMPP_FEATURE_CSI                         "urn:xmpp:csi:0"
 
 typedef enum {
     JABBER_CONNECTING,
@@ -124,6 +125,8 @@ typedef struct entity_capabilities_t
     DiscoIdentity* identity;
     SoftwareVersion* software_version;
     GSList* features;
+    guint64 known_features; // bitset of interned feature namespaces, see capabilities.c
+    int refcnt;
 } EntityCapabilities;
 
 typedef struct disco_item_t
@@ -230,7 +233,6 @@ bool message_is_sent_by_us(const ProfMessage* const message, bool checkOID);
 void presence_subscription(const char* const jid, const jabber_subscr_t action);
 GList* presence_get_subscription_requests(void);
 gint presence_sub_request_count(void);
-void presence_reset_sub_request_search(void);
 char* presence_sub_request_find(const char* const search_str, gboolean previous, void* context);
 void presence_join_room(const char* const room, const char* const nick, const char* const passwd);
 void presence_change_room_nick(const char* const room, const char* const nick);
@@ -289,7 +291,6 @@ gboolean bookmark_join(const char* jid);
 GList* bookmark_get_list(void);
 Bookmark* bookmark_get_by_jid(const char* jid);
 char* bookmark_find(const char* const search_str, gboolean previous, void* context);
-void bookmark_autocomplete_reset(void);
 gboolean bookmark_exists(const char* const room);
 
 void roster_send_name_change(const char* const barejid, const char* const new_name, GSList* groups);
@@ -302,7 +303,6 @@ GList* blocked_list(void);
 gboolean blocked_add(char* jid, blocked_report reportkind, const char* const message);
 gboolean blocked_remove(char* jid);
 char* blocked_ac_find(const char* const search_str, gboolean previous, void* context);
-void blocked_ac_reset(void);
 
 void form_destroy(DataForm* form);
 void form_set_value(DataForm* form, const char* const tag, char* value);
@@ -316,7 +316,6 @@ gboolean form_field_contains_option(DataForm* form, const char* const tag, char*
 int form_get_value_count(DataForm* form, const char* const tag);
 FormField* form_get_field_by_tag(DataForm* form, const char* const tag);
 Autocomplete form_get_value_ac(DataForm* form, const char* const tag);
-void form_reset_autocompleters(DataForm* form);
 
 void publish_user_mood(const char* const mood, const char* const text);
 
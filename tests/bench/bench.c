@@ -0,0 +1,443 @@
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#ifdef HAVE_NCURSESW_NCURSES_H
+#include <ncursesw/ncurses.h>
+#elif HAVE_NCURSES_H
+#include <ncurses.h>
+#elif HAVE_CURSES_H
+#include <curses.h>
+#endif
+
+#include "common.h"
+#include "config/preferences.h"
+#include "config/theme.h"
+#include "tools/autocomplete.h"
+#include "tools/parser.h"
+#include "ui/buffer.h"
+#include "xmpp/jid.h"
+#include "xmpp/muc.h"
+#include "xmpp/roster_list.h"
+
+// Each benchmark is run at every size until it used up BENCH_MIN_NS, the ones
+// with an expensive setup repeat the measured operation themselves. Results
+// are printed one JSON object per line:
+// {"bench":"jid_create","size":1000,"iterations":12,"ns_per_op":812.4,"allocs_per_op":9.00}
+#define BENCH_MIN_NS 200000000LL
+
+typedef struct bench_result_t
+{
+    gint64 ns;
+    gint64 allocs;
+    gint64 ops;
+} BenchResult;
+
+typedef struct bench_t
+{
+    const char* name;
+    void (*run)(size_t size, BenchResult* result);
+} Bench;
+
+static size_t default_sizes[] = { 10, 1000, 10000, 100000 };
+
+static gint64 alloc_count = 0;
+static gboolean have_curses = FALSE;
+
+// Allocations are counted by wrapping the allocator, glib allocates through it too
+#ifdef __GLIBC__
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+void*
+malloc(size_t size)
+{
+    alloc_count++;
+    return __libc_malloc(size);
+}
+
+void*
+calloc(size_t nmemb, size_t size)
+{
+    alloc_count++;
+    return __libc_calloc(nmemb, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+    alloc_count++;
+    return __libc_realloc(ptr, size);
+}
+#define ALLOCS_COUNTED TRUE
+#else
+#define ALLOCS_COUNTED FALSE
+#endif
+
+static struct timespec timer_start;
+static gint64 timer_allocs;
+
+static void
+_timer_start(void)
+{
+    timer_allocs = alloc_count;
+    clock_gettime(CLOCK_MONOTONIC, &timer_start);
+}
+
+static void
+_timer_stop(BenchResult* result, gint64 ops)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    result->allocs += alloc_count - timer_allocs;
+    result->ns += (now.tv_sec - timer_start.tv_sec) * 1000000000LL + (now.tv_nsec - timer_start.tv_nsec);
+    result->ops += ops;
+}
+
+static gchar**
+_make_items(const char* const format, size_t size)
+{
+    gchar** items = g_new0(gchar*, size + 1);
+    for (size_t i = 0; i < size; i++) {
+        // spread the items so sorted inserts don't always hit the end of lists
+        items[i] = g_strdup_printf(format, (i * 7919) % size);
+    }
+
+    return items;
+}
+
+static void
+_bench_autocomplete_add(size_t size, BenchResult* result)
+{
+    auto_gcharv gchar** items = _make_items("item%07zu", size);
+    Autocomplete ac = autocomplete_new();
+
+    _timer_start();
+    for (size_t i = 0; i < size; i++) {
+        autocomplete_add(ac, items[i]);
+    }
+    _timer_stop(result, size);
+
+    autocomplete_free(ac);
+}
+
+static void
+_bench_autocomplete_complete(size_t size, BenchResult* result)
+{
+    auto_gcharv gchar** items = _make_items("item%07zu", size);
+    Autocomplete ac = autocomplete_new();
+    for (size_t i = 0; i < size; i++) {
+        autocomplete_add(ac, items[i]);
+    }
+    // a fresh search for the last item walks the whole list
+    auto_gchar gchar* search = g_strdup_printf("item%07zu", size - 1);
+
+    do {
+        _timer_start();
+        autocomplete_reset(ac);
+        gchar* found = autocomplete_complete(ac, search, TRUE, FALSE);
+        _timer_stop(result, 1);
+        g_free(found);
+    } while (result->ns < BENCH_MIN_NS);
+
+    autocomplete_free(ac);
+}
+
+static void
+_bench_buffer_append(size_t size, BenchResult* result)
+{
+    GDateTime* time = g_date_time_new_now_local();
+    ProfBuff buffer = buffer_create();
+
+    _timer_start();
+    for (size_t i = 0; i < size; i++) {
+        buffer_append(buffer, "-", 0, time, 0, THEME_TEXT, "someone", NULL, "a message of a typical length, not too long", NULL, NULL, i, i + 1);
+    }
+    _timer_stop(result, size);
+
+    buffer_free(buffer);
+    g_date_time_unref(time);
+}
+
+static void
+_bench_buffer_get_entry(size_t size, BenchResult* result)
+{
+    GDateTime* time = g_date_time_new_now_local();
+    ProfBuff buffer = buffer_create();
+    for (size_t i = 0; i < size; i++) {
+        buffer_append(buffer, "-", 0, time, 0, THEME_TEXT, "someone", NULL, "a message", NULL, NULL, i, i + 1);
+    }
+    int entries = buffer_size(buffer);
+
+    _timer_start();
+    for (size_t i = 0; i < size; i++) {
+        buffer_get_entry(buffer, i % entries);
+    }
+    _timer_stop(result, size);
+
+    buffer_free(buffer);
+    g_date_time_unref(time);
+}
+
+static void
+_bench_theme_attrs(size_t size, BenchResult* result)
+{
+    if (!have_curses) {
+        return;
+    }
+
+    _timer_start();
+    for (size_t i = 0; i < size; i++) {
+        theme_attrs((theme_item_t)(i % (THEME_TRACKBAR + 1)));
+    }
+    _timer_stop(result, size);
+}
+
+static gchar*
+_make_message(size_t words)
+{
+    GString* message = g_string_new(NULL);
+    for (size_t i = 0; i < words; i++) {
+        g_string_append(message, i % 10 == 0 ? "nick " : "word ");
+    }
+
+    return g_string_free(message, FALSE);
+}
+
+static void
+_bench_prof_occurrences(size_t size, BenchResult* result)
+{
+    auto_gchar gchar* message = _make_message(size);
+
+    _timer_start();
+    GSList* found = NULL;
+    found = prof_occurrences("nick", message, 0, TRUE, &found);
+    _timer_stop(result, 1);
+
+    g_slist_free(found);
+}
+
+static void
+_bench_get_mentions(size_t size, BenchResult* result)
+{
+    auto_gchar gchar* message = _make_message(size);
+
+    _timer_start();
+    GSList* found = get_mentions(TRUE, FALSE, message, "Nick");
+    _timer_stop(result, 1);
+
+    g_slist_free(found);
+}
+
+static void
+_bench_jid_create(size_t size, BenchResult* result)
+{
+    auto_gcharv gchar** items = _make_items("user%zu@example.org/resource", size);
+
+    _timer_start();
+    for (size_t i = 0; i < size; i++) {
+        Jid* jid = jid_create(items[i]);
+        jid_destroy(jid);
+    }
+    _timer_stop(result, size);
+}
+
+static void
+_bench_parse_args(size_t size, BenchResult* result)
+{
+    GString* input = g_string_new("/command");
+    for (size_t i = 0; i < size; i++) {
+        g_string_append(input, i % 2 ? " \"quoted arg\"" : " arg");
+    }
+
+    _timer_start();
+    gboolean res = FALSE;
+    gchar** args = parse_args(input->str, 0, size, &res);
+    _timer_stop(result, 1);
+
+    g_strfreev(args);
+    g_string_free(input, TRUE);
+}
+
+static void
+_bench_roster_get_contacts(size_t size, BenchResult* result)
+{
+    auto_gcharv gchar** jids = _make_items("contact%zu@example.org", size);
+    auto_gcharv gchar** names = _make_items("Contact %zu", size);
+    roster_create();
+    for (size_t i = 0; i < size; i++) {
+        roster_add(jids[i], names[i], NULL, "both", FALSE);
+    }
+
+    do {
+        _timer_start();
+        GSList* contacts = roster_get_contacts(ROSTER_ORD_NAME);
+        _timer_stop(result, 1);
+        g_slist_free(contacts);
+    } while (result->ns < BENCH_MIN_NS);
+
+    roster_destroy();
+}
+
+static void
+_bench_muc_roster(size_t size, BenchResult* result)
+{
+    auto_gcharv gchar** nicks = _make_items("nick%zu", size);
+    auto_gcharv gchar** jids = _make_items("occupant%zu@example.org/res", size);
+    muc_init();
+    muc_join("room@conference.example.org", "me", NULL, FALSE);
+    for (size_t i = 0; i < size; i++) {
+        muc_roster_add("room@conference.example.org", nicks[i], jids[i], "participant", "none", NULL, NULL);
+    }
+
+    do {
+        _timer_start();
+        GList* occupants = muc_roster("room@conference.example.org");
+        _timer_stop(result, 1);
+        g_list_free(occupants);
+    } while (result->ns < BENCH_MIN_NS);
+
+    muc_close();
+}
+
+static Bench benches[] = {
+    { "autocomplete_add", _bench_autocomplete_add },
+    { "autocomplete_complete", _bench_autocomplete_complete },
+    { "buffer_append", _bench_buffer_append },
+    { "buffer_get_entry", _bench_buffer_get_entry },
+    { "theme_attrs", _bench_theme_attrs },
+    { "prof_occurrences", _bench_prof_occurrences },
+    { "get_mentions", _bench_get_mentions },
+    { "jid_create", _bench_jid_create },
+    { "parse_args", _bench_parse_args },
+    { "roster_get_contacts", _bench_roster_get_contacts },
+    { "muc_roster", _bench_muc_roster },
+};
+
+static void
+_run(Bench* bench, size_t size)
+{
+    BenchResult result = { 0, 0, 0 };
+    int iterations = 0;
+
+    while (result.ns < BENCH_MIN_NS) {
+        bench->run(size, &result);
+        iterations++;
+        if (result.ops == 0) {
+            // nothing measured, e.g. no terminal for theme_attrs
+            return;
+        }
+    }
+
+    printf("{\"bench\":\"%s\",\"size\":%zu,\"iterations\":%d,\"ns_per_op\":%.1f,",
+           bench->name, size, iterations, (double)result.ns / result.ops);
+    if (ALLOCS_COUNTED) {
+        printf("\"allocs_per_op\":%.2f}\n", (double)result.allocs / result.ops);
+    } else {
+        printf("\"allocs_per_op\":null}\n");
+    }
+    fflush(stdout);
+}
+
+static void
+_usage(const char* const prog)
+{
+    fprintf(stderr, "Usage: %s [-s size]... [bench]...\n", prog);
+    fprintf(stderr, "Benchmarks:");
+    for (size_t i = 0; i < ARRAY_SIZE(benches); i++) {
+        fprintf(stderr, " %s", benches[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int
+main(int argc, char* argv[])
+{
+    GArray* sizes = g_array_new(FALSE, FALSE, sizeof(size_t));
+    GPtrArray* names = g_ptr_array_new();
+
+    for (int i = 1; i < argc; i++) {
+        if (g_strcmp0(argv[i], "-s") == 0 && i + 1 < argc) {
+            size_t size = strtoul(argv[++i], NULL, 10);
+            if (size == 0) {
+                _usage(argv[0]);
+                return 1;
+            }
+            g_array_append_val(sizes, size);
+        } else if (argv[i][0] == '-') {
+            _usage(argv[0]);
+            return 1;
+        } else {
+            g_ptr_array_add(names, argv[i]);
+        }
+    }
+    if (sizes->len == 0) {
+        g_array_append_vals(sizes, default_sizes, ARRAY_SIZE(default_sizes));
+    }
+
+    // keep preferences and theme lookups away from the user's files
+    auto_gchar gchar* tmpdir = g_dir_make_tmp("profanity-bench-XXXXXX", NULL);
+    if (tmpdir == NULL) {
+        fprintf(stderr, "Could not create a temporary directory\n");
+        return 1;
+    }
+    auto_gchar gchar* config_dir = g_build_filename(tmpdir, "profanity", NULL);
+    auto_gchar gchar* profrc = g_build_filename(config_dir, "profrc", NULL);
+    g_mkdir(config_dir, 0700);
+    g_file_set_contents(profrc, "", 0, NULL);
+    g_setenv("XDG_CONFIG_HOME", tmpdir, TRUE);
+    g_setenv("XDG_DATA_HOME", tmpdir, TRUE);
+    prefs_load(NULL);
+
+    // theme_attrs() allocates colour pairs, render into a terminal nobody sees
+    FILE* devnull = fopen("/dev/null", "r+");
+    SCREEN* screen = NULL;
+    if (devnull) {
+        screen = newterm(getenv("TERM") ? NULL : "xterm", devnull, devnull);
+    }
+    if (screen) {
+        start_color();
+        use_default_colors();
+        have_curses = TRUE;
+    } else {
+        fprintf(stderr, "No terminal available, skipping theme_attrs\n");
+    }
+    theme_init(NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(benches); i++) {
+        gboolean selected = names->len == 0;
+        for (guint j = 0; j < names->len && !selected; j++) {
+            selected = g_strcmp0(g_ptr_array_index(names, j), benches[i].name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+
+        for (guint j = 0; j < sizes->len; j++) {
+            _run(&benches[i], g_array_index(sizes, size_t, j));
+        }
+    }
+
+    theme_close();
+    if (screen) {
+        endwin();
+        delscreen(screen);
+    }
+    if (devnull) {
+        fclose(devnull);
+    }
+    prefs_close();
+    g_remove(profrc);
+    g_rmdir(config_dir);
+    g_rmdir(tmpdir);
+    g_array_free(sizes, TRUE);
+    g_ptr_array_free(names, TRUE);
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <sys/resource.h>
+#include <glib.h>
+
+#include <stabber.h>
+#include <expect.h>
+
+#include "config.h"
+
+#include "proftest.h"
+
+/*
+ * Load scenarios, each one floods a freshly started profanity from stabber
+ * and reports one JSON object per line:
+ *
+ * {"scenario":"roster_5k","wall_ms":1234,"peak_rss_kb":56789,"user_cpu_ms":800,"sys_cpu_ms":120}
+ *
+ * wall_ms runs from the start of the flood until profanity answered a ping
+ * sent after it. peak_rss_kb and the cpu times cover the whole process,
+ * including start up and login, compare them against the baseline scenario.
+ */
+
+#define LOAD_TIMEOUT 600
+
+#define PROF_LOAD_TEST(test) cmocka_unit_test_setup_teardown(test, init_prof_test, close_load_test)
+
+static const char *scenario = NULL;
+static gint64 wall_us = 0;
+
+static void
+load_start(const char *name)
+{
+    scenario = name;
+    wall_us = g_get_monotonic_time();
+}
+
+static void
+load_done(void)
+{
+    assert_true(prof_sync(LOAD_TIMEOUT));
+    wall_us = g_get_monotonic_time() - wall_us;
+}
+
+static long
+timeval_ms(struct timeval *tv)
+{
+    return tv->tv_sec * 1000 + tv->tv_usec / 1000;
+}
+
+static int
+close_load_test(void **state)
+{
+    struct rusage usage;
+    prof_quit(&usage);
+
+    if (scenario) {
+        printf("{\"scenario\":\"%s\",\"wall_ms\":%" G_GINT64_FORMAT ",\"peak_rss_kb\":%ld,\"user_cpu_ms\":%ld,\"sys_cpu_ms\":%ld}\n",
+            scenario, wall_us / 1000, usage.ru_maxrss, timeval_ms(&usage.ru_utime), timeval_ms(&usage.ru_stime));
+        fflush(stdout);
+    }
+    scenario = NULL;
+
+    return 0;
+}
+
+static gchar *
+roster_items(int count)
+{
+    GString *items = g_string_new(NULL);
+    for (int i = 0; i < count; i++) {
+        g_string_append_printf(items, "<item jid='contact%d@localhost' subscription='both' name='Contact %d'>", i, i);
+        g_string_append_printf(items, "<group>Group %d</group>", i % 20);
+        g_string_append(items, "</item>");
+    }
+
+    return g_string_free(items, FALSE);
+}
+
+void
+load_baseline(void **state)
+{
+    load_start("baseline");
+    prof_connect();
+    load_done();
+}
+
+void
+load_roster_5k(void **state)
+{
+    gchar *items = roster_items(5000);
+
+    load_start("roster_5k");
+    prof_connect_with_roster(items);
+    load_done();
+
+    g_free(items);
+}
+
+void
+load_muc_join_3k(void **state)
+{
+    prof_connect();
+
+    // occupants are sent before the self presence, like a server does on join
+    GString *presences = g_string_new(NULL);
+    for (int i = 0; i < 3000; i++) {
+        g_string_append_printf(presences,
+            "<presence to='stabber@localhost/profanity' from='loadroom@conference.localhost/occupant%d'>"
+                "<x xmlns='http://jabber.org/protocol/muc#user'>"
+                    "<item role='participant' jid='occupant%d@localhost/res' affiliation='member'/>"
+                "</x>"
+            "</presence>", i, i);
+    }
+    g_string_append(presences,
+        "<presence id='prof_join_4' lang='en' to='stabber@localhost/profanity' from='loadroom@conference.localhost/stabber'>"
+            "<x xmlns='http://jabber.org/protocol/muc#user'>"
+                "<item role='participant' jid='stabber@localhost/profanity' affiliation='none'/>"
+            "</x>"
+            "<status code='110'/>"
+        "</presence>");
+    stbbr_for_id("prof_join_4", presences->str);
+
+    prof_timeout(LOAD_TIMEOUT);
+    load_start("muc_join_3k");
+    prof_input("/join loadroom@conference.localhost");
+    assert_true(prof_output_exact("-> You have joined the room as stabber, role: participant, affiliation: none"));
+    load_done();
+    prof_timeout_reset();
+
+    g_string_free(presences, TRUE);
+}
+
+void
+load_mam_10k(void **state)
+{
+    prof_connect();
+    prof_input("/msg buddy1@localhost");
+
+    load_start("mam_10k");
+    for (int i = 0; i < 10000; i++) {
+        gchar *message = g_strdup_printf(
+            "<message to='stabber@localhost/profanity' from='stabber@localhost'>"
+                "<result xmlns='urn:xmpp:mam:2' queryid='loadquery' id='mam%d'>"
+                    "<forwarded xmlns='urn:xmpp:forward:0'>"
+                        "<delay xmlns='urn:xmpp:delay' stamp='2020-01-01T%02d:%02d:%02dZ'/>"
+                        "<message xmlns='jabber:client' type='chat' id='archived%d' from='buddy1@localhost/mobile' to='stabber@localhost/profanity'>"
+                            "<body>archived message number %d</body>"
+                        "</message>"
+                    "</forwarded>"
+                "</result>"
+            "</message>", i, (i / 3600) % 24, (i / 60) % 60, i % 60, i, i);
+        stbbr_send(message);
+        g_free(message);
+    }
+    load_done();
+}
+
+void
+load_receipt_storm_10k(void **state)
+{
+    prof_connect();
+    prof_input("/msg buddy1@localhost");
+
+    load_start("receipt_storm_10k");
+    for (int i = 0; i < 10000; i++) {
+        gchar *receipt = g_strdup_printf(
+            "<message to='stabber@localhost/profanity' from='buddy1@localhost/mobile' id='receipt%d'>"
+                "<received xmlns='urn:xmpp:receipts' id='sent%d'/>"
+            "</message>", i, i);
+        stbbr_send(receipt);
+        g_free(receipt);
+    }
+    load_done();
+}
+
+void
+load_presence_churn_20k(void **state)
+{
+    gchar *items = roster_items(1000);
+    prof_connect_with_roster(items);
+    g_free(items);
+
+    static const char *shows[] = { "", "<show>away</show>", "<show>dnd</show>", "<show>xa</show>" };
+
+    load_start("presence_churn_20k");
+    for (int i = 0; i < 20000; i++) {
+        gchar *presence;
+        if (i % 5 == 4) {
+            presence = g_strdup_printf(
+                "<presence to='stabber@localhost/profanity' from='contact%d@localhost/res%d' type='unavailable'/>",
+                i % 1000, i % 3);
+        } else {
+            presence = g_strdup_printf(
+                "<presence to='stabber@localhost/profanity' from='contact%d@localhost/res%d'>"
+                    "%s<status>status %d</status><priority>%d</priority>"
+                "</presence>",
+                i % 1000, i % 3, shows[i % 4], i, i % 10);
+        }
+        stbbr_send(presence);
+        g_free(presence);
+    }
+    load_done();
+}
+
+int
+main(int argc, char* argv[])
+{
+    const struct CMUnitTest all_tests[] = {
+        PROF_LOAD_TEST(load_baseline),
+        PROF_LOAD_TEST(load_roster_5k),
+        PROF_LOAD_TEST(load_muc_join_3k),
+        PROF_LOAD_TEST(load_mam_10k),
+        PROF_LOAD_TEST(load_receipt_storm_10k),
+        PROF_LOAD_TEST(load_presence_churn_20k),
+    };
+
+    return cmocka_run_group_tests(all_tests, NULL, NULL);
+}
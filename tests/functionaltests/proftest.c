@@ -1,5 +1,6 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <glib.h>
 
 #include <setjmp.h>
@@ -195,16 +196,26 @@ init_prof_test(void **state)
 
 int
 close_prof_test(void **state)
+{
+    prof_quit(NULL);
+    return 0;
+}
+
+/*
+ * Quit profanity and clean up, usage receives the resources used by the
+ * profanity process when not NULL.
+ */
+void
+prof_quit(struct rusage *usage)
 {
     prof_input("/quit");
-    waitpid(exp_pid, NULL, 0);
+    wait4(exp_pid, NULL, 0, usage);
     _cleanup_dirs();
 
     setenv("XDG_CONFIG_HOME", config_orig, 1);
     setenv("XDG_DATA_HOME", data_orig, 1);
 
     stbbr_stop();
-    return 0;
 }
 
 void
@@ -216,6 +227,40 @@ prof_input(const char *input)
     g_string_free(inp_str, TRUE);
 }
 
+/*
+ * Ping profanity from the server and wait for the answer, everything the
+ * server sent before has been handled once it arrives.
+ * Returns 1 on success and 0 if no answer arrived within timeout seconds.
+ */
+int
+prof_sync(int timeout)
+{
+    static int sync_count = 0;
+    sync_count++;
+
+    gchar *ping = g_strdup_printf(
+        "<iq id='prof_sync_%d' type='get' to='stabber@localhost/profanity' from='localhost'>"
+            "<ping xmlns='urn:xmpp:ping'/>"
+        "</iq>", sync_count);
+    gchar *pong = g_strdup_printf(
+        "<iq id='prof_sync_%d' type='result' from='stabber@localhost/profanity' to='localhost'/>", sync_count);
+
+    stbbr_send(ping);
+
+    gint64 deadline = g_get_monotonic_time() + (gint64)timeout * G_USEC_PER_SEC;
+    int result = stbbr_received(pong);
+    while (!result && g_get_monotonic_time() < deadline) {
+        // don't compete for the CPU with the profanity being measured
+        g_usleep(1000);
+        result = stbbr_received(pong);
+    }
+
+    g_free(ping);
+    g_free(pong);
+
+    return result;
+}
+
 int
 prof_output_exact(const char *text)
 {
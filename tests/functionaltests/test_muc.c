@@ -20,7 +20,9 @@ sends_room_join(void **state)
 
     assert_true(stbbr_last_received(
         "<presence id='*' to='testroom@conference.localhost/stabber'>"
-            "<x xmlns='http://jabber.org/protocol/muc'/>"
+            "<x xmlns='http://jabber.org/protocol/muc'>"
+                "<history maxstanzas='50'/>"
+            "</x>"
             "<c hash='sha-1' xmlns='http://jabber.org/protocol/caps' ver='*' node='http://profanity-im.github.io'/>"
         "</presence>"
     ));
@@ -35,7 +37,9 @@ sends_room_join_with_nick(void **state)
 
     assert_true(stbbr_last_received(
         "<presence id='*' to='testroom@conference.localhost/testnick'>"
-            "<x xmlns='http://jabber.org/protocol/muc'/>"
+            "<x xmlns='http://jabber.org/protocol/muc'>"
+                "<history maxstanzas='50'/>"
+            "</x>"
             "<c hash='sha-1' xmlns='http://jabber.org/protocol/caps' ver='*' node='http://profanity-im.github.io'/>"
         "</presence>"
     ));
@@ -52,6 +56,7 @@ sends_room_join_with_password(void **state)
         "<presence id='*' to='testroom@conference.localhost/stabber'>"
             "<x xmlns='http://jabber.org/protocol/muc'>"
                 "<password>testpassword</password>"
+                "<history maxstanzas='50'/>"
             "</x>"
             "<c hash='sha-1' xmlns='http://jabber.org/protocol/caps' ver='*' node='http://profanity-im.github.io'/>"
         "</presence>"
@@ -69,6 +74,7 @@ sends_room_join_with_nick_and_password(void **state)
         "<presence id='*' to='testroom@conference.localhost/testnick'>"
             "<x xmlns='http://jabber.org/protocol/muc'>"
                 "<password>testpassword</password>"
+                "<history maxstanzas='50'/>"
             "</x>"
             "<c hash='sha-1' xmlns='http://jabber.org/protocol/caps' ver='*' node='http://profanity-im.github.io'/>"
         "</presence>"
@@ -27,15 +27,6 @@ accounts_find_enabled(const char* const prefix, gboolean previous, void* context
     return NULL;
 }
 
-void
-accounts_reset_all_search(void)
-{
-}
-void
-accounts_reset_enabled_search(void)
-{
-}
-
 void
 accounts_add(const char* jid, const char* altdomain, const int port, const char* const tls_policy, const char* const auth_policy)
 {
@@ -63,6 +54,12 @@ accounts_get_account(const char* const name)
     return mock_ptr_type(ProfAccount*);
 }
 
+ProfAccount*
+accounts_get_account_snapshot(const char* const name)
+{
+    return NULL;
+}
+
 gboolean
 accounts_enable(const char* const name)
 {
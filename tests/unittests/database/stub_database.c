@@ -48,6 +48,10 @@ log_database_add_outgoing_muc_pm(const char* const id, const char* const barejid
 {
 }
 void
+log_database_add_archived(ProfMessage* message)
+{
+}
+void
 log_database_close(void)
 {
 }
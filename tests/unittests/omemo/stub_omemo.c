@@ -1,4 +1,5 @@
 #include <glib.h>
+#include <gcrypt.h>
 
 #include "config/account.h"
 #include "ui/ui.h"
@@ -18,11 +19,6 @@ omemo_fingerprint_autocomplete(const char* const search_str, gboolean previous)
     return NULL;
 }
 
-void
-omemo_fingerprint_autocomplete_reset(void)
-{
-}
-
 char*
 omemo_format_fingerprint(const char* const fingerprint)
 {
@@ -108,11 +104,22 @@ omemo_start_sessions(void)
 {
 }
 
-char*
-omemo_encrypt_file(FILE* in, FILE* out, off_t file_size, int* gcry_res)
+struct omemo_aesgcm_stream_t*
+omemo_encrypt_stream_new(off_t file_size, char** fragment)
 {
     return NULL;
-};
+}
+
+size_t
+omemo_encrypt_stream_read(struct omemo_aesgcm_stream_t* stream, FILE* in, unsigned char* buffer, size_t size, gcry_error_t* gcry_res)
+{
+    return 0;
+}
+
+void
+omemo_aesgcm_stream_free(struct omemo_aesgcm_stream_t* stream)
+{
+}
 void omemo_free(void* a){};
 
 uint32_t
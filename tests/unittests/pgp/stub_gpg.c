@@ -57,6 +57,14 @@ p_gpg_decrypt(const char* const cipher)
     return NULL;
 }
 
+void
+p_gpg_decrypt_async(const char* const cipher, ProfGpgDecryptCallback callback, void* userdata, GDestroyNotify userdata_free)
+{
+    if (userdata_free) {
+        userdata_free(userdata);
+    }
+}
+
 void
 p_gpg_on_connect(const char* const barejid)
 {
@@ -82,11 +90,6 @@ p_gpg_free_keys(GHashTable* keys)
 {
 }
 
-void
-p_gpg_autocomplete_key_reset(void)
-{
-}
-
 char*
 p_gpg_autocomplete_key(const char* const search_str, gboolean previous, void* context)
 {
@@ -232,3 +232,22 @@ complete_previous(void** state)
     free(result3);
     free(result4);
 }
+
+void
+complete_restarts_after_reset_all(void** state)
+{
+    Autocomplete ac = autocomplete_new();
+    autocomplete_add(ac, "MyBuddy1");
+    autocomplete_add(ac, "MyBuddy2");
+
+    char* result1 = autocomplete_complete(ac, "myb", TRUE, FALSE);
+    autocomplete_reset_all();
+    char* result2 = autocomplete_complete(ac, "myb", TRUE, FALSE);
+
+    assert_string_equal("MyBuddy1", result2);
+
+    autocomplete_free(ac);
+
+    free(result1);
+    free(result2);
+}
@@ -14,3 +14,4 @@ void complete_both_with_accented(void** state);
 void complete_both_with_base(void** state);
 void complete_ignores_case(void** state);
 void complete_previous(void** state);
+void complete_restarts_after_reset_all(void** state);
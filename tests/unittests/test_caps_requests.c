@@ -0,0 +1,170 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "xmpp/caps_requests.h"
+
+#define TIMEOUT 30
+
+void
+caps_requests_queues_new_ver(void** state)
+{
+    CapsRequests* requests = caps_requests_new();
+
+    assert_int_equal(CAPS_REQUEST_QUEUED, caps_requests_add(requests, "room@conf.org/bob", "id1", "http://client.org", "ver1", 1));
+
+    CapsRequest* request = caps_requests_next(requests, 8, TIMEOUT, 1);
+    assert_non_null(request);
+    assert_string_equal("ver1", request->ver);
+    assert_string_equal("id1", request->id);
+    assert_string_equal("room@conf.org/bob", request->jids->data);
+    assert_int_equal(1, request->sent);
+    assert_int_equal(1, caps_requests_active(requests));
+    assert_null(caps_requests_next(requests, 8, TIMEOUT, 1));
+
+    caps_requests_free(requests);
+}
+
+void
+caps_requests_dedupes_same_ver(void** state)
+{
+    CapsRequests* requests = caps_requests_new();
+    caps_requests_add(requests, "room@conf.org/bob", "id1", "http://client.org", "ver1", 1);
+
+    assert_int_equal(CAPS_REQUEST_PENDING, caps_requests_add(requests, "room@conf.org/alice", "id2", "http://client.org", "ver1", 1));
+    assert_int_equal(CAPS_REQUEST_PENDING, caps_requests_add(requests, "room@conf.org/bob", "id3", "http://client.org", "ver1", 1));
+
+    CapsRequest* request = caps_requests_get(requests, "ver1");
+    assert_int_equal(2, g_slist_length(request->jids));
+    assert_string_equal("room@conf.org/bob", request->jids->data);
+    assert_string_equal("room@conf.org/alice", request->jids->next->data);
+    assert_string_equal("id1", request->id);
+
+    assert_ptr_equal(request, caps_requests_next(requests, 8, TIMEOUT, 1));
+    assert_null(caps_requests_next(requests, 8, TIMEOUT, 1));
+
+    caps_requests_free(requests);
+}
+
+void
+caps_requests_sends_at_most_max(void** state)
+{
+    CapsRequests* requests = caps_requests_new();
+    caps_requests_add(requests, "room@conf.org/a", "id1", "node", "ver1", 1);
+    caps_requests_add(requests, "room@conf.org/b", "id2", "node", "ver2", 1);
+    caps_requests_add(requests, "room@conf.org/c", "id3", "node", "ver3", 1);
+
+    assert_non_null(caps_requests_next(requests, 2, TIMEOUT, 1));
+    assert_non_null(caps_requests_next(requests, 2, TIMEOUT, 1));
+    assert_null(caps_requests_next(requests, 2, TIMEOUT, 1));
+    assert_int_equal(2, caps_requests_active(requests));
+    assert_int_equal(0, caps_requests_get(requests, "ver3")->sent);
+
+    caps_requests_free(requests);
+}
+
+void
+caps_requests_done_sends_next_queued(void** state)
+{
+    CapsRequests* requests = caps_requests_new();
+    caps_requests_add(requests, "room@conf.org/a", "id1", "node", "ver1", 1);
+    caps_requests_add(requests, "room@conf.org/b", "id2", "node", "ver2", 1);
+    caps_requests_next(requests, 1, TIMEOUT, 1);
+
+    caps_requests_done(requests, "ver1");
+
+    assert_null(caps_requests_get(requests, "ver1"));
+    assert_int_equal(0, caps_requests_active(requests));
+    CapsRequest* request = caps_requests_next(requests, 1, TIMEOUT, 2);
+    assert_non_null(request);
+    assert_string_equal("ver2", request->ver);
+
+    caps_requests_free(requests);
+}
+
+void
+caps_requests_drops_timed_out_when_full(void** state)
+{
+    CapsRequests* requests = caps_requests_new();
+    caps_requests_add(requests, "room@conf.org/a", "id1", "node", "ver1", 1);
+    caps_requests_add(requests, "room@conf.org/b", "id2", "node", "ver2", 1);
+    caps_requests_next(requests, 1, TIMEOUT, 1);
+
+    assert_null(caps_requests_next(requests, 1, TIMEOUT, 1 + TIMEOUT));
+
+    CapsRequest* request = caps_requests_next(requests, 1, TIMEOUT, 2 + TIMEOUT);
+    assert_non_null(request);
+    assert_string_equal("ver2", request->ver);
+    assert_null(caps_requests_get(requests, "ver1"));
+    assert_int_equal(1, caps_requests_active(requests));
+
+    caps_requests_free(requests);
+}
+
+void
+caps_requests_retry_asks_next_jid(void** state)
+{
+    CapsRequests* requests = caps_requests_new();
+    caps_requests_add(requests, "room@conf.org/bob", "id1", "node", "ver1", 1);
+    caps_requests_add(requests, "room@conf.org/alice", "id2", "node", "ver1", 1);
+    caps_requests_next(requests, 8, TIMEOUT, 1);
+
+    CapsRequest* request = caps_requests_retry(requests, "ver1", 5);
+
+    assert_non_null(request);
+    assert_int_equal(1, g_slist_length(request->jids));
+    assert_string_equal("room@conf.org/alice", request->jids->data);
+    assert_int_equal(5, request->sent);
+    assert_int_equal(1, caps_requests_active(requests));
+
+    caps_requests_free(requests);
+}
+
+void
+caps_requests_retry_without_next_jid_is_done(void** state)
+{
+    CapsRequests* requests = caps_requests_new();
+    caps_requests_add(requests, "room@conf.org/bob", "id1", "node", "ver1", 1);
+    caps_requests_next(requests, 8, TIMEOUT, 1);
+
+    assert_null(caps_requests_retry(requests, "ver1", 5));
+    assert_null(caps_requests_get(requests, "ver1"));
+    assert_int_equal(0, caps_requests_active(requests));
+
+    caps_requests_free(requests);
+}
+
+void
+caps_requests_failed_ver_not_queried_again(void** state)
+{
+    CapsRequests* requests = caps_requests_new();
+    caps_requests_add(requests, "room@conf.org/bob", "id1", "node", "ver1", 1);
+    caps_requests_next(requests, 8, TIMEOUT, 1);
+
+    caps_requests_fail(requests, "ver1", 100);
+
+    assert_null(caps_requests_get(requests, "ver1"));
+    assert_int_equal(0, caps_requests_active(requests));
+    assert_int_equal(CAPS_REQUEST_FAILED, caps_requests_add(requests, "room@conf.org/alice", "id2", "node", "ver1", 50));
+    assert_null(caps_requests_next(requests, 8, TIMEOUT, 50));
+
+    caps_requests_free(requests);
+}
+
+void
+caps_requests_failed_ver_queried_after_expiry(void** state)
+{
+    CapsRequests* requests = caps_requests_new();
+    caps_requests_add(requests, "room@conf.org/bob", "id1", "node", "ver1", 1);
+    caps_requests_next(requests, 8, TIMEOUT, 1);
+    caps_requests_fail(requests, "ver1", 100);
+
+    assert_int_equal(CAPS_REQUEST_QUEUED, caps_requests_add(requests, "room@conf.org/alice", "id2", "node", "ver1", 101));
+    assert_non_null(caps_requests_next(requests, 8, TIMEOUT, 101));
+
+    caps_requests_free(requests);
+}
@@ -0,0 +1,9 @@
+void caps_requests_queues_new_ver(void** state);
+void caps_requests_dedupes_same_ver(void** state);
+void caps_requests_sends_at_most_max(void** state);
+void caps_requests_done_sends_next_queued(void** state);
+void caps_requests_drops_timed_out_when_full(void** state);
+void caps_requests_retry_asks_next_jid(void** state);
+void caps_requests_retry_without_next_jid_is_done(void** state);
+void caps_requests_failed_ver_not_queried_again(void** state);
+void caps_requests_failed_ver_queried_after_expiry(void** state);
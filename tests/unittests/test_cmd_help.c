@@ -0,0 +1,76 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "command/cmd_funcs.h"
+#include "command/cmd_defs.h"
+
+static gboolean
+_contains(GList* results, const char* cmd)
+{
+    return g_list_find_custom(results, cmd, (GCompareFunc)g_strcmp0) != NULL;
+}
+
+void
+cmd_search_any_matches_prefix(void** state)
+{
+    GList* results = cmd_search_index_any("bookm");
+
+    assert_true(_contains(results, "/bookmark"));
+
+    g_list_free(results);
+}
+
+void
+cmd_search_any_ranks_by_term_frequency(void** state)
+{
+    GList* results = cmd_search_index_any("bookmark");
+
+    assert_non_null(results);
+    assert_string_equal("/bookmark", results->data);
+
+    g_list_free(results);
+}
+
+void
+cmd_search_any_returns_each_command_once(void** state)
+{
+    GList* results = cmd_search_index_any("bookmark bookmarks join");
+
+    assert_non_null(results);
+    for (GList* curr = results; curr; curr = g_list_next(curr)) {
+        assert_null(g_list_find_custom(g_list_next(curr), curr->data, (GCompareFunc)g_strcmp0));
+    }
+
+    g_list_free(results);
+}
+
+void
+cmd_search_all_requires_every_term(void** state)
+{
+    GList* results = cmd_search_index_all("bookmark ignore");
+
+    assert_true(_contains(results, "/bookmark"));
+    for (GList* curr = results; curr; curr = g_list_next(curr)) {
+        GList* any_bookmark = cmd_search_index_any("bookmark");
+        GList* any_ignore = cmd_search_index_any("ignore");
+        assert_true(_contains(any_bookmark, curr->data));
+        assert_true(_contains(any_ignore, curr->data));
+        g_list_free(any_bookmark);
+        g_list_free(any_ignore);
+    }
+
+    g_list_free(results);
+}
+
+void
+cmd_search_all_returns_null_when_no_match(void** state)
+{
+    GList* results = cmd_search_index_all("bookmark qzxwvyk");
+
+    assert_null(results);
+}
@@ -0,0 +1,5 @@
+void cmd_search_any_matches_prefix(void** state);
+void cmd_search_any_ranks_by_term_frequency(void** state);
+void cmd_search_any_returns_each_command_once(void** state);
+void cmd_search_all_requires_every_term(void** state);
+void cmd_search_all_returns_null_when_no_match(void** state);
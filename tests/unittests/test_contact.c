@@ -429,3 +429,29 @@ contact_available_when_highest_priority_chat(void** state)
 
     p_contact_free(contact);
 }
+
+void
+contact_version_changes_on_presence_and_name(void** state)
+{
+    PContact contact = p_contact_new("bob@server.com", "bob", NULL, NULL,
+                                     "is offline", FALSE);
+    guint version = p_contact_version(contact);
+
+    Resource* resource = resource_new("resource", RESOURCE_ONLINE, NULL, 10);
+    p_contact_set_presence(contact, resource);
+    assert_int_not_equal(version, p_contact_version(contact));
+    version = p_contact_version(contact);
+
+    p_contact_set_name(contact, "robert");
+    assert_int_not_equal(version, p_contact_version(contact));
+    version = p_contact_version(contact);
+
+    p_contact_remove_resource(contact, "resource");
+    assert_int_not_equal(version, p_contact_version(contact));
+    version = p_contact_version(contact);
+
+    p_contact_set_pending_out(contact, TRUE);
+    assert_int_equal(version, p_contact_version(contact));
+
+    p_contact_free(contact);
+}
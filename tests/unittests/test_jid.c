@@ -237,3 +237,49 @@ returns_barejid_when_fulljid_not_exists(void** state)
 
     jid_destroy(jid);
 }
+
+void
+create_same_jid_returns_shared_instance(void** state)
+{
+    Jid* jid1 = jid_create("myuser@mydomain/laptop");
+    Jid* jid2 = jid_create("myuser@mydomain/laptop");
+
+    assert_ptr_equal(jid1, jid2);
+
+    jid_destroy(jid1);
+    assert_string_equal("myuser@mydomain/laptop", jid2->fulljid);
+
+    jid_destroy(jid2);
+}
+
+void
+jids_with_same_bare_part_share_barejid(void** state)
+{
+    Jid* laptop = jid_create("myuser@mydomain/laptop");
+    Jid* phone = jid_create("MyUser@mydomain/phone");
+    Jid* bare = jid_create("myuser@mydomain");
+
+    assert_ptr_equal(laptop->barejid, phone->barejid);
+    assert_ptr_equal(laptop->barejid, bare->barejid);
+
+    jid_destroy(bare);
+    jid_destroy(laptop);
+    assert_string_equal("myuser@mydomain", phone->barejid);
+
+    jid_destroy(phone);
+}
+
+void
+jid_bare_returns_shared_bare_jid(void** state)
+{
+    Jid* full = jid_create("MyUser@mydomain/laptop");
+    Jid* bare = jid_create("myuser@mydomain");
+
+    assert_ptr_equal(bare, jid_bare(full));
+    assert_ptr_equal(bare, jid_bare(bare));
+
+    jid_destroy(bare);
+    assert_string_equal("myuser@mydomain", jid_bare(full)->str);
+
+    jid_destroy(full);
+}
@@ -23,3 +23,6 @@ void create_with_at_and_slash_in_resource(void** state);
 void create_full_with_trailing_slash(void** state);
 void returns_fulljid_when_exists(void** state);
 void returns_barejid_when_fulljid_not_exists(void** state);
+void create_same_jid_returns_shared_instance(void** state);
+void jids_with_same_bare_part_share_barejid(void** state);
+void jid_bare_returns_shared_bare_jid(void** state);
@@ -0,0 +1,115 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "tools/notify_queue.h"
+
+void
+notify_queue_pops_in_order(void** state)
+{
+    NotifyQueue* queue = notify_queue_new(10);
+    notify_queue_push(queue, "chat:bob", "first", 10000, "incoming message");
+    notify_queue_push(queue, "chat:alice", "second", 5000, "Incoming message");
+
+    NotifyRequest* first = notify_queue_pop(queue);
+    NotifyRequest* second = notify_queue_pop(queue);
+
+    assert_string_equal("first", first->message);
+    assert_string_equal("chat:bob", first->key);
+    assert_int_equal(10000, first->timeout);
+    assert_string_equal("second", second->message);
+    assert_string_equal("Incoming message", second->category);
+    assert_int_equal(0, notify_queue_length(queue));
+
+    notify_request_free(first);
+    notify_request_free(second);
+    notify_queue_free(queue);
+}
+
+void
+notify_queue_coalesces_same_key(void** state)
+{
+    NotifyQueue* queue = notify_queue_new(10);
+    notify_queue_push(queue, "room:room@conf.org", "one", 10000, "incoming message");
+    notify_queue_push(queue, "chat:bob", "hello", 10000, "incoming message");
+    notify_queue_push(queue, "room:room@conf.org", "two", 10000, "incoming message");
+    notify_queue_push(queue, "room:room@conf.org", "three", 10000, "incoming message");
+
+    assert_int_equal(2, notify_queue_length(queue));
+
+    NotifyRequest* request = notify_queue_pop(queue);
+
+    assert_string_equal("room:room@conf.org", request->key);
+    assert_string_equal("three", request->message);
+    assert_int_equal(3, request->count);
+
+    notify_request_free(request);
+    notify_queue_free(queue);
+}
+
+void
+notify_queue_does_not_coalesce_without_key(void** state)
+{
+    NotifyQueue* queue = notify_queue_new(10);
+    notify_queue_push(queue, NULL, "one", 10000, "Security alert");
+    notify_queue_push(queue, NULL, "two", 10000, "Security alert");
+
+    assert_int_equal(2, notify_queue_length(queue));
+
+    notify_queue_free(queue);
+}
+
+void
+notify_queue_drops_oldest_when_full(void** state)
+{
+    NotifyQueue* queue = notify_queue_new(2);
+    notify_queue_push(queue, "chat:one", "one", 10000, "incoming message");
+    notify_queue_push(queue, "chat:two", "two", 10000, "incoming message");
+    notify_queue_push(queue, "chat:three", "three", 10000, "incoming message");
+
+    assert_int_equal(2, notify_queue_length(queue));
+
+    // the dropped request no longer coalesces
+    notify_queue_push(queue, "chat:one", "one again", 10000, "incoming message");
+
+    NotifyRequest* request = notify_queue_pop(queue);
+    assert_string_equal("three", request->message);
+    notify_request_free(request);
+
+    request = notify_queue_pop(queue);
+    assert_string_equal("one again", request->message);
+    assert_int_equal(1, request->count);
+    notify_request_free(request);
+
+    notify_queue_free(queue);
+}
+
+void
+notify_queue_pop_returns_null_when_closed(void** state)
+{
+    NotifyQueue* queue = notify_queue_new(10);
+    notify_queue_push(queue, "chat:bob", "hello", 10000, "incoming message");
+
+    notify_queue_close(queue);
+
+    assert_null(notify_queue_pop(queue));
+
+    notify_queue_free(queue);
+}
+
+void
+notify_queue_ignores_push_when_closed(void** state)
+{
+    NotifyQueue* queue = notify_queue_new(10);
+    notify_queue_close(queue);
+
+    notify_queue_push(queue, "chat:bob", "hello", 10000, "incoming message");
+
+    assert_int_equal(0, notify_queue_length(queue));
+
+    notify_queue_free(queue);
+}
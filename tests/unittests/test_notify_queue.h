@@ -0,0 +1,6 @@
+void notify_queue_pops_in_order(void** state);
+void notify_queue_coalesces_same_key(void** state);
+void notify_queue_does_not_coalesce_without_key(void** state);
+void notify_queue_drops_oldest_when_full(void** state);
+void notify_queue_pop_returns_null_when_closed(void** state);
+void notify_queue_ignores_push_when_closed(void** state);
@@ -0,0 +1,163 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "tools/perf.h"
+
+static ProfPerfMetric*
+_find_metric(GList* metrics, const char* const name)
+{
+    for (GList* curr = metrics; curr; curr = g_list_next(curr)) {
+        ProfPerfMetric* metric = curr->data;
+        if (g_strcmp0(metric->name, name) == 0) {
+            return metric;
+        }
+    }
+
+    return NULL;
+}
+
+void
+perf_records_nothing_when_disabled(void** state)
+{
+    perf_record("xmpp.message", NULL, 10);
+    perf_count("loop.iterations", NULL, 1);
+
+    GList* metrics = perf_get_metrics();
+
+    assert_null(metrics);
+
+    perf_close();
+}
+
+void
+perf_records_timer_samples(void** state)
+{
+    perf_set_enabled(TRUE);
+    perf_record("xmpp.message", NULL, 3);
+    perf_record("xmpp.message", NULL, 1);
+    perf_record("xmpp.message", NULL, 100);
+
+    GList* metrics = perf_get_metrics();
+    ProfPerfMetric* metric = _find_metric(metrics, "xmpp.message");
+
+    assert_non_null(metric);
+    assert_true(metric->timed);
+    assert_int_equal(3, metric->count);
+    assert_int_equal(104, metric->total_us);
+    assert_int_equal(1, metric->min_us);
+    assert_int_equal(100, metric->max_us);
+
+    g_list_free(metrics);
+    perf_close();
+}
+
+void
+perf_percentile_returns_bucket_upper_bound(void** state)
+{
+    perf_set_enabled(TRUE);
+    for (int i = 0; i < 10; i++) {
+        perf_record("db.insert", NULL, 5);
+    }
+    perf_record("db.insert", NULL, 1000);
+
+    GList* metrics = perf_get_metrics();
+    ProfPerfMetric* metric = _find_metric(metrics, "db.insert");
+
+    assert_int_equal(7, perf_metric_percentile(metric, 0.50));
+    assert_int_equal(7, perf_metric_percentile(metric, 0.95));
+    assert_int_equal(1000, perf_metric_percentile(metric, 1.0));
+
+    g_list_free(metrics);
+    perf_close();
+}
+
+void
+perf_keeps_details_apart(void** state)
+{
+    perf_set_enabled(TRUE);
+    perf_record("plugin.on_start", "first.py", 10);
+    perf_record("plugin.on_start", "second.py", 20);
+    perf_record("plugin.on_start", "second.py", 20);
+
+    GList* metrics = perf_get_metrics();
+
+    assert_int_equal(2, g_list_length(metrics));
+    assert_int_equal(1, _find_metric(metrics, "plugin.on_start:first.py")->count);
+    assert_int_equal(2, _find_metric(metrics, "plugin.on_start:second.py")->count);
+
+    g_list_free(metrics);
+    perf_close();
+}
+
+void
+perf_counts_counters(void** state)
+{
+    perf_set_enabled(TRUE);
+    perf_count("loop.iterations", NULL, 1);
+    perf_count("loop.iterations", NULL, 4);
+
+    GList* metrics = perf_get_metrics();
+    ProfPerfMetric* metric = _find_metric(metrics, "loop.iterations");
+
+    assert_false(metric->timed);
+    assert_int_equal(5, metric->count);
+    assert_int_equal(0, perf_metric_percentile(metric, 0.50));
+
+    g_list_free(metrics);
+    perf_close();
+}
+
+void
+perf_lists_timers_by_total_before_counters(void** state)
+{
+    perf_set_enabled(TRUE);
+    perf_count("loop.iterations", NULL, 1);
+    perf_record("xmpp.iq", NULL, 10);
+    perf_record("xmpp.presence", NULL, 30);
+
+    GList* metrics = perf_get_metrics();
+
+    assert_string_equal("xmpp.presence", ((ProfPerfMetric*)metrics->data)->name);
+    assert_string_equal("xmpp.iq", ((ProfPerfMetric*)metrics->next->data)->name);
+    assert_string_equal("loop.iterations", ((ProfPerfMetric*)metrics->next->next->data)->name);
+
+    g_list_free(metrics);
+    perf_close();
+}
+
+void
+perf_timer_records_when_out_of_scope(void** state)
+{
+    perf_set_enabled(TRUE);
+    {
+        auto_perf ProfPerfTimer timer = perf_timer_start("loop.ui_update", NULL);
+    }
+
+    GList* metrics = perf_get_metrics();
+    ProfPerfMetric* metric = _find_metric(metrics, "loop.ui_update");
+
+    assert_non_null(metric);
+    assert_int_equal(1, metric->count);
+
+    g_list_free(metrics);
+    perf_close();
+}
+
+void
+perf_reset_clears_metrics(void** state)
+{
+    perf_set_enabled(TRUE);
+    perf_record("xmpp.message", NULL, 3);
+
+    perf_reset();
+    GList* metrics = perf_get_metrics();
+
+    assert_null(metrics);
+
+    perf_close();
+}
@@ -0,0 +1,8 @@
+void perf_records_nothing_when_disabled(void** state);
+void perf_records_timer_samples(void** state);
+void perf_percentile_returns_bucket_upper_bound(void** state);
+void perf_keeps_details_apart(void** state);
+void perf_counts_counters(void** state);
+void perf_lists_timers_by_total_before_counters(void** state);
+void perf_timer_records_when_out_of_scope(void** state);
+void perf_reset_clears_metrics(void** state);
@@ -721,3 +721,40 @@ get_contact_display_name_is_passed_barejid_if_contact_does_not_exist(void** stat
 
     roster_destroy();
 }
+
+void
+clear_removes_contacts_and_groups(void** state)
+{
+    roster_create();
+    GSList* groups = NULL;
+    groups = g_slist_append(groups, strdup("friends"));
+    roster_add("person@server.org", "nickname", groups, NULL, FALSE);
+
+    roster_clear();
+
+    assert_null(roster_get_contact("person@server.org"));
+    GList* groups_res = roster_get_groups();
+    assert_null(groups_res);
+
+    roster_add("person@server.org", NULL, NULL, NULL, FALSE);
+    assert_non_null(roster_get_contact("person@server.org"));
+
+    roster_destroy();
+}
+
+void
+get_contact_finds_contact_by_any_case_of_barejid(void** state)
+{
+    roster_create();
+    roster_add("Person@Server.org", NULL, NULL, NULL, FALSE);
+
+    PContact contact = roster_get_contact("person@server.org");
+    assert_non_null(contact);
+    assert_ptr_equal(contact, roster_get_contact("PERSON@server.org"));
+    assert_string_equal("Person@Server.org", p_contact_barejid(contact));
+
+    roster_remove("Person@Server.org", "person@server.org");
+    assert_null(roster_get_contact("Person@Server.org"));
+
+    roster_destroy();
+}
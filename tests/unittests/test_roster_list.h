@@ -33,3 +33,5 @@ void remove_contact_with_remaining_in_group(void** state);
 void get_contact_display_name(void** state);
 void get_contact_display_name_is_barejid_if_name_is_empty(void** state);
 void get_contact_display_name_is_passed_barejid_if_contact_does_not_exist(void** state);
+void clear_removes_contacts_and_groups(void** state);
+void get_contact_finds_contact_by_any_case_of_barejid(void** state);
@@ -0,0 +1,82 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "common.h"
+#include "tools/xml_pretty.h"
+
+void
+xml_pretty_print_indents_children(void** state)
+{
+    auto_gchar gchar* pretty = xml_pretty_print("<iq type='get'><query xmlns='jabber:iq:roster'><item jid='a@b.c'></item></query></iq>");
+
+    assert_string_equal("<iq type='get'>\n"
+                        "  <query xmlns='jabber:iq:roster'>\n"
+                        "    <item jid='a@b.c'>\n"
+                        "    </item>\n"
+                        "  </query>\n"
+                        "</iq>",
+                        pretty);
+}
+
+void
+xml_pretty_print_keeps_text_on_element_line(void** state)
+{
+    auto_gchar gchar* pretty = xml_pretty_print("<message>\n  <body> hello </body>\n</message>");
+
+    assert_string_equal("<message>\n"
+                        "  <body>hello</body>\n"
+                        "</message>",
+                        pretty);
+}
+
+void
+xml_pretty_print_self_closing_does_not_indent(void** state)
+{
+    auto_gchar gchar* pretty = xml_pretty_print("<?xml version='1.0'?><presence><show/><status>away</status></presence>");
+
+    assert_string_equal("<?xml version='1.0'?>\n"
+                        "<presence>\n"
+                        "  <show/>\n"
+                        "  <status>away</status>\n"
+                        "</presence>",
+                        pretty);
+}
+
+void
+xml_pretty_print_keeps_unterminated_tag(void** state)
+{
+    auto_gchar gchar* pretty = xml_pretty_print("<message><body");
+
+    assert_string_equal("<message><body", pretty);
+}
+
+void
+xml_pretty_truncate_keeps_short_text(void** state)
+{
+    auto_gchar gchar* text = xml_pretty_truncate("<presence/>", 11);
+
+    assert_string_equal("<presence/>", text);
+}
+
+void
+xml_pretty_truncate_cuts_ascii_at_max(void** state)
+{
+    auto_gchar gchar* text = xml_pretty_truncate("<presence/>", 4);
+
+    assert_string_equal("<pre… (7 bytes not shown)", text);
+}
+
+void
+xml_pretty_truncate_does_not_split_multibyte_char(void** state)
+{
+    // "ä" is two bytes, a cut after the first one moves before it
+    auto_gchar gchar* text = xml_pretty_truncate("<b>\xc3\xa4</b>", 4);
+
+    assert_true(g_utf8_validate(text, -1, NULL));
+    assert_string_equal("<b>… (6 bytes not shown)", text);
+}
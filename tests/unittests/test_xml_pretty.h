@@ -0,0 +1,7 @@
+void xml_pretty_print_indents_children(void** state);
+void xml_pretty_print_keeps_text_on_element_line(void** state);
+void xml_pretty_print_self_closing_does_not_indent(void** state);
+void xml_pretty_print_keeps_unterminated_tag(void** state);
+void xml_pretty_truncate_keeps_short_text(void** state);
+void xml_pretty_truncate_cuts_ascii_at_max(void** state);
+void xml_pretty_truncate_does_not_split_multibyte_char(void** state);
@@ -1,8 +1,6 @@
 #ifndef TOOLS_AESGCM_DOWNLOAD_H
 #define TOOLS_AESGCM_DOWNLOAD_H
 
-#include <pthread.h>
-
 typedef struct prof_win_t ProfWin;
 typedef struct http_download_t HTTPDownload;
 
@@ -12,17 +10,13 @@ typedef struct aesgcm_download_t
     char* url;
     char* filename;
     ProfWin* window;
-    pthread_t worker;
-    HTTPDownload* http_dl;
 } AESGCMDownload;
 
-void*
-aesgcm_file_get(void* userdata)
+void
+aesgcm_file_get(AESGCMDownload* download)
 {
-    return NULL;
-};
+}
 
 void aesgcm_download_cancel_processes(ProfWin* window){};
-void aesgcm_download_add_download(AESGCMDownload* download){};
 
 #endif
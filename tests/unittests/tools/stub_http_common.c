@@ -0,0 +1,9 @@
+#ifndef TOOLS_HTTP_COMMON_H
+#define TOOLS_HTTP_COMMON_H
+
+void
+http_transfer_close(void)
+{
+}
+
+#endif
@@ -2,7 +2,6 @@
 #define TOOLS_HTTP_UPLOAD_H
 
 #include <curl/curl.h>
-#include <pthread.h>
 
 // forward -> ui/win_types.h
 typedef struct prof_win_t ProfWin;
@@ -16,14 +15,12 @@ typedef struct http_upload_t
     char* get_url;
     char* put_url;
     ProfWin* window;
-    pthread_t worker;
     int cancel;
 } HTTPUpload;
 
-void*
-http_file_put(void* userdata)
+void
+http_file_put(HTTPUpload* upload)
 {
-    return NULL;
 }
 
 char*
@@ -39,6 +36,5 @@ file_size(int filedes)
 }
 
 void http_upload_cancel_processes(){};
-void http_upload_add_upload(){};
 
 #endif
@@ -144,6 +144,27 @@ ui_reset_idle_time(void)
 {
 }
 
+void
+ui_terminal_focus_reporting(gboolean enabled)
+{
+}
+
+void
+ui_terminal_bracketed_paste(gboolean enabled)
+{
+}
+
+void
+ui_set_terminal_focus(gboolean focused)
+{
+}
+
+gboolean
+ui_has_terminal_focus(void)
+{
+    return TRUE;
+}
+
 ProfChatWin*
 chatwin_new(const char* const barejid)
 {
@@ -244,6 +265,16 @@ xmlwin_show(ProfXMLWin* xmlwin, const char* const msg)
 {
 }
 
+void
+xmlwin_set_filter(ProfXMLWin* xmlwin, const char* const type, const char* const jid)
+{
+}
+
+void
+xmlwin_set_pretty(ProfXMLWin* xmlwin, gboolean pretty)
+{
+}
+
 // ui events
 void
 ui_contact_online(char* barejid, Resource* resource, GDateTime* last_activity)
@@ -1081,6 +1112,10 @@ cons_receipts_setting(void)
 {
 }
 void
+cons_csi_setting(void)
+{
+}
+void
 cons_log_setting(void)
 {
 }
@@ -1109,6 +1144,10 @@ cons_rooms_cache_setting(void)
 {
 }
 void
+cons_caps_setting(void)
+{
+}
+void
 cons_inpblock_setting(void)
 {
 }
@@ -1210,6 +1249,14 @@ void
 status_bar_set_all_inactive(void)
 {
 }
+void
+status_bar_set_progress(const char* const progress)
+{
+}
+void
+status_bar_clear_progress(void)
+{
+}
 
 // roster window
 void
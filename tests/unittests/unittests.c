@@ -38,6 +38,11 @@
 #include "test_form.h"
 #include "test_callbacks.h"
 #include "test_plugins_disco.h"
+#include "test_perf.h"
+#include "test_notify_queue.h"
+#include "test_caps_requests.h"
+#include "test_xml_pretty.h"
+#include "test_cmd_help.h"
 
 int
 main(int argc, char* argv[])
@@ -109,6 +114,7 @@ main(int argc, char* argv[])
         cmocka_unit_test(complete_both_with_base),
         cmocka_unit_test(complete_ignores_case),
         cmocka_unit_test(complete_previous),
+        cmocka_unit_test(complete_restarts_after_reset_all),
 
         cmocka_unit_test(create_jid_from_null_returns_null),
         cmocka_unit_test(create_jid_from_empty_string_returns_null),
@@ -135,6 +141,9 @@ main(int argc, char* argv[])
         cmocka_unit_test(create_full_with_trailing_slash),
         cmocka_unit_test(returns_fulljid_when_exists),
         cmocka_unit_test(returns_barejid_when_fulljid_not_exists),
+        cmocka_unit_test(create_same_jid_returns_shared_instance),
+        cmocka_unit_test(jids_with_same_bare_part_share_barejid),
+        cmocka_unit_test(jid_bare_returns_shared_bare_jid),
 
         cmocka_unit_test(parse_null_returns_null),
         cmocka_unit_test(parse_empty_returns_null),
@@ -222,6 +231,8 @@ main(int argc, char* argv[])
         cmocka_unit_test(get_contact_display_name),
         cmocka_unit_test(get_contact_display_name_is_barejid_if_name_is_empty),
         cmocka_unit_test(get_contact_display_name_is_passed_barejid_if_contact_does_not_exist),
+        cmocka_unit_test(clear_removes_contacts_and_groups),
+        cmocka_unit_test(get_contact_finds_contact_by_any_case_of_barejid),
 
         cmocka_unit_test_setup_teardown(returns_false_when_chat_session_does_not_exist,
                                         init_chat_sessions,
@@ -405,6 +416,7 @@ main(int argc, char* argv[])
         cmocka_unit_test(contact_not_available_when_highest_priority_dnd),
         cmocka_unit_test(contact_available_when_highest_priority_online),
         cmocka_unit_test(contact_available_when_highest_priority_chat),
+        cmocka_unit_test(contact_version_changes_on_presence_and_name),
 
         cmocka_unit_test(cmd_presence_shows_usage_when_bad_subcmd),
         cmocka_unit_test(cmd_presence_shows_usage_when_bad_console_setting),
@@ -633,6 +645,46 @@ main(int argc, char* argv[])
         cmocka_unit_test(does_not_add_duplicate_feature),
         cmocka_unit_test(removes_plugin_features),
         cmocka_unit_test(does_not_remove_feature_when_more_than_one_reference),
+
+        cmocka_unit_test(perf_records_nothing_when_disabled),
+        cmocka_unit_test(perf_records_timer_samples),
+        cmocka_unit_test(perf_percentile_returns_bucket_upper_bound),
+        cmocka_unit_test(perf_keeps_details_apart),
+        cmocka_unit_test(perf_counts_counters),
+        cmocka_unit_test(perf_lists_timers_by_total_before_counters),
+        cmocka_unit_test(perf_timer_records_when_out_of_scope),
+        cmocka_unit_test(perf_reset_clears_metrics),
+
+        cmocka_unit_test(notify_queue_pops_in_order),
+        cmocka_unit_test(notify_queue_coalesces_same_key),
+        cmocka_unit_test(notify_queue_does_not_coalesce_without_key),
+        cmocka_unit_test(notify_queue_drops_oldest_when_full),
+        cmocka_unit_test(notify_queue_pop_returns_null_when_closed),
+        cmocka_unit_test(notify_queue_ignores_push_when_closed),
+
+        cmocka_unit_test(caps_requests_queues_new_ver),
+        cmocka_unit_test(caps_requests_dedupes_same_ver),
+        cmocka_unit_test(caps_requests_sends_at_most_max),
+        cmocka_unit_test(caps_requests_done_sends_next_queued),
+        cmocka_unit_test(caps_requests_drops_timed_out_when_full),
+        cmocka_unit_test(caps_requests_retry_asks_next_jid),
+        cmocka_unit_test(caps_requests_retry_without_next_jid_is_done),
+        cmocka_unit_test(caps_requests_failed_ver_not_queried_again),
+        cmocka_unit_test(caps_requests_failed_ver_queried_after_expiry),
+
+        cmocka_unit_test(xml_pretty_print_indents_children),
+        cmocka_unit_test(xml_pretty_print_keeps_text_on_element_line),
+        cmocka_unit_test(xml_pretty_print_self_closing_does_not_indent),
+        cmocka_unit_test(xml_pretty_print_keeps_unterminated_tag),
+        cmocka_unit_test(xml_pretty_truncate_keeps_short_text),
+        cmocka_unit_test(xml_pretty_truncate_cuts_ascii_at_max),
+        cmocka_unit_test(xml_pretty_truncate_does_not_split_multibyte_char),
+
+        cmocka_unit_test(cmd_search_any_matches_prefix),
+        cmocka_unit_test(cmd_search_any_ranks_by_term_frequency),
+        cmocka_unit_test(cmd_search_any_returns_each_command_once),
+        cmocka_unit_test(cmd_search_all_requires_every_term),
+        cmocka_unit_test(cmd_search_all_returns_null_when_no_match),
     };
 
     return cmocka_run_group_tests(all_tests, NULL, NULL);
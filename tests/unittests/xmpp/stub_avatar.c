@@ -10,6 +10,11 @@ avatar_get_by_nick(const char* nick, gboolean open)
     return TRUE;
 }
 
+void
+avatar_save_vcard_photo(const char* const from, const char* const b64, const char* const filename, gboolean open)
+{
+}
+
 gboolean
 avatar_set(const char* path)
 {
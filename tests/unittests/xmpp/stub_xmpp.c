@@ -273,11 +273,6 @@ presence_sub_request_count(void)
     return 0;
 }
 
-void
-presence_reset_sub_request_search(void)
-{
-}
-
 char*
 presence_sub_request_find(const char* const search_str, gboolean previous, void* context)
 {
@@ -455,6 +450,11 @@ iq_feature_retrieval_complete_handler(void)
 {
 }
 
+void
+iq_mam_sync_start(void)
+{
+}
+
 void
 publish_user_mood(const char* const mood, const char* const text)
 {
@@ -545,11 +545,6 @@ bookmark_find(const char* const search_str, gboolean previous, void* context)
     return NULL;
 }
 
-void
-bookmark_autocomplete_reset(void)
-{
-}
-
 void
 roster_send_name_change(const char* const barejid, const char* const new_name, GSList* groups)
 {
@@ -564,6 +559,11 @@ bookmark_exists(const char* const room)
     return FALSE;
 }
 
+void
+roster_cache_close(void)
+{
+}
+
 void
 roster_send_add_to_group(const char* const group, PContact contact)
 {
@@ -609,8 +609,3 @@ blocked_ac_find(const char* const search_str, gboolean previous, void* context)
 {
     return NULL;
 }
-
-void
-blocked_ac_reset(void)
-{
-}